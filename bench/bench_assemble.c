@@ -0,0 +1,298 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: End-to-end throughput of each assembler pass on generated workloads:
+//
+//    bench_assemble --arch <architecture> [--save <results>] [--compare <results>] <name>=<path>...
+//
+// A path may be a directory, in which case every .asm file in it is assembled
+// in turn and the times are summed. Each pass reports the best of several
+// runs, as lines and megabytes of source per second. Results are saved as
+// tab-separated lines that a later run can compare against, labelled with the
+// architecture, which is also used for files without #architecture.
+//
+// A workload that reports assembly errors would only be timing error paths, so
+// it is left out of the results and the run exits with an error. Passes faster
+// than BENCH_MINIMUM_SECONDS print "-" rather than a rate.
+
+#include <dirent.h>
+#include <time.h>
+
+#define main Assembler_Main
+#include "../src/main.c"
+#undef main
+
+#define BENCH_RUN_COUNT 3
+#define BENCH_MINIMUM_SECONDS 1e-4
+
+// NOTE: Passes and their names are shared with --stats, see stats.c.
+typedef struct {
+   double Seconds[PASS_COUNT];
+   index Bytes;
+   index Lines;
+   int Error_Count;
+} bench_timing;
+
+static void Bench_File(assembler_context *Context, char *Path, char *Output_Path, bench_timing *Timing)
+{
+   // NOTE: The same passes as Assemble_File, timed separately.
+   double Start = Stats_Clock();
+   Context->Error_Count = 0;
+   input_file Input = Open_Input_File(&Context->Arena, Path, true);
+   string Source_Code = Input.Contents;
+   Context->Input_File_Path = From_C_String(Path);
+
+   double Tokenize_Start = Stats_Clock();
+   source_code_lines Lines = Tokenize_Source_Lines(&Context->Arena, &Context->Symbols, Source_Code);
+
+   double Encode_Start = Stats_Clock();
+   Layout_Source_Lines(Context, Lines.Lines, Lines.Count, 0);
+
+   double Relocate_Start = Stats_Clock();
+   Apply_Relocations(Context);
+
+   double Write_Start = Stats_Clock();
+   if(!Write_Output_Image(Context, Output_Path))
+   {
+      Report_Error(0, "Failed to write to output file \"%s\".", Output_Path);
+   }
+   double End = Stats_Clock();
+
+   Timing->Seconds[PASS_READ] += Tokenize_Start - Start;
+   Timing->Seconds[PASS_TOKENIZE] += Encode_Start - Tokenize_Start;
+   Timing->Seconds[PASS_ENCODE] += Relocate_Start - Encode_Start;
+   Timing->Seconds[PASS_RELOCATE] += Write_Start - Relocate_Start;
+   Timing->Seconds[PASS_WRITE] += End - Write_Start;
+   Timing->Bytes += Source_Code.Length;
+   Timing->Lines += Lines.Count;
+   Timing->Error_Count += Context->Error_Count;
+
+   Close_Input_File(&Input);
+   Reset_Context(Context);
+}
+
+static int Compare_Paths(const void *A, const void *B)
+{
+   int Result = strcmp(*(char **)A, *(char **)B);
+   return(Result);
+}
+
+static int List_Workload_Files(char *Path, char ***Result)
+{
+   // NOTE: A directory contributes its .asm files in name order, anything else
+   // is a single file.
+   int Count = 0;
+   *Result = 0;
+
+   DIR *Directory = opendir(Path);
+   if(Directory)
+   {
+      int Capacity = 0;
+      struct dirent *Entry;
+      while((Entry = readdir(Directory)))
+      {
+         if(Has_Suffix(From_C_String(Entry->d_name), S(".asm")))
+         {
+            if(Count == Capacity)
+            {
+               Capacity = (Capacity) ? (Capacity * 2) : 256;
+               *Result = realloc(*Result, Capacity * sizeof(char *));
+            }
+
+            index Length = C_String_Length(Path) + C_String_Length(Entry->d_name) + 2;
+            char *File_Path = malloc(Length);
+            snprintf(File_Path, Length, "%s/%s", Path, Entry->d_name);
+            (*Result)[Count++] = File_Path;
+         }
+      }
+      closedir(Directory);
+
+      qsort(*Result, Count, sizeof(char *), Compare_Paths);
+   }
+   else
+   {
+      *Result = malloc(sizeof(char *));
+      (*Result)[Count++] = Path;
+   }
+
+   return(Count);
+}
+
+static bool Find_Baseline(string Baseline, char *Architecture, char *Workload, char *Pass, double *Megabytes_Per_Second)
+{
+   // NOTE: Lines are "architecture workload pass lines/s MB/s", tab separated.
+   bool Result = false;
+
+   cut Lines = {0};
+   Lines.After = Baseline;
+   while(!Result && Lines.After.Length)
+   {
+      Lines = Cut(Lines.After, '\n');
+
+      cut Fields = Cut(Lines.Before, '\t');
+      if(Equals(Fields.Before, From_C_String(Architecture)))
+      {
+         Fields = Cut(Fields.After, '\t');
+         if(Equals(Fields.Before, From_C_String(Workload)))
+         {
+            Fields = Cut(Fields.After, '\t');
+            if(Equals(Fields.Before, From_C_String(Pass)))
+            {
+               Fields = Cut(Fields.After, '\t');
+               *Megabytes_Per_Second = strtod((char *)Fields.After.Data, 0);
+               Result = true;
+            }
+         }
+      }
+   }
+
+   return(Result);
+}
+
+int main(int Argument_Count, char **Arguments)
+{
+   char *Save_Path = 0;
+   char *Compare_Path = 0;
+   char *Output_Path = "build/bench/output.bin";
+
+   assembler_context Context;
+   Create_Context(&Context);
+   Thread_Context = &Context;
+   char *Architecture_Name = "any";
+
+   string Baseline = {0};
+   FILE *Save_File = 0;
+   int Result = 0;
+
+   printf("%-8s %-14s %-10s %10s %12s %10s %10s\n",
+          "arch", "workload", "pass", "ms", "M lines/s", "MB/s", "vs base");
+
+   for(int Argument_Index = 1; Argument_Index < Argument_Count; ++Argument_Index)
+   {
+      char *Argument = Arguments[Argument_Index];
+      if(strcmp(Argument, "--arch") == 0 && Argument_Index + 1 < Argument_Count)
+      {
+         Options.Architecture = Find_Architecture(From_C_String(Arguments[++Argument_Index]));
+         if(!Options.Architecture)
+         {
+            Report_Error(0, "Unsupported architecture \"%s\".", Arguments[Argument_Index]);
+            return(1);
+         }
+         Prepare_Architecture(Options.Architecture);
+         Context.Architecture = Options.Architecture;
+         Architecture_Name = Options.Architecture->Name;
+      }
+      else if(strcmp(Argument, "--save") == 0 && Argument_Index + 1 < Argument_Count)
+      {
+         Save_Path = Arguments[++Argument_Index];
+         Save_File = fopen(Save_Path, "wb");
+         if(!Save_File)
+         {
+            Report_Error(0, "Failed to create \"%s\".", Save_Path);
+         }
+      }
+      else if(strcmp(Argument, "--compare") == 0 && Argument_Index + 1 < Argument_Count)
+      {
+         // NOTE: A missing baseline just leaves the comparison column empty.
+         Compare_Path = Arguments[++Argument_Index];
+         FILE *File = fopen(Compare_Path, "rb");
+         if(File)
+         {
+            arena Baseline_Arena = Reserve_Arena((index)64 * 1024 * 1024);
+            Baseline = Read_Entire_Stream(&Baseline_Arena, File, Compare_Path);
+            *Allocate(&Baseline_Arena, char, 1) = 0;
+            fclose(File);
+         }
+      }
+      else
+      {
+         // NOTE: Split "name=path" in place.
+         cut Workload = Cut(From_C_String(Argument), '=');
+         if(!Workload.Found)
+         {
+            Report_Error(0, "Expected <name>=<path>, got \"%s\".", Argument);
+            return(1);
+         }
+         Argument[Workload.Before.Length] = 0;
+         char *Workload_Name = Argument;
+         char *Workload_Path = (char *)Workload.After.Data;
+
+         char **Paths;
+         int Path_Count = List_Workload_Files(Workload_Path, &Paths);
+
+         bench_timing Best = {0};
+         for(int Run_Index = 0; !Best.Error_Count && Run_Index < BENCH_RUN_COUNT; ++Run_Index)
+         {
+            bench_timing Timing = {0};
+            for(int Path_Index = 0; Path_Index < Path_Count; ++Path_Index)
+            {
+               Bench_File(&Context, Paths[Path_Index], Output_Path, &Timing);
+            }
+
+            for(int Pass = 0; Pass < PASS_COUNT; ++Pass)
+            {
+               if(Run_Index == 0 || Timing.Seconds[Pass] < Best.Seconds[Pass])
+               {
+                  Best.Seconds[Pass] = Timing.Seconds[Pass];
+               }
+            }
+            Best.Bytes = Timing.Bytes;
+            Best.Lines = Timing.Lines;
+            Best.Error_Count = Timing.Error_Count;
+         }
+
+         if(Best.Error_Count)
+         {
+            Report_Error(0, "Workload \"%s\" reported %d errors, leaving it out of the results.",
+                         Workload_Name, Best.Error_Count);
+            Result = 1;
+         }
+
+         for(int Pass = 0; !Best.Error_Count && Pass < PASS_COUNT; ++Pass)
+         {
+            double Elapsed = Best.Seconds[Pass];
+            bool Measurable = (Elapsed >= BENCH_MINIMUM_SECONDS);
+            double Lines_Per_Second = (Measurable) ? (Best.Lines / Elapsed) : 0;
+            double Megabytes_Per_Second = (Measurable) ? (Best.Bytes / (Elapsed * 1024.0 * 1024.0)) : 0;
+
+            char Comparison[32] = "";
+            double Baseline_Megabytes_Per_Second;
+            if(Measurable &&
+               Find_Baseline(Baseline, Architecture_Name, Workload_Name, Pass_Names[Pass], &Baseline_Megabytes_Per_Second) &&
+               Baseline_Megabytes_Per_Second > 0)
+            {
+               double Change = (Megabytes_Per_Second / Baseline_Megabytes_Per_Second - 1.0) * 100.0;
+               snprintf(Comparison, sizeof(Comparison), "%+.1f%%", Change);
+            }
+
+            if(Measurable)
+            {
+               printf("%-8s %-14s %-10s %10.2f %12.2f %10.1f %10s\n", Architecture_Name, Workload_Name,
+                      Pass_Names[Pass], Elapsed * 1000.0, Lines_Per_Second / 1e6, Megabytes_Per_Second, Comparison);
+            }
+            else
+            {
+               printf("%-8s %-14s %-10s %10.2f %12s %10s %10s\n", Architecture_Name, Workload_Name,
+                      Pass_Names[Pass], Elapsed * 1000.0, "-", "-", Comparison);
+            }
+
+            // NOTE: Passes too fast to measure aren't saved, so they have no
+            // baseline to compare against either.
+            if(Save_File && Measurable)
+            {
+               fprintf(Save_File, "%s\t%s\t%s\t%.0f\t%.3f\n", Architecture_Name, Workload_Name,
+                       Pass_Names[Pass], Lines_Per_Second, Megabytes_Per_Second);
+            }
+         }
+      }
+   }
+
+   if(Save_File)
+   {
+      fclose(Save_File);
+   }
+
+   Thread_Context = 0;
+   Destroy_Context(&Context);
+
+   return(Result);
+}
@@ -0,0 +1,103 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Compares the fread-into-arena input path with the memory-mapped one on
+// a large generated source file. Both variants touch every byte afterwards so
+// the cost of faulting in mapped pages is included.
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct assembler_context;
+static void Report_Error(struct assembler_context *Context, char *Message, ...)
+{
+   (void)Context;
+
+   va_list Arguments;
+   va_start(Arguments, Message);
+   fprintf(stderr, "ERROR: ");
+   vfprintf(stderr, Message, Arguments);
+   fprintf(stderr, "\n");
+   va_end(Arguments);
+}
+
+#include "../src/memory.c"
+
+static double Seconds(void)
+{
+   struct timespec Time;
+   clock_gettime(CLOCK_MONOTONIC, &Time);
+   return(Time.tv_sec + Time.tv_nsec * 1e-9);
+}
+
+static index Count_Newlines(string Source)
+{
+   index Result = 0;
+   for(index Index = 0; Index < Source.Length; ++Index)
+   {
+      Result += (Source.Data[Index] == '\n');
+   }
+   return(Result);
+}
+
+static void Generate_Source(char *Path, index Size)
+{
+   FILE *File = fopen(Path, "wb");
+   if(File)
+   {
+      static char Line[] = "    lda [0x0123 + x]            \\ Load byte at absolute address + x-offset into a\n";
+      for(index Written = 0; Written < Size; Written += sizeof(Line) - 1)
+      {
+         fwrite(Line, 1, sizeof(Line) - 1, File);
+      }
+      fclose(File);
+   }
+}
+
+int main(int Argument_Count, char **Arguments)
+{
+   index Megabytes = (Argument_Count > 1) ? atoi(Arguments[1]) : 200;
+   char *Path = (Argument_Count > 2) ? Arguments[2] : "build/bench_input.asm";
+   int Run_Count = 5;
+
+   index Size = Megabytes * 1024 * 1024;
+   Generate_Source(Path, Size);
+
+   arena Arena = Reserve_Arena(Size + (64 * 1024 * 1024));
+
+   double Best_Read = 1e9;
+   double Best_Map = 1e9;
+   index Total_Bytes = 0;
+
+   for(int Run_Index = 0; Run_Index < Run_Count; ++Run_Index)
+   {
+      double Start = Seconds();
+      string Read = Read_Entire_File(&Arena, Path);
+      index Read_Lines = Count_Newlines(Read);
+      double Elapsed = Seconds() - Start;
+      if(Elapsed < Best_Read) Best_Read = Elapsed;
+      Reset_Arena(&Arena);
+
+      Start = Seconds();
+      input_file Mapped = Open_Input_File(&Arena, Path, true);
+      index Mapped_Lines = Count_Newlines(Mapped.Contents);
+      Close_Input_File(&Mapped);
+      Elapsed = Seconds() - Start;
+      if(Elapsed < Best_Map) Best_Map = Elapsed;
+      Reset_Arena(&Arena);
+
+      assert(Read_Lines == Mapped_Lines);
+      Total_Bytes = Read.Length;
+   }
+
+   double Gigabytes = Total_Bytes / (1024.0 * 1024.0 * 1024.0);
+   printf("input: %.1f MB, best of %d runs\n", Total_Bytes / (1024.0 * 1024.0), Run_Count);
+   printf("fread: %8.2f ms  %6.2f GB/s\n", Best_Read * 1000.0, Gigabytes / Best_Read);
+   printf("mmap:  %8.2f ms  %6.2f GB/s\n", Best_Map * 1000.0, Gigabytes / Best_Map);
+
+   remove(Path);
+   return(0);
+}
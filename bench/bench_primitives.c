@@ -0,0 +1,360 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Microbenchmarks for the string, parse and symbol table primitives in
+// memory.c, which run on every line and operand. Inputs follow the shapes seen
+// in real sources: short operands and directives for the string functions,
+// mostly short hex and decimal literals, and label names of 4 to 30 bytes.
+//
+// Each primitive reports the best of several runs in nanoseconds per call and
+// in cycles per input byte. Cycles come from the time stamp counter, so they
+// are reference cycles and only available on x86. The symbol table also
+// reports its load and how far entries sit from their home slot.
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#   define Read_Cycle_Counter() __rdtsc()
+#else
+#   define Read_Cycle_Counter() 0
+#endif
+
+struct assembler_context;
+static void Report_Error(struct assembler_context *Context, char *Message, ...)
+{
+   (void)Context;
+
+   va_list Arguments;
+   va_start(Arguments, Message);
+   fprintf(stderr, "ERROR: ");
+   vfprintf(stderr, Message, Arguments);
+   fprintf(stderr, "\n");
+   va_end(Arguments);
+}
+
+#include "../src/memory.c"
+#include "../src/mnemonic_hash.h"
+#include "../src/mnemonics_6502.h"
+
+enum
+{
+#  define X(M) MNEMONIC_##M,
+   MNEMONICS_LIST
+#  undef X
+   MNEMONIC_COUNT,
+};
+
+#include "mnemonic_hash_6502.h"
+
+#define SAMPLE_COUNT (1 << 16)
+#define RUN_COUNT 5
+
+typedef struct {
+   string *Strings;
+   index Count;
+   index Bytes; // Total length of all strings.
+} sample_set;
+
+typedef struct {
+   char *Name;
+   double Seconds;
+   u64 Cycles;
+   index Operations;
+   index Bytes;
+} measurement;
+
+static double Seconds(void)
+{
+   struct timespec Time;
+   clock_gettime(CLOCK_MONOTONIC, &Time);
+   return(Time.tv_sec + Time.tv_nsec * 1e-9);
+}
+
+static u32 Random_State = 0x9E3779B9;
+static u32 Next_Random(void)
+{
+   u32 Result = Random_State;
+   Result ^= Result << 13;
+   Result ^= Result >> 17;
+   Result ^= Result << 5;
+   Random_State = Result;
+
+   return(Result);
+}
+
+static string Format_String(arena *Arena, char *Format, ...)
+{
+   va_list Arguments;
+   va_start(Arguments, Format);
+   char Buffer[256];
+   int Length = vsnprintf(Buffer, sizeof(Buffer), Format, Arguments);
+   va_end(Arguments);
+
+   string Result = {0};
+   Result.Data = Allocate(Arena, u8, Length);
+   Result.Length = Length;
+   memcpy(Result.Data, Buffer, Length);
+
+   return(Result);
+}
+
+static sample_set Generate_Lines(arena *Arena)
+{
+   // NOTE: Operands and directive bodies as the parser sees them, some with
+   // surrounding whitespace left by the tokenizer.
+   static char *Mnemonics[] = {"lda", "sta", "jmp", "bne", "adc", "ldx", "cmp", "inc"};
+   static char *Padding[] = {"", "", " ", "    ", "\t"};
+
+   sample_set Result = {0};
+   Result.Strings = Allocate(Arena, string, SAMPLE_COUNT);
+   Result.Count = SAMPLE_COUNT;
+
+   for(index Sample_Index = 0; Sample_Index < SAMPLE_COUNT; ++Sample_Index)
+   {
+      char *Left = Padding[Next_Random() % Array_Count(Padding)];
+      char *Right = Padding[Next_Random() % Array_Count(Padding)];
+      char *Mnemonic = Mnemonics[Next_Random() % Array_Count(Mnemonics)];
+      u32 Value = Next_Random();
+
+      string Line = {0};
+      switch(Next_Random() % 6)
+      {
+         case 0: Line = Format_String(Arena, "%s%s 0x%02X%s", Left, Mnemonic, Value & 0xFF, Right); break;
+         case 1: Line = Format_String(Arena, "%s%s [0x%04X + x]%s", Left, Mnemonic, Value & 0xFFFF, Right); break;
+         case 2: Line = Format_String(Arena, "%s%s Label_%u%s", Left, Mnemonic, Value % 5000, Right); break;
+         case 3: Line = Format_String(Arena, "%sbytes 0x%02X 0x%02X 0x%02X 0x%02X%s", Left, Value & 0xFF,
+                                      (Value >> 8) & 0xFF, (Value >> 16) & 0xFF, Value >> 24, Right); break;
+         case 4: Line = Format_String(Arena, "%sconstant Name_%u %u%s", Left, Value % 100, Value % 65536, Right); break;
+         case 5: Line = Format_String(Arena, "%s%s%s", Left, Mnemonic, Right); break;
+      }
+
+      Result.Strings[Sample_Index] = Line;
+      Result.Bytes += Line.Length;
+   }
+
+   return(Result);
+}
+
+static sample_set Generate_Numbers(arena *Arena)
+{
+   sample_set Result = {0};
+   Result.Strings = Allocate(Arena, string, SAMPLE_COUNT);
+   Result.Count = SAMPLE_COUNT;
+
+   for(index Sample_Index = 0; Sample_Index < SAMPLE_COUNT; ++Sample_Index)
+   {
+      u32 Value = Next_Random();
+
+      string Number = {0};
+      switch(Next_Random() % 8)
+      {
+         case 0: case 1: Number = Format_String(Arena, "0x%02X", Value & 0xFF); break;
+         case 2: case 3: Number = Format_String(Arena, "0x%04X", Value & 0xFFFF); break;
+         case 4: Number = Format_String(Arena, "0x%08X", Value); break;
+         case 5: Number = Format_String(Arena, "%u", Value & 0xFF); break;
+         case 6: Number = Format_String(Arena, "-%u", Value & 0x7FFF); break;
+         case 7: Number = Format_String(Arena, "0b%u%u%u%u%u%u%u%u", Value & 1, (Value >> 1) & 1, (Value >> 2) & 1,
+                                        (Value >> 3) & 1, (Value >> 4) & 1, (Value >> 5) & 1, (Value >> 6) & 1,
+                                        (Value >> 7) & 1); break;
+      }
+
+      Result.Strings[Sample_Index] = Number;
+      Result.Bytes += Number.Length;
+   }
+
+   return(Result);
+}
+
+static sample_set Generate_Keys(arena *Arena, index Count)
+{
+   // NOTE: Distinct label names: local labels, numbered labels and longer
+   // descriptive names, roughly 4 to 30 bytes.
+   sample_set Result = {0};
+   Result.Strings = Allocate(Arena, string, Count);
+   Result.Count = Count;
+
+   for(index Key_Index = 0; Key_Index < Count; ++Key_Index)
+   {
+      string Key = {0};
+      switch(Next_Random() % 5)
+      {
+         case 0: case 1: Key = Format_String(Arena, ".l%td", Key_Index); break;
+         case 2: case 3: Key = Format_String(Arena, "Label_%td", Key_Index); break;
+         case 4: Key = Format_String(Arena, "Player_Sprite_Table_%td", Key_Index); break;
+      }
+
+      Result.Strings[Key_Index] = Key;
+      Result.Bytes += Key.Length;
+   }
+
+   return(Result);
+}
+
+static sample_set Generate_Mnemonics(arena *Arena)
+{
+   static char *Mnemonics[] = {"lda", "sta", "jmp", "bne", "adc", "ldx", "cmp", "inc", "rts", "nop", "mov", "add"};
+
+   sample_set Result = {0};
+   Result.Strings = Allocate(Arena, string, SAMPLE_COUNT);
+   Result.Count = SAMPLE_COUNT;
+
+   for(index Sample_Index = 0; Sample_Index < SAMPLE_COUNT; ++Sample_Index)
+   {
+      Result.Strings[Sample_Index] = From_C_String(Mnemonics[Next_Random() % Array_Count(Mnemonics)]);
+      Result.Bytes += Result.Strings[Sample_Index].Length;
+   }
+
+   return(Result);
+}
+
+// NOTE: Results are folded into a checksum so calls can't be optimized away.
+static volatile u64 Sink;
+
+#define MEASURE(Measurement, Samples, Body)                             \
+   do {                                                                 \
+      (Measurement)->Operations = (Samples)->Count;                     \
+      (Measurement)->Bytes = (Samples)->Bytes;                          \
+      for(int Run_Index = 0; Run_Index < RUN_COUNT; ++Run_Index)        \
+      {                                                                 \
+         u64 Checksum = 0;                                              \
+         double Start = Seconds();                                      \
+         u64 Start_Cycles = Read_Cycle_Counter();                       \
+         for(index Sample_Index = 0; Sample_Index < (Samples)->Count; ++Sample_Index) \
+         {                                                              \
+            string Sample = (Samples)->Strings[Sample_Index];           \
+            Body;                                                       \
+         }                                                              \
+         u64 Cycles = Read_Cycle_Counter() - Start_Cycles;              \
+         double Elapsed = Seconds() - Start;                            \
+         Sink += Checksum;                                              \
+         if(Run_Index == 0 || Elapsed < (Measurement)->Seconds)         \
+         {                                                              \
+            (Measurement)->Seconds = Elapsed;                           \
+            (Measurement)->Cycles = Cycles;                             \
+         }                                                              \
+      }                                                                 \
+   } while(0)
+
+static void Print_Measurement(measurement *Measurement)
+{
+   double Nanoseconds = (Measurement->Seconds * 1e9) / Measurement->Operations;
+   double Bytes_Per_Operation = (double)Measurement->Bytes / Measurement->Operations;
+
+   char Cycles[32] = "n/a";
+   if(Measurement->Cycles)
+   {
+      snprintf(Cycles, sizeof(Cycles), "%.2f", (double)Measurement->Cycles / Measurement->Bytes);
+   }
+
+   printf("%-20s %10.2f %12s %14.1f\n", Measurement->Name, Nanoseconds, Cycles, Bytes_Per_Operation);
+}
+
+static void Print_Probe_Statistics(symbol_table *Table)
+{
+   // NOTE: Distance of each occupied slot from where its hash would put it,
+   // which is the number of extra probes a successful lookup takes.
+   u32 Mask = Table->Slot_Capacity - 1;
+   u64 Total_Distance = 0;
+   u32 Maximum_Distance = 0;
+   u32 Histogram[5] = {0};
+
+   for(u32 Slot_Index = 0; Slot_Index < Table->Slot_Capacity; ++Slot_Index)
+   {
+      symbol_slot Slot = Table->Slots[Slot_Index];
+      if(Slot.Id)
+      {
+         u32 Distance = (Slot_Index - (Slot.Hash & Mask)) & Mask;
+         Total_Distance += Distance;
+         Maximum_Distance = (Distance > Maximum_Distance) ? Distance : Maximum_Distance;
+         Histogram[(Distance < 4) ? Distance : 4]++;
+      }
+   }
+
+   printf("symbol table: %u symbols in %u slots (load %.2f), mean probe distance %.3f, max %u\n",
+          Table->Symbol_Count, Table->Slot_Capacity, (double)Table->Symbol_Count / Table->Slot_Capacity,
+          (double)Total_Distance / Table->Symbol_Count, Maximum_Distance);
+   printf("probe distance histogram: 0:%u 1:%u 2:%u 3:%u 4+:%u\n",
+          Histogram[0], Histogram[1], Histogram[2], Histogram[3], Histogram[4]);
+}
+
+int main(void)
+{
+   arena Arena = Reserve_Arena((index)1024 * 1024 * 1024);
+
+   sample_set Lines = Generate_Lines(&Arena);
+   sample_set Numbers = Generate_Numbers(&Arena);
+   sample_set Keys = Generate_Keys(&Arena, SAMPLE_COUNT);
+   sample_set Mnemonics = Generate_Mnemonics(&Arena);
+
+   // NOTE: Lookups of names that are already interned, in a shuffled order.
+   sample_set Key_Hits = Keys;
+   Key_Hits.Strings = Allocate(&Arena, string, Keys.Count);
+   memcpy(Key_Hits.Strings, Keys.Strings, Keys.Count * sizeof(string));
+   for(index Key_Index = Keys.Count - 1; Key_Index > 0; --Key_Index)
+   {
+      index Other = Next_Random() % (Key_Index + 1);
+      string Swap = Key_Hits.Strings[Key_Index];
+      Key_Hits.Strings[Key_Index] = Key_Hits.Strings[Other];
+      Key_Hits.Strings[Other] = Swap;
+   }
+
+   symbol_table Table = {0};
+   Table.Arena = Reserve_Arena((index)1024 * 1024 * 1024);
+
+   measurement Measurements[16] = {0};
+   int Count = 0;
+   measurement *M;
+
+   M = Measurements + Count++; M->Name = "Cut";
+   MEASURE(M, &Lines, { cut Parts = Cut(Sample, ' '); Checksum += Parts.Before.Length + Parts.Found; });
+
+   M = Measurements + Count++; M->Name = "Cut_Whitespace";
+   MEASURE(M, &Lines, { cut Parts = Cut_Whitespace(Sample); Checksum += Parts.Before.Length + Parts.Found; });
+
+   M = Measurements + Count++; M->Name = "Trim";
+   MEASURE(M, &Lines, { Checksum += Trim(Sample).Length; });
+
+   M = Measurements + Count++; M->Name = "Has_Prefix";
+   MEASURE(M, &Lines, { Checksum += Has_Prefix(Trim_Left(Sample), S("bytes ")); });
+
+   M = Measurements + Count++; M->Name = "Parse_Integer";
+   MEASURE(M, &Numbers, { parsed_integer Parsed = Parse_Integer(Sample); Checksum += Parsed.Value + Parsed.Ok; });
+
+   M = Measurements + Count++; M->Name = "Hash_String";
+   MEASURE(M, &Keys, { Checksum += Hash_String(Sample); });
+
+   M = Measurements + Count++; M->Name = "Lookup_Mnemonic";
+   MEASURE(M, &Mnemonics, { Checksum += Lookup_Mnemonic(&Mnemonic_Hash_6502, Sample).Mnemonic; });
+
+   // NOTE: Inserting into an empty table includes its growth, as in a real
+   // file. The table is reset between runs.
+   M = Measurements + Count++; M->Name = "Intern_Symbol (new)";
+   MEASURE(M, &Keys, {
+      if(Sample_Index == 0) Reset_Symbol_Table(&Table);
+      Checksum += Intern_Symbol(&Table, Sample);
+   });
+
+   M = Measurements + Count++; M->Name = "Intern_Symbol (hit)";
+   MEASURE(M, &Key_Hits, { Checksum += Intern_Symbol(&Table, Sample); });
+
+   M = Measurements + Count++; M->Name = "Lookup_Symbol";
+   MEASURE(M, &Key_Hits, {
+      lookup_result Lookup = Lookup_Symbol(&Table, (symbol_id)(Sample_Index % Table.Symbol_Count) + 1);
+      Checksum += Lookup.Value + Lookup.Found;
+   });
+
+   printf("%-20s %10s %12s %14s\n", "primitive", "ns/op", "cycles/byte", "bytes/op");
+   for(int Index = 0; Index < Count; ++Index)
+   {
+      Print_Measurement(Measurements + Index);
+   }
+   printf("\n");
+   Print_Probe_Statistics(&Table);
+
+   return(0);
+}
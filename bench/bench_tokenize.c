@@ -0,0 +1,89 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Measures tokenizer throughput on a large synthetic source held in
+// memory. Build with -mavx2 to measure the 32-byte scanner instead of SSE2.
+
+#include <time.h>
+
+#define main Assembler_Main
+#include "../src/main.c"
+#undef main
+
+static double Seconds(void)
+{
+   struct timespec Time;
+   clock_gettime(CLOCK_MONOTONIC, &Time);
+   return(Time.tv_sec + Time.tv_nsec * 1e-9);
+}
+
+static string Generate_Source(arena *Arena, index Size)
+{
+   static char *Lines[] =
+   {
+      "    lda [0x0123 + x]            \\ Load byte at absolute address + x-offset into a\n",
+      "Label_0123: sta [[Zero_Address] + y]\n",
+      "\n",
+      "#location 0x0200\n",
+      "\\\\ A full line comment, with: colons # and hashes.\n",
+      "Variable: #bytes 0x03 0x02 0x01 0x00\n",
+      "    bne .Loop\n",
+      "    nop\n",
+   };
+
+   string Result = {0};
+   Result.Data = Allocate(Arena, u8, Size);
+
+   int Line_Index = 0;
+   while(1)
+   {
+      char *Line = Lines[Line_Index++ % Array_Count(Lines)];
+      index Line_Length = C_String_Length(Line);
+      if(Result.Length + Line_Length > Size)
+      {
+         break;
+      }
+
+      memcpy(Result.Data + Result.Length, Line, Line_Length);
+      Result.Length += Line_Length;
+   }
+
+   return(Result);
+}
+
+int main(int Argument_Count, char **Arguments)
+{
+   index Megabytes = (Argument_Count > 1) ? atoi(Arguments[1]) : 256;
+   int Run_Count = 5;
+
+   arena Source_Arena = Reserve_Arena(Megabytes * 1024 * 1024);
+   arena Arena = Reserve_Arena(ASSEMBLER_ARENA_SIZE);
+   symbol_table Symbols = {0};
+   Symbols.Arena = Reserve_Arena(SYMBOL_ARENA_SIZE);
+   string Source = Generate_Source(&Source_Arena, Megabytes * 1024 * 1024);
+
+   double Best = 1e9;
+   int Line_Count = 0;
+   for(int Run_Index = 0; Run_Index < Run_Count; ++Run_Index)
+   {
+      double Start = Seconds();
+      source_code_lines Lines = Tokenize_Source_Lines(&Arena, &Symbols, Source);
+      double Elapsed = Seconds() - Start;
+
+      if(Elapsed < Best) Best = Elapsed;
+      Line_Count = Lines.Count;
+      Reset_Arena(&Arena);
+      Reset_Symbol_Table(&Symbols);
+   }
+
+   char *Scanner = (SCAN_BLOCK_SIZE == 32) ? "avx2" : "sse2";
+#if !defined(__AVX2__) && !defined(__SSE2__)
+   Scanner = "scalar";
+#endif
+
+   printf("tokenize (%s): %.1f MB, %d lines, best of %d runs\n",
+          Scanner, Source.Length / (1024.0 * 1024.0), Line_Count, Run_Count);
+   printf("tokenize (%s): %8.2f ms  %6.2f GB/s  %6.1f M lines/s\n", Scanner, Best * 1000.0,
+          Source.Length / (Best * 1024.0 * 1024.0 * 1024.0), Line_Count / (Best * 1e6));
+
+   return(0);
+}
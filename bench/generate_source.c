@@ -0,0 +1,305 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Generates large synthetic programs for the end-to-end benchmark:
+//
+//    generate_source <architecture> <workload> <megabytes> <output>
+//
+// Workloads are "instructions" (straight-line code), "labels" (a label on
+// every line and mostly forward references), "data" (#bytes, #string and
+// friends, some referencing labels) and "files" (output is a directory that
+// receives many small files mixing all three). Output is deterministic, so
+// results from different runs assemble the same input.
+//
+// The mips backend doesn't encode instructions yet, but still sees realistic
+// lines in the tokenizer and the data directives.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct {
+   char *Name;
+   char *Instructions[12];
+   char *Jump;        // Takes a label, may be any distance away.
+   char *Branch;      // Takes a label, only used for the following line.
+   int Wrap_Interval; // Lines between #location resets, zero if unneeded.
+   char *Wrap;
+} architecture_profile;
+
+static architecture_profile Profiles[] =
+{
+   {
+      "6502",
+      {
+         "lda 0x01", "lda [0x01 + x]", "sta [0x0123 + y]", "ldx [0x0123]",
+         "adc [[0x01 + x]]", "sbc [[0x01] + y]", "inx", "dey",
+         "cmp 0x7F", "asl [0x10]", "ora [0x0200 + x]", "nop",
+      },
+      // NOTE: 16-bit addresses, so the location counter is reset well before
+      // a program could run past the top of memory.
+      "jmp %s", "bne %s", 1024, "#location 0x8000",
+   },
+   {
+      "mips",
+      {
+         "addiu $t0, $t0, 1", "lw $t1, 4($sp)", "sw $t1, 8($sp)", "or $t2, $t0, $t1",
+         "sll $t3, $t2, 2", "lui $t4, 0x8000", "ori $t4, $t4, 0x1234", "subu $t5, $t4, $t3",
+         "and $t6, $t5, $t0", "slt $t7, $t6, $t5", "xor $t0, $t0, $t7", "nop",
+      },
+      "j %s", "bne $t0, $zero, %s", 0, 0,
+   },
+   {
+      "armv4",
+      {
+         "mov r0, 0xAB", "add r1, r0, r2", "sub r3, r1, 4", "ldr r4, [r5, 8]",
+         "str r4, [r6]", "orr r7, r4, r3", "and r8, r7, 0xFF", "cmp r8, r0",
+         "eor r9, r8, r1", "mov r10, r9, lsl 2", "bic r11, r10, 3", "mvn r12, r11",
+      },
+      "b %s", "bne %s", 0, 0,
+   },
+   {
+      "armv8",
+      {
+         "mov x0, 0xAB", "add x1, x0, x2", "sub x3, x1, 4", "ldr x4, [x5, 8]",
+         "str x4, [x6]", "orr x7, x4, x3", "and x8, x7, 0xFF", "cmp x8, x0",
+         "eor x9, x8, x1", "lsl x10, x9, 2", "madd x11, x10, x9, x8", "nop",
+      },
+      "b %s", "b.ne %s", 0, 0,
+   },
+};
+
+// NOTE: Every data line, including the label tables in Emit_Data and the seeds
+// in Generate, is a multiple of 4 bytes long. Data is mixed in between
+// instructions, so otherwise later labels would be misaligned on the
+// architectures with 4-byte instructions, and the "files" workload would be
+// timing error reports instead of code.
+static char *Data_Lines[] =
+{
+   "#bytes 0x00 0x01 0x02 0x03 0x04 0x05 0x06 0x07 0x08 0x09 0x0A 0x0B 0x0C 0x0D 0x0E 0x0F",
+   "#2bytes 0x0123 0x4567 0x89AB 0xCDEF 1 2 3 4",
+   "#4bytes 0x01234567 0x89ABCDEF 42 7",
+   "#string \"The quick brown fox jumps over the lazy dog.\"",
+   "#cstring \"Hello, world!!!\"",
+   "#8bytes 0x0123456789ABCDEF 0",
+};
+
+typedef struct {
+   FILE *File;
+   architecture_profile *Profile;
+   unsigned Random;
+   bool Branches; // Only when every line is labelled.
+   long Line_Count;
+   long Label_Count;
+   long Data_Count;
+} generator;
+
+static unsigned Next_Random(generator *Generator)
+{
+   // NOTE: xorshift32, so the output is the same everywhere.
+   unsigned Result = Generator->Random;
+   Result ^= Result << 13;
+   Result ^= Result >> 17;
+   Result ^= Result << 5;
+   Generator->Random = Result;
+
+   return(Result);
+}
+
+static void Begin_Line(generator *Generator)
+{
+   architecture_profile *Profile = Generator->Profile;
+   if(Profile->Wrap_Interval && (Generator->Line_Count % Profile->Wrap_Interval) == 0)
+   {
+      fprintf(Generator->File, "%s\n", Profile->Wrap);
+   }
+   Generator->Line_Count++;
+}
+
+static void Emit_Instruction(generator *Generator)
+{
+   Begin_Line(Generator);
+
+   char *Instruction = Generator->Profile->Instructions[Next_Random(Generator) % 12];
+   fprintf(Generator->File, "    %-32s\\ %ld\n", Instruction, Generator->Line_Count);
+}
+
+static void Emit_Label(generator *Generator)
+{
+   // NOTE: Mostly forward references, which become relocations, with a short
+   // branch to the very next label and the occasional backward jump.
+   Begin_Line(Generator);
+
+   char Target[32];
+   long Label = Generator->Label_Count++;
+   unsigned Choice = Next_Random(Generator) % 8;
+   if(Choice == 0 && Label > 0)
+   {
+      snprintf(Target, sizeof(Target), "Label_%ld", Label - 1 - (Next_Random(Generator) % (Label < 64 ? Label : 64)));
+   }
+   else
+   {
+      long Distance = (Choice == 1) ? 1 : 1 + (Next_Random(Generator) % 256);
+      snprintf(Target, sizeof(Target), "Label_%ld", Label + Distance);
+   }
+
+   // NOTE: 6502 jumps are absolute but the location counter wraps, so only
+   // branch to the next label, which is never separated by a wrap.
+   char *Format = Generator->Profile->Jump;
+   if(Choice == 1 && Generator->Branches && !(Generator->Profile->Wrap_Interval && (Generator->Line_Count % Generator->Profile->Wrap_Interval) == 0))
+   {
+      Format = Generator->Profile->Branch;
+   }
+
+   fprintf(Generator->File, "Label_%ld: ", Label);
+   fprintf(Generator->File, Format, Target);
+   fprintf(Generator->File, "\n");
+}
+
+static void Emit_Data(generator *Generator)
+{
+   Begin_Line(Generator);
+
+   unsigned Choice = Next_Random(Generator) % (sizeof(Data_Lines) / sizeof(Data_Lines[0]) + 1);
+   if(Choice < sizeof(Data_Lines) / sizeof(Data_Lines[0]))
+   {
+      fprintf(Generator->File, "Data_%ld: %s\n", Generator->Data_Count++, Data_Lines[Choice]);
+   }
+   else
+   {
+      // NOTE: A table of 16-bit label addresses, resolved by relocation.
+      fprintf(Generator->File, "#2bytes");
+      for(int Entry = 0; Entry < 8; ++Entry)
+      {
+         fprintf(Generator->File, " Data_%ld", Generator->Data_Count - 1 - Entry);
+      }
+      fprintf(Generator->File, "\n");
+   }
+}
+
+static void Finish_Labels(generator *Generator)
+{
+   // NOTE: Define the labels that forward references may still point at.
+   long Label_End = (Generator->Label_Count) ? (Generator->Label_Count + 257) : 0;
+   for(long Label = Generator->Label_Count; Label < Label_End; ++Label)
+   {
+      Begin_Line(Generator);
+      fprintf(Generator->File, "Label_%ld: %s\n", Label, Generator->Profile->Instructions[11]);
+   }
+}
+
+static void Generate(generator *Generator, char *Workload, long Size)
+{
+   fprintf(Generator->File, "\\\\ Generated %s workload for %s.\n", Workload, Generator->Profile->Name);
+   fprintf(Generator->File, "#architecture %s\n", Generator->Profile->Name);
+
+   bool Instructions = (strcmp(Workload, "instructions") == 0);
+   bool Labels = (strcmp(Workload, "labels") == 0);
+   bool Data = (strcmp(Workload, "data") == 0);
+   bool Mixed = (strcmp(Workload, "files") == 0);
+   Generator->Branches = Labels;
+
+   // NOTE: Data references point backwards, so seed a few targets first.
+   for(int Entry = 0; Entry < 8; ++Entry)
+   {
+      Begin_Line(Generator);
+      fprintf(Generator->File, "Data_%ld: #bytes 0 0 0 0\n", Generator->Data_Count++);
+   }
+
+   while(ftell(Generator->File) < Size)
+   {
+      unsigned Choice = Next_Random(Generator) % 3;
+      if(Instructions || (Mixed && Choice == 0))
+      {
+         Emit_Instruction(Generator);
+      }
+      else if(Labels || (Mixed && Choice == 1))
+      {
+         Emit_Label(Generator);
+      }
+      else if(Data || Mixed)
+      {
+         Emit_Data(Generator);
+      }
+   }
+
+   Finish_Labels(Generator);
+}
+
+int main(int Argument_Count, char **Arguments)
+{
+   if(Argument_Count != 5)
+   {
+      fprintf(stderr, "Usage: %s <architecture> <instructions|labels|data|files> <megabytes> <output>\n", Arguments[0]);
+      return(1);
+   }
+
+   architecture_profile *Profile = 0;
+   for(size_t Profile_Index = 0; Profile_Index < sizeof(Profiles) / sizeof(Profiles[0]); ++Profile_Index)
+   {
+      if(strcmp(Profiles[Profile_Index].Name, Arguments[1]) == 0)
+      {
+         Profile = Profiles + Profile_Index;
+      }
+   }
+
+   char *Workload = Arguments[2];
+   long Size = atol(Arguments[3]) * 1024 * 1024;
+   char *Output = Arguments[4];
+
+   if(!Profile)
+   {
+      fprintf(stderr, "ERROR: Unknown architecture \"%s\".\n", Arguments[1]);
+      return(1);
+   }
+
+   if(strcmp(Workload, "files") == 0)
+   {
+      // NOTE: Many small files of about 16 KB each.
+      mkdir(Output, 0777);
+
+      long File_Size = 16 * 1024;
+      long File_Count = (Size + File_Size - 1) / File_Size;
+      for(long File_Index = 0; File_Index < File_Count; ++File_Index)
+      {
+         char Path[4096];
+         snprintf(Path, sizeof(Path), "%s/%05ld.asm", Output, File_Index);
+
+         generator Generator = {0};
+         Generator.File = fopen(Path, "wb");
+         Generator.Profile = Profile;
+         Generator.Random = 0x9E3779B9u ^ (unsigned)File_Index;
+         if(!Generator.File)
+         {
+            fprintf(stderr, "ERROR: Failed to create \"%s\".\n", Path);
+            return(1);
+         }
+
+         Generate(&Generator, Workload, File_Size);
+         fclose(Generator.File);
+      }
+   }
+   else if(strcmp(Workload, "instructions") == 0 || strcmp(Workload, "labels") == 0 || strcmp(Workload, "data") == 0)
+   {
+      generator Generator = {0};
+      Generator.File = fopen(Output, "wb");
+      Generator.Profile = Profile;
+      Generator.Random = 0x9E3779B9u;
+      if(!Generator.File)
+      {
+         fprintf(stderr, "ERROR: Failed to create \"%s\".\n", Output);
+         return(1);
+      }
+
+      Generate(&Generator, Workload, Size);
+      fclose(Generator.File);
+   }
+   else
+   {
+      fprintf(stderr, "ERROR: Unknown workload \"%s\".\n", Workload);
+      return(1);
+   }
+
+   return(0);
+}
@@ -6,8 +6,8 @@
 #section text
 
 main:
-    mov r1, 0xAB      \ As does this one.
-    mov r2, 0xBC      \ And this one too.
-    add r0, r1, r2
+    mov x1, 0xAB      \ As does this one.
+    mov x2, 0xBC      \ And this one too.
+    add x0, x1, x2
 
 .loop: b .loop
@@ -3,93 +3,749 @@
 // NOTE: This header file specifies the API all supported instruction sets must
 // implement.
 
-typedef struct machine_code_patch machine_code_patch;
-struct machine_code_patch
+#include "mnemonic_hash.h"
+
+typedef enum {
+   ENDIAN_LITTLE,
+   ENDIAN_BIG,
+} endianness;
+
+// NOTE: A relocation patches a symbol's value into a field of already encoded
+// output once every symbol is known. The kind describes how the value is
+// adjusted and where it lands inside the little- or big-endian container of
+// Width bytes at Address.
+
+typedef enum {
+   RELOCATION_ABSOLUTE,      // Whole container, e.g. #bytes and 6502 addresses.
+   RELOCATION_RELATIVE_8,    // 6502 branch, displacement from the next instruction.
+   RELOCATION_ARM_BRANCH24,  // ARM B/BL, signed word offset from PC + 8.
+   RELOCATION_ARM_LOAD12,    // ARM LDR/STR, byte offset from PC + 8 with the sign in the U bit.
+   RELOCATION_THUMB_BRANCH8, // Thumb B<cond>, signed halfword offset from PC + 4.
+   RELOCATION_THUMB_BRANCH11,// Thumb B, signed halfword offset from PC + 4.
+   RELOCATION_THUMB_BL,      // Thumb BL pair, high and low halves of the offset in each.
+   RELOCATION_THUMB_LOAD8,   // Thumb LDR literal, word offset from PC + 4 rounded down to a word.
+   RELOCATION_A64_BRANCH26,  // A64 B/BL, signed word offset in bits 0-25.
+   RELOCATION_A64_BRANCH19,  // A64 B.cond/CBZ/CBNZ/LDR literal, bits 5-23.
+   RELOCATION_A64_BRANCH14,  // A64 TBZ/TBNZ, bits 5-18.
+   RELOCATION_A64_ADR21,     // A64 ADR, signed byte offset split into immlo and immhi.
+   RELOCATION_A64_PAGE21,    // A64 ADRP, signed offset between 4 KB pages, split like ADR.
+   RELOCATION_A64_LO12,      // A64 ADD and byte loads, %lo12: offset within the 4 KB page.
+   RELOCATION_A64_LO12_16,   // A64 halfword loads, %lo12 scaled by the access size.
+   RELOCATION_A64_LO12_32,   // A64 word loads.
+   RELOCATION_A64_LO12_64,   // A64 doubleword loads.
+   RELOCATION_A64_LO12_128,  // A64 quadword loads.
+   RELOCATION_A64_MOVW_G0,   // A64 MOVZ/MOVK, bits 0-15 of the value in bits 5-20.
+   RELOCATION_A64_MOVW_G1,   // A64 MOVK, bits 16-31.
+   RELOCATION_A64_MOVW_G2,   // A64 MOVK, bits 32-47.
+   RELOCATION_A64_MOVW_G3,   // A64 MOVK, bits 48-63.
+   RELOCATION_MIPS_JUMP26,   // MIPS J/JAL, word address within the 256 MB region.
+   RELOCATION_MIPS_BRANCH16, // MIPS branches, signed word offset from the delay slot.
+   RELOCATION_MIPS_HI16,     // MIPS %hi, upper half adjusted for the signed %lo.
+   RELOCATION_MIPS_LO16,     // MIPS %lo, lower half.
+
+   RELOCATION_KIND_COUNT,
+} relocation_kind;
+
+typedef enum {
+   RELOCATION_RANGE_ANY,      // Truncate silently, e.g. split halves.
+   RELOCATION_RANGE_SIGNED,   // Must fit as a signed field.
+   RELOCATION_RANGE_UNSIGNED, // Must fit as either a signed or unsigned field.
+   RELOCATION_RANGE_FORWARD,  // Must fit as an unsigned field, e.g. loads that can't look back.
+} relocation_range;
+
+typedef struct {
+   bool PC_Relative;
+   s8 PC_Bias;       // Distance from the container to the PC the offset is taken from.
+   u8 Right_Shift;   // Low bits dropped from the value, which must be zero.
+   u8 Bit_Offset;    // Position of the field in the container.
+   u8 Bit_Count;     // Width of the field, zero for the whole container.
+   u8 Range;
+   bool High_Adjust; // Round so the sign-extended low half adds back correctly.
+   u8 Sign_Bit;      // If non-zero, the field is a magnitude and this bit is set when adding it.
+   u8 PC_Alignment;  // If non-zero, the PC is rounded down to a multiple of it.
+   u8 Low_Bit_Count; // If non-zero, the low bits of the value go to a field of their own...
+   u8 Low_Bit_Offset;// ...at this position, and the rest to Bit_Offset.
+   u8 Page_Bits;     // If non-zero, the value is the distance between pages of this size, or the offset within one.
+} relocation_kind_info;
+
+static relocation_kind_info Relocation_Kinds[RELOCATION_KIND_COUNT] =
 {
-   string Label;
-   index Offset;
-   index Length;
-   machine_code_patch *Next;
+   [RELOCATION_ABSOLUTE]      = {.Range = RELOCATION_RANGE_UNSIGNED},
+   [RELOCATION_RELATIVE_8]    = {.PC_Relative = true, .PC_Bias = 1, .Range = RELOCATION_RANGE_SIGNED},
+   [RELOCATION_ARM_BRANCH24]  = {.PC_Relative = true, .PC_Bias = 8, .Right_Shift = 2, .Bit_Count = 24, .Range = RELOCATION_RANGE_SIGNED},
+   [RELOCATION_ARM_LOAD12]    = {.PC_Relative = true, .PC_Bias = 8, .Bit_Count = 12, .Range = RELOCATION_RANGE_UNSIGNED, .Sign_Bit = 23},
+   [RELOCATION_THUMB_BRANCH8] = {.PC_Relative = true, .PC_Bias = 4, .Right_Shift = 1, .Bit_Count = 8, .Range = RELOCATION_RANGE_SIGNED},
+   [RELOCATION_THUMB_BRANCH11]= {.PC_Relative = true, .PC_Bias = 4, .Right_Shift = 1, .Bit_Count = 11, .Range = RELOCATION_RANGE_SIGNED},
+   [RELOCATION_THUMB_BL]      = {.PC_Relative = true, .PC_Bias = 4, .Right_Shift = 1, .Bit_Count = 22, .Range = RELOCATION_RANGE_SIGNED,
+                                 .Low_Bit_Count = 11, .Low_Bit_Offset = 16},
+   [RELOCATION_THUMB_LOAD8]   = {.PC_Relative = true, .PC_Bias = 4, .Right_Shift = 2, .Bit_Count = 8, .Range = RELOCATION_RANGE_FORWARD,
+                                 .PC_Alignment = 4},
+   [RELOCATION_A64_BRANCH26]  = {.PC_Relative = true, .Right_Shift = 2, .Bit_Count = 26, .Range = RELOCATION_RANGE_SIGNED},
+   [RELOCATION_A64_BRANCH19]  = {.PC_Relative = true, .Right_Shift = 2, .Bit_Offset = 5, .Bit_Count = 19, .Range = RELOCATION_RANGE_SIGNED},
+   [RELOCATION_A64_BRANCH14]  = {.PC_Relative = true, .Right_Shift = 2, .Bit_Offset = 5, .Bit_Count = 14, .Range = RELOCATION_RANGE_SIGNED},
+   [RELOCATION_A64_ADR21]     = {.PC_Relative = true, .Bit_Offset = 5, .Bit_Count = 21, .Range = RELOCATION_RANGE_SIGNED,
+                                 .Low_Bit_Count = 2, .Low_Bit_Offset = 29},
+   [RELOCATION_A64_PAGE21]    = {.PC_Relative = true, .Right_Shift = 12, .Bit_Offset = 5, .Bit_Count = 21, .Range = RELOCATION_RANGE_SIGNED,
+                                 .Low_Bit_Count = 2, .Low_Bit_Offset = 29, .Page_Bits = 12},
+   [RELOCATION_A64_LO12]      = {.Bit_Offset = 10, .Bit_Count = 12, .Range = RELOCATION_RANGE_FORWARD, .Page_Bits = 12},
+   [RELOCATION_A64_LO12_16]   = {.Right_Shift = 1, .Bit_Offset = 10, .Bit_Count = 11, .Range = RELOCATION_RANGE_FORWARD, .Page_Bits = 12},
+   [RELOCATION_A64_LO12_32]   = {.Right_Shift = 2, .Bit_Offset = 10, .Bit_Count = 10, .Range = RELOCATION_RANGE_FORWARD, .Page_Bits = 12},
+   [RELOCATION_A64_LO12_64]   = {.Right_Shift = 3, .Bit_Offset = 10, .Bit_Count = 9, .Range = RELOCATION_RANGE_FORWARD, .Page_Bits = 12},
+   [RELOCATION_A64_LO12_128]  = {.Right_Shift = 4, .Bit_Offset = 10, .Bit_Count = 8, .Range = RELOCATION_RANGE_FORWARD, .Page_Bits = 12},
+   [RELOCATION_A64_MOVW_G0]   = {.Bit_Offset = 5, .Bit_Count = 16, .Range = RELOCATION_RANGE_ANY},
+   [RELOCATION_A64_MOVW_G1]   = {.Right_Shift = 16, .Bit_Offset = 5, .Bit_Count = 16, .Range = RELOCATION_RANGE_ANY},
+   [RELOCATION_A64_MOVW_G2]   = {.Right_Shift = 32, .Bit_Offset = 5, .Bit_Count = 16, .Range = RELOCATION_RANGE_ANY},
+   [RELOCATION_A64_MOVW_G3]   = {.Right_Shift = 48, .Bit_Offset = 5, .Bit_Count = 16, .Range = RELOCATION_RANGE_ANY},
+   [RELOCATION_MIPS_JUMP26]   = {.Right_Shift = 2, .Bit_Count = 26, .Range = RELOCATION_RANGE_ANY},
+   [RELOCATION_MIPS_BRANCH16] = {.PC_Relative = true, .PC_Bias = 4, .Right_Shift = 2, .Bit_Count = 16, .Range = RELOCATION_RANGE_SIGNED},
+   [RELOCATION_MIPS_HI16]     = {.Right_Shift = 16, .Bit_Count = 16, .Range = RELOCATION_RANGE_ANY, .High_Adjust = true},
+   [RELOCATION_MIPS_LO16]     = {.Bit_Count = 16, .Range = RELOCATION_RANGE_ANY},
 };
 
 typedef struct {
-   index Address;
+   symbol_id Symbol;
+   int Line_Number;
+   u64 Address;
+   u8 Width;
+   u8 Kind;
+   u8 Endianness;
+   bool Relaxable; // Out of range relaxes the line instead, see Relax_Lines.
+   u8 Section;     // The Current_Section of the line that requested it.
+} relocation;
+
+typedef struct {
+   arena Arena;
+   relocation *Relocations; // Contiguous, pushed in source order.
+   index Count;
+   index Relaxable_Count;
+
+   // NOTE: Outcomes of the last Apply_Relocations.
+   index Unresolved_Count;
+   index Out_Of_Range_Count; // Misaligned targets included.
+} relocation_table;
+
+// NOTE: Constants that don't fit in an instruction, e.g. ARM's ldr r0, =value,
+// are loaded PC-relative from a literal pool. Requested literals stay pending
+// until the pool is placed: at #pool, before #section, #location or
+// #architecture, at the end of the file, or automatically (behind a branch
+// around it) before the earliest pending load would be out of reach. Every
+// entry gets a generated label, so a load is an ordinary relocation against it.
+// Equal literals share an entry while it is in reach, including the entries of
+// the previous pool.
+
+#define MAX_PENDING_LITERAL_COUNT 1024
+#define LITERAL_SLOT_COUNT 4096 // Twice the literals kept, a power of two.
+
+typedef struct {
+   u64 Value;       // The constant, or the symbol whose value is stored.
+   bool Is_Symbol;
+   u8 Width;
+   symbol_id Label; // Defined once the literal is placed.
+} pool_literal;
+
+typedef struct {
+   arena Arena;
+
+   // NOTE: The previous pool's literals, followed by the pending ones.
+   pool_literal *Literals;
+   u32 Placed_Count;
+   u32 Count;
+   u16 *Slots; // Literal index plus one, open addressing on the value.
+
+   index Deadline;     // Last address a pending literal may be placed at.
+   index Pending_Size;
+   int Pool_Count;
+} literal_pool;
+
+typedef struct {
    index Length;
-   union
-   {
-      u8 Bytes[16];
-      u8 *Bytes_Pointer;
-   };
-   machine_code_patch *Patches;
+   u8 Bytes[16];
 } machine_code;
 
+// NOTE: Every backend is compiled into the one binary and describes itself
+// with an architecture, listed in Architectures in main.c. A file selects its
+// backend with #architecture (or #arch), falling back to --arch. Tables a
+// backend builds in Initialize live in their own arena, and are built once,
+// the first time any file selects that backend.
+
+typedef struct assembler_context assembler_context;
+
+#define INITIALIZE_ARCHITECTURE(Name) void Name(assembler_context *Context)
+typedef INITIALIZE_ARCHITECTURE(initialize_architecture);
+
+#define ENCODE_INSTRUCTION(Name) machine_code Name(assembler_context *Context, string Instruction)
+typedef ENCODE_INSTRUCTION(encode_instruction);
+
+#define PARSE_DIRECTIVE(Name) bool Name(assembler_context *Context, string Directive)
+typedef PARSE_DIRECTIVE(parse_directive);
+
+#define RELOCATION_KIND_BIT(Kind) (1u << (Kind))
+
+typedef struct {
+   char *Name;       // Canonical name, recorded in objects and cache entries.
+   char *Aliases[4]; // Other names accepted for it.
+   endianness Endianness;
+   u32 Relocation_Kinds; // Bit for each relocation_kind the backend requests.
+
+   initialize_architecture *Initialize;
+   encode_instruction *Encode_Instruction;
+   parse_directive *Parse_Directive; // Optional, returns false for directives it doesn't know.
+
+   bool Initialized;
+   u64 Name_Hash; // Set along with Initialized.
+} architecture;
+
 typedef struct {
    string Label;
+   symbol_id Label_Symbol;
    string Instruction;
    string Directive;
    int Line_Number;
+   u8 Relaxation; // Zero for the shortest form, raised by Relax_Lines.
 
-   machine_code Machine_Code;
+   index Address;
+   index Length;
 } source_code_line;
 
-typedef struct assembler_context assembler_context;
+typedef struct {
+   char *Data;
+   index Length;
+   index Capacity;
+} message_buffer;
+
+typedef struct {
+   message_buffer Standard_Output;
+   message_buffer Standard_Error;
+} message_log;
+
+// NOTE: The output image is a list of address ranges rather than one flat
+// buffer, so distant #location values don't require the space in between.
+// Segment bytes are allocated from the image's arena, and the most recently
+// written segment grows in place while it stays at the top of that arena.
+
+typedef struct output_segment output_segment;
+struct output_segment
+{
+   index Address;
+   index Length;
+   u8 *Data;
+   int Section;
+   output_segment *Next; // Older segment. Newer segments win where they overlap.
+};
+
+typedef struct {
+   arena Arena;
+   output_segment *Segments; // Newest first.
+   output_segment *Current;  // Most recently written or looked up.
+} output_image;
+
+typedef struct {
+   string Name;
+   index Start;    // Location counter when the section was first entered.
+   index Location; // Saved location counter while another section is current.
+} output_section;
+
+#define MAX_SECTION_COUNT 64
+
 struct assembler_context
 {
    arena Arena;
+   message_log *Log; // Buffered diagnostics when assembling in parallel.
+   architecture *Architecture; // Null until selected, see Select_Architecture.
+   int Instruction_Set; // Backend specific, e.g. ARM or Thumb. Zero when selected.
 
    string Input_File_Path;
    string Output_File_Name;
-   map *Constants;
+   symbol_table Symbols;
+   relocation_table Relocations;
+   literal_pool Literal_Pool;
+   output_image Output;
+
+   output_section Sections[MAX_SECTION_COUNT];
+   int Section_Count;
+   int Current_Section;
 
    index Current_Address;
    int Current_Line_Number;
+   int Error_Count;
+
+   // NOTE: The Relaxation of the line being encoded. Backends pick the form
+   // of an instruction with it, see Request_Relaxable_Relocation.
+   int Relaxation;
+
+   // NOTE: When producing an object file, label addresses are only final once
+   // sections are laid out by the linker, so every reference to a label goes
+   // through a relocation.
+   bool Relocatable_Output;
+
+   struct file_stats *Stats; // Null unless --stats was given, see stats.c.
+   symbol_table Mnemonic_Histogram;
+
+   // NOTE: Incremental cache recording, see cache.c.
+   bool Cache_Recording;
+   arena Cache_Stream;
+   struct cached_line *Cache_Line;
+   index Cache_Line_Address;
+   int Cache_Line_Errors;
+   bool Cache_Line_Skipped;
 };
 
-static void Request_Patch(arena *Arena, machine_code *Machine_Code,
-                          string Label, index Offset, index Length)
+static void Record_Cache_Dependency(assembler_context *Context, symbol_id Symbol, lookup_result Lookup);
+static void Record_Cache_Relocation(assembler_context *Context, relocation *Relocation);
+static void Skip_Cached_Line(assembler_context *Context);
+
+static void Define_Label(assembler_context *Context, symbol_id Symbol, index Address)
 {
-   machine_code_patch *Patch = Allocate(Arena, machine_code_patch, 1);
-   Patch->Label = Label;
-   Patch->Offset = Offset;
-   Patch->Length = Length;
-   Patch->Next = Machine_Code->Patches;
+   Define_Symbol(&Context->Symbols, Symbol, Address);
+   Context->Symbols.Symbols[Symbol].Section = Context->Current_Section + 1;
+}
 
-   Machine_Code->Patches = Patch;
+static lookup_result Resolve_Symbol(assembler_context *Context, symbol_id Symbol)
+{
+   // NOTE: Lookups that affect a line's encoding go through here, so that the
+   // cache knows which symbols a line depends on.
+   lookup_result Result = Lookup_Symbol(&Context->Symbols, Symbol);
+   if(Context->Relocatable_Output && Result.Found && Context->Symbols.Symbols[Symbol].Section)
+   {
+      Result = (lookup_result){0};
+   }
+
+   if(Context->Cache_Line)
+   {
+      Record_Cache_Dependency(Context, Symbol, Result);
+   }
+
+   return(Result);
 }
 
-static void Apply_Patches(assembler_context *Context, machine_code *Machine_Code)
+static void Add_Relocation(assembler_context *Context, symbol_id Symbol, u64 Address, int Width,
+                           relocation_kind Kind, endianness Endianness, bool Relaxable)
 {
-   for(machine_code_patch *Patch = Machine_Code->Patches; Patch; Patch = Patch->Next)
+   relocation_table *Table = &Context->Relocations;
+   if(!Table->Relocations)
+   {
+      Table->Relocations = Allocate(&Table->Arena, relocation, 0);
+   }
+
+   relocation *Relocation = Allocate(&Table->Arena, relocation, 1);
+   assert(Relocation == Table->Relocations + Table->Count);
+   Table->Count++;
+
+   Relocation->Symbol = Symbol;
+   Relocation->Line_Number = Context->Current_Line_Number;
+   Relocation->Address = Address;
+   Relocation->Width = (u8)Width;
+   Relocation->Kind = (u8)Kind;
+   Relocation->Endianness = (u8)Endianness;
+   Relocation->Relaxable = Relaxable;
+   Relocation->Section = (u8)Context->Current_Section;
+   Table->Relaxable_Count += Relaxable;
+
+   if(Context->Cache_Line)
    {
-      lookup_result Constant = Lookup(Context->Constants, Patch->Label);
-      if(Constant.Found)
+      Record_Cache_Relocation(Context, Relocation);
+   }
+}
+
+static void Request_Relocation(assembler_context *Context, symbol_id Symbol, u64 Address,
+                               int Width, relocation_kind Kind, endianness Endianness)
+{
+   Add_Relocation(Context, Symbol, Address, Width, Kind, Endianness, false);
+}
+
+static void Request_Relaxable_Relocation(assembler_context *Context, symbol_id Symbol, u64 Address,
+                                         int Width, relocation_kind Kind, endianness Endianness)
+{
+   // NOTE: For the short form of an instruction that has a longer one with
+   // more reach. The short form is assumed until the value is known, and if
+   // it then doesn't fit, the line is encoded again with Context->Relaxation
+   // raised, rather than reported. Only request this while the backend still
+   // has a longer form to fall back on.
+   Add_Relocation(Context, Symbol, Address, Width, Kind, Endianness, true);
+}
+
+static u32 Literal_Slot_Index(u64 Value, bool Is_Symbol)
+{
+   u32 Result = (u32)(((Value ^ Is_Symbol) * 0x9E3779B97F4A7C15) >> 32) & (LITERAL_SLOT_COUNT - 1);
+   return(Result);
+}
+
+static void Insert_Literal_Slot(literal_pool *Pool, u32 Literal_Index)
+{
+   pool_literal *Literal = Pool->Literals + Literal_Index;
+   u32 Index = Literal_Slot_Index(Literal->Value, Literal->Is_Symbol);
+   while(Pool->Slots[Index])
+   {
+      Index = (Index + 1) & (LITERAL_SLOT_COUNT - 1);
+   }
+   Pool->Slots[Index] = (u16)(Literal_Index + 1);
+}
+
+static symbol_id Add_Literal(assembler_context *Context, u64 Value, bool Is_Symbol, int Width,
+                             index Minimum, index Maximum)
+{
+   // NOTE: Returns the label of a pool entry holding the value, which lies
+   // between Minimum and Maximum once placed, or zero if too many literals are
+   // pending. The line is never replayed from the cache, since its pool entry
+   // has to be requested again.
+   literal_pool *Pool = &Context->Literal_Pool;
+   if(!Pool->Literals)
+   {
+      Pool->Literals = Allocate(&Pool->Arena, pool_literal, 2 * MAX_PENDING_LITERAL_COUNT);
+      Pool->Slots = Allocate(&Pool->Arena, u16, LITERAL_SLOT_COUNT);
+   }
+   Skip_Cached_Line(Context);
+
+   symbol_id Result = 0;
+   u32 Index = Literal_Slot_Index(Value, Is_Symbol);
+   for(; Pool->Slots[Index]; Index = (Index + 1) & (LITERAL_SLOT_COUNT - 1))
+   {
+      u32 Literal_Index = Pool->Slots[Index] - 1;
+      pool_literal *Literal = Pool->Literals + Literal_Index;
+      if(Literal->Value == Value && Literal->Is_Symbol == Is_Symbol && Literal->Width == Width)
       {
-         assert(Patch->Length <= Machine_Code->Length);
+         // NOTE: Pending literals are placed after every load that uses them.
+         bool Pending = (Literal_Index >= Pool->Placed_Count);
+         if(Pending || (index)Context->Symbols.Symbols[Literal->Label].Value >= Minimum)
+         {
+            if(Pending && Maximum < Pool->Deadline)
+            {
+               Pool->Deadline = Maximum;
+            }
+            Result = Literal->Label;
+            break;
+         }
+      }
+   }
 
-         u8 *Destination = (Machine_Code->Length > Array_Count(Machine_Code->Bytes))
-            ? Machine_Code->Bytes_Pointer
-            : Machine_Code->Bytes;
+   if(!Result && (Pool->Count - Pool->Placed_Count) == MAX_PENDING_LITERAL_COUNT)
+   {
+      Report_Error(Context, "Too many pending literals, the limit is %d. Place them with #pool.", MAX_PENDING_LITERAL_COUNT);
+   }
+   else if(!Result)
+   {
+      // NOTE: Labels are named after the literal, which is what a diagnostic
+      // about an entry out of reach shows. Names live as long as the symbols,
+      // since the pool is reset whenever the file is laid out again.
+      arena *Names = &Context->Symbols.Arena;
+      string Name = {0};
+      if(Is_Symbol)
+      {
+         string Symbol_Name = Context->Symbols.Symbols[Value].Name;
+         Name.Length = snprintf(0, 0, "=%.*s (pool %d)", SF(Symbol_Name), Pool->Pool_Count);
+         Name.Data = Allocate(Names, u8, Name.Length + 1);
+         snprintf((char *)Name.Data, Name.Length + 1, "=%.*s (pool %d)", SF(Symbol_Name), Pool->Pool_Count);
+      }
+      else
+      {
+         Name.Length = snprintf(0, 0, "=0x%llx (pool %d)", (unsigned long long)Value, Pool->Pool_Count);
+         Name.Data = Allocate(Names, u8, Name.Length + 1);
+         snprintf((char *)Name.Data, Name.Length + 1, "=0x%llx (pool %d)", (unsigned long long)Value, Pool->Pool_Count);
+      }
 
-         // TODO: Endianess.
-         for(index Byte_Index = 0; Byte_Index < Patch->Length; ++Byte_Index)
+      if(Pool->Count == Pool->Placed_Count || Maximum < Pool->Deadline)
+      {
+         Pool->Deadline = Maximum;
+      }
+      Pool->Pending_Size += Width;
+
+      pool_literal *Literal = Pool->Literals + Pool->Count;
+      Literal->Value = Value;
+      Literal->Is_Symbol = Is_Symbol;
+      Literal->Width = (u8)Width;
+      Literal->Label = Intern_Symbol(&Context->Symbols, Name);
+      Pool->Slots[Index] = (u16)(++Pool->Count);
+
+      Result = Literal->Label;
+   }
+
+   return(Result);
+}
+
+static u8 *Reserve_Output(assembler_context *Context, index Address, index Length)
+{
+   // NOTE: Return where the bytes of the given range go, creating or growing
+   // a segment to cover it. New bytes read as zero.
+   output_image *Image = &Context->Output;
+   u8 *Result = 0;
+
+   if(Length > 0)
+   {
+      output_segment *Segment = Image->Current;
+      if(Segment && Segment->Section == Context->Current_Section &&
+         Address >= Segment->Address && Address <= (Segment->Address + Segment->Length))
+      {
+         index Offset = Address - Segment->Address;
+         index Required = Offset + Length;
+
+         if(Required <= Segment->Length)
          {
-            index Address = Patch->Offset + Byte_Index;
-            u8 Value = (u8)(Constant.Value >> (Byte_Index * 8));
+            Result = Segment->Data + Offset;
+         }
+         else if((Segment->Data + Segment->Length) == (Image->Arena.Base + Image->Arena.Used))
+         {
+            Allocate_Size_Aligned(&Image->Arena, Required - Segment->Length, 1);
+            Segment->Length = Required;
+            Result = Segment->Data + Offset;
+         }
+      }
+
+      if(!Result)
+      {
+         Segment = Allocate(&Context->Arena, output_segment, 1);
+         Segment->Address = Address;
+         Segment->Length = Length;
+         Segment->Data = Allocate_Size_Aligned(&Image->Arena, Length, 1);
+         Segment->Section = Context->Current_Section;
+         Segment->Next = Image->Segments;
+
+         Image->Segments = Segment;
+         Result = Segment->Data;
+      }
+
+      Image->Current = Segment;
+   }
 
-            printf("%zu <- %x\n", Address, Value);
+   return(Result);
+}
+
+static bool Segment_Holds(output_segment *Segment, int Section, index Address, index Length)
+{
+   bool Result = (Segment->Section == Section && Address >= Segment->Address &&
+                  (Address + Length) <= (Segment->Address + Segment->Length));
+   return(Result);
+}
 
-            Destination[Address] = Value;
+static u8 *Find_Output(output_image *Image, int Section, index Address, index Length)
+{
+   // NOTE: Find already written bytes of a section, preferring the newest
+   // segment. Sections may cover the same addresses, so the address alone
+   // doesn't say which bytes are meant.
+   u8 *Result = 0;
+
+   output_segment *Segment = Image->Current;
+   if(!Segment || !Segment_Holds(Segment, Section, Address, Length))
+   {
+      for(Segment = Image->Segments; Segment; Segment = Segment->Next)
+      {
+         if(Segment_Holds(Segment, Section, Address, Length))
+         {
+            break;
          }
       }
+   }
+
+   if(Segment)
+   {
+      Image->Current = Segment;
+      Result = Segment->Data + (Address - Segment->Address);
+   }
+
+   return(Result);
+}
+
+static void Reset_Output_Image(output_image *Image)
+{
+   Reset_Arena(&Image->Arena);
+   Image->Segments = 0;
+   Image->Current = 0;
+}
+
+static void Switch_Section(assembler_context *Context, string Name)
+{
+   // NOTE: Each section keeps its own location counter. A section starts at
+   // the current location the first time it is entered.
+   Context->Sections[Context->Current_Section].Location = Context->Current_Address;
+
+   int Section_Index = 0;
+   while(Section_Index < Context->Section_Count && !Equals(Context->Sections[Section_Index].Name, Name))
+   {
+      Section_Index++;
+   }
+
+   if(Section_Index == Context->Section_Count)
+   {
+      if(Context->Section_Count < MAX_SECTION_COUNT)
+      {
+         Context->Sections[Section_Index].Name = Name;
+         Context->Sections[Section_Index].Start = Context->Current_Address;
+         Context->Sections[Section_Index].Location = Context->Current_Address;
+         Context->Section_Count++;
+      }
       else
       {
-         Report_Error(Context, "Failed to resolve \"%.*s\".", SF(Patch->Label));
+         Report_Error(Context, "Too many sections, the limit is %d.", MAX_SECTION_COUNT);
+         Section_Index = Context->Current_Section;
       }
    }
+
+   Context->Current_Section = Section_Index;
+   Context->Current_Address = Context->Sections[Section_Index].Location;
 }
 
-#define INITIALIZE_ARCHITECTURE(Name) void Name(assembler_context *Context)
-static INITIALIZE_ARCHITECTURE(Initialize_Architecture);
+static void Reset_Relocation_Table(relocation_table *Table)
+{
+   Reset_Arena(&Table->Arena);
+   Table->Relocations = 0;
+   Table->Count = 0;
+   Table->Relaxable_Count = 0;
+   Table->Unresolved_Count = 0;
+   Table->Out_Of_Range_Count = 0;
+}
+
+static void Reset_Literal_Pool(literal_pool *Pool)
+{
+   Reset_Arena(&Pool->Arena);
+   Pool->Literals = 0;
+   Pool->Placed_Count = 0;
+   Pool->Count = 0;
+   Pool->Slots = 0;
+   Pool->Deadline = 0;
+   Pool->Pending_Size = 0;
+   Pool->Pool_Count = 0;
+}
+
+typedef enum {
+   RELOCATION_FITS,
+   RELOCATION_OUT_OF_RANGE,
+   RELOCATION_MISALIGNED, // Low bits that the field drops were not zero.
+} relocation_status;
+
+static char *Relocation_Status_Messages[] =
+{
+   [RELOCATION_OUT_OF_RANGE] = "Value of \"%.*s\" is out of range for its operand.",
+   [RELOCATION_MISALIGNED]   = "Value of \"%.*s\" is not aligned for its operand.",
+};
+
+static relocation_status Encode_Relocation(u8 *Destination, relocation *Relocation, u64 Target)
+{
+   // NOTE: Reports whether the adjusted value fits its field, checking the
+   // alignment first. The field is written either way.
+   relocation_kind_info Info = Relocation_Kinds[Relocation->Kind];
+   int Width = Relocation->Width;
+   int Bit_Count = (Info.Bit_Count) ? Info.Bit_Count : (Width * 8);
+
+   s64 Value = (s64)Target;
+   s64 Page_Mask = ((s64)1 << Info.Page_Bits) - 1;
+   if(Info.PC_Relative)
+   {
+      s64 PC = (s64)Relocation->Address + Info.PC_Bias;
+      if(Info.PC_Alignment)
+      {
+         PC &= -(s64)Info.PC_Alignment;
+      }
+      if(Info.Page_Bits)
+      {
+         Value &= ~Page_Mask;
+         PC &= ~Page_Mask;
+      }
+      Value -= PC;
+   }
+   else if(Info.Page_Bits)
+   {
+      Value &= Page_Mask;
+   }
+   if(Info.High_Adjust)
+   {
+      Value += (s64)1 << (Info.Right_Shift - 1);
+   }
+
+   u64 Sign_Mask = (Info.Sign_Bit) ? ((u64)1 << Info.Sign_Bit) : 0;
+   u64 Sign = Sign_Mask;
+   if(Sign_Mask && Value < 0)
+   {
+      Value = -Value;
+      Sign = 0;
+   }
+
+   bool Aligned = true;
+   if(Info.Range != RELOCATION_RANGE_ANY)
+   {
+      s64 Alignment_Mask = ((s64)1 << Info.Right_Shift) - 1;
+      Aligned = ((Value & Alignment_Mask) == 0);
+   }
+   Value >>= Info.Right_Shift;
+
+   bool In_Range = true;
+   if(Bit_Count < 64)
+   {
+      s64 Signed_Minimum = -((s64)1 << (Bit_Count - 1));
+      s64 Signed_Maximum = ((s64)1 << (Bit_Count - 1)) - 1;
+      s64 Unsigned_Maximum = (Bit_Count < 63) ? (((s64)1 << Bit_Count) - 1) : INT64_MAX;
+
+      switch(Info.Range)
+      {
+         case RELOCATION_RANGE_SIGNED: {
+            In_Range = (Value >= Signed_Minimum && Value <= Signed_Maximum);
+         } break;
+
+         case RELOCATION_RANGE_UNSIGNED: {
+            In_Range = (Value >= Signed_Minimum && Value <= Unsigned_Maximum);
+         } break;
+
+         case RELOCATION_RANGE_FORWARD: {
+            In_Range = (Value >= 0 && Value <= Unsigned_Maximum);
+         } break;
+      }
+   }
+
+   u64 Container = 0;
+   for(int Byte_Index = 0; Byte_Index < Width; ++Byte_Index)
+   {
+      int Shift = (Relocation->Endianness == ENDIAN_BIG) ? ((Width - 1 - Byte_Index) * 8) : (Byte_Index * 8);
+      Container |= (u64)Destination[Byte_Index] << Shift;
+   }
+
+   u64 Field_Mask = (Bit_Count < 64) ? ((((u64)1 << Bit_Count) - 1) << Info.Bit_Offset) : ~(u64)0;
+   u64 Field = ((u64)Value << Info.Bit_Offset) & Field_Mask;
+   if(Info.Low_Bit_Count)
+   {
+      u64 Low_Mask = ((u64)1 << Info.Low_Bit_Count) - 1;
+      u64 High_Mask = ((u64)1 << (Bit_Count - Info.Low_Bit_Count)) - 1;
+      Field_Mask = (Low_Mask << Info.Low_Bit_Offset) | (High_Mask << Info.Bit_Offset);
+      Field = (((u64)Value & Low_Mask) << Info.Low_Bit_Offset) | ((((u64)Value >> Info.Low_Bit_Count) & High_Mask) << Info.Bit_Offset);
+   }
+   Container = (Container & ~(Field_Mask | Sign_Mask)) | Field | Sign;
+
+   for(int Byte_Index = 0; Byte_Index < Width; ++Byte_Index)
+   {
+      int Shift = (Relocation->Endianness == ENDIAN_BIG) ? ((Width - 1 - Byte_Index) * 8) : (Byte_Index * 8);
+      Destination[Byte_Index] = (u8)(Container >> Shift);
+   }
+
+   relocation_status Result = (!Aligned) ? RELOCATION_MISALIGNED : (!In_Range) ? RELOCATION_OUT_OF_RANGE : RELOCATION_FITS;
+   return(Result);
+}
+
+static void Apply_Relocations(assembler_context *Context)
+{
+   relocation_table *Table = &Context->Relocations;
+   symbol *Symbols = Context->Symbols.Symbols;
+
+   for(index Relocation_Index = 0; Relocation_Index < Table->Count; ++Relocation_Index)
+   {
+      relocation *Relocation = Table->Relocations + Relocation_Index;
+      symbol *Symbol = Symbols + Relocation->Symbol;
+
+      u8 *Destination = Find_Output(&Context->Output, Relocation->Section, Relocation->Address, Relocation->Width);
+      assert(Destination);
+
+      if(Symbol->Defined)
+      {
+         relocation_status Status = Encode_Relocation(Destination, Relocation, Symbol->Value);
+         if(Status != RELOCATION_FITS)
+         {
+            Table->Out_Of_Range_Count++;
+            Context->Current_Line_Number = Relocation->Line_Number;
+            Report_Error(Context, Relocation_Status_Messages[Status], SF(Symbol->Name));
+         }
+      }
+      else
+      {
+         Table->Unresolved_Count++;
+         Context->Current_Line_Number = Relocation->Line_Number;
+         Report_Error(Context, "Failed to resolve \"%.*s\".", SF(Symbol->Name));
+      }
+   }
+}
 
-#define ENCODE_INSTRUCTION(Name) machine_code Name(assembler_context *Context, string Instruction)
-static ENCODE_INSTRUCTION(Encode_Instruction);
@@ -1,27 +1,6 @@
 /* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
 
-#define MNEMONICS_LIST                          \
-   X(ora) X(and) X(eor) X(adc)                  \
-   X(sta) X(lda) X(cmp) X(sbc)                  \
-                                                \
-   X(asl) X(rol) X(lsr) X(ror)                  \
-   X(stx) X(ldx) X(dec) X(inc)                  \
-                                                \
-   X(bit) X(jmp) X(sty) X(ldy)                  \
-   X(cpy) X(cpx)                                \
-                                                \
-   X(bpl) X(bmi) X(bvc) X(bvs)                  \
-   X(bcc) X(bcs) X(bne) X(beq)                  \
-                                                \
-   X(jsr)                                       \
-                                                \
-   X(brk) X(rti) X(rts) X(php)                  \
-   X(plp) X(pha) X(pla) X(dey)                  \
-   X(tay) X(iny) X(inx) X(clc)                  \
-   X(sec) X(cli) X(sei) X(tya)                  \
-   X(clv) X(cld) X(sed) X(txa)                  \
-   X(txs) X(tax) X(tsx) X(dex)                  \
-   X(nop)
+#include "mnemonics_6502.h"
 
 enum
 {
@@ -30,6 +9,10 @@ enum
 #  undef X
    MNEMONIC_COUNT,
 };
+#undef MNEMONICS_LIST // Other backends define their own.
+
+// NOTE: Generated from MNEMONICS_LIST by the build, see mnemonic_hash.h.
+#include "mnemonic_hash_6502.h"
 
 typedef enum {
    ADDRMODE_IMPLIED,
@@ -288,9 +271,11 @@ static opcode_data Encoding_Table[][ADDRMODE_COUNT] =
 };
 
 typedef struct {
-   string Unresolved_Label;
+   symbol_id Symbol; // Set whenever the operand names a label or constant.
+   symbol_id Unresolved_Symbol;
    index Length;
    s16 Value;
+   bool Speculative; // Zero page was assumed for a label that isn't defined yet.
 } parsed_operand_data;
 
 typedef struct {
@@ -311,7 +296,7 @@ static index Required_Byte_Count(opcode_data *Addressing_Modes, s16 Value)
    return(Result);
 }
 
-static parsed_operand_data Parse_Operand_Data(assembler_context *Context, string String, opcode_data *Addressing_Modes, map *Constants)
+static parsed_operand_data Parse_Operand_Data(assembler_context *Context, string String, opcode_data *Addressing_Modes)
 {
    parsed_operand_data Result = {0};
 
@@ -333,7 +318,9 @@ static parsed_operand_data Parse_Operand_Data(assembler_context *Context, string
    }
    else
    {
-      lookup_result Constant = Lookup(Constants, String);
+      symbol_id Symbol = Intern_Symbol(&Context->Symbols, String);
+      lookup_result Constant = Resolve_Symbol(Context, Symbol);
+      Result.Symbol = Symbol;
       if(Constant.Found)
       {
          // TODO: Report overflow.
@@ -343,7 +330,7 @@ static parsed_operand_data Parse_Operand_Data(assembler_context *Context, string
       else
       {
          // Label (to be populated later)
-         Result.Unresolved_Label = String;
+         Result.Unresolved_Symbol = Symbol;
       }
    }
 
@@ -351,7 +338,24 @@ static parsed_operand_data Parse_Operand_Data(assembler_context *Context, string
    return(Result);
 }
 
-static parsed_operand Parse_Operand(assembler_context *Context, string Operand, opcode_data *Addressing_Modes, map *Constants)
+static void Speculate_Zero_Page(assembler_context *Context, parsed_operand_data *Data, opcode_data *Addressing_Modes,
+                                addressing_mode Zero_Page_Mode)
+{
+   // NOTE: A label that isn't defined yet is assumed to be in zero page, as
+   // long as the instruction has a zero page form. If it turns out not to be,
+   // Relax_Lines raises the line's relaxation and it is laid out again with
+   // the absolute form. Labels of an object's own sections are never known to
+   // be in zero page, so they go straight to absolute.
+   symbol *Symbol = Context->Symbols.Symbols + Data->Unresolved_Symbol;
+   if(Data->Unresolved_Symbol && !Context->Relaxation && Addressing_Modes[Zero_Page_Mode].Encoding_Length &&
+      !(Context->Relocatable_Output && Symbol->Defined))
+   {
+      Data->Length = 1;
+      Data->Speculative = true;
+   }
+}
+
+static parsed_operand Parse_Operand(assembler_context *Context, string Operand, opcode_data *Addressing_Modes)
 {
    parsed_operand Result = {0};
 
@@ -372,12 +376,12 @@ static parsed_operand Parse_Operand(assembler_context *Context, string Operand,
       if(Has_Suffix_Then_Remove(&Operand, S(" + x]]")))
       {
          Addressing_Mode = ADDRMODE_INDIRECTX;
-         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes, Constants);
+         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes);
       }
       else if(Has_Suffix_Then_Remove(&Operand, S("] + y]")))
       {
          Addressing_Mode = ADDRMODE_INDIRECTY;
-         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes, Constants);
+         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes);
       }
       else
       {
@@ -388,21 +392,24 @@ static parsed_operand Parse_Operand(assembler_context *Context, string Operand,
    {
       if(Has_Suffix_Then_Remove(&Operand, S(" + x]")))
       {
-         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes, Constants);
+         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes);
+         Speculate_Zero_Page(Context, &Data, Addressing_Modes, ADDRMODE_ZEROPAGEX);
          Addressing_Mode = (Data.Length == 1)
             ? ADDRMODE_ZEROPAGEX
             : ADDRMODE_ABSOLUTEX;
       }
       else if(Has_Suffix_Then_Remove(&Operand, S(" + y]")))
       {
-         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes, Constants);
+         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes);
+         Speculate_Zero_Page(Context, &Data, Addressing_Modes, ADDRMODE_ZEROPAGEY);
          Addressing_Mode = (Data.Length == 1)
             ? ADDRMODE_ZEROPAGEY
             : ADDRMODE_ABSOLUTEY;
       }
       else if(Has_Suffix_Then_Remove(&Operand, S("]")))
       {
-         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes, Constants);
+         Data = Parse_Operand_Data(Context, Operand, Addressing_Modes);
+         Speculate_Zero_Page(Context, &Data, Addressing_Modes, ADDRMODE_ZEROPAGE);
          Addressing_Mode = (Data.Length == 1)
             ? ADDRMODE_ZEROPAGE
             : (Addressing_Modes[ADDRMODE_INDIRECT].Encoding_Length) ? ADDRMODE_INDIRECT : ADDRMODE_ABSOLUTE;
@@ -414,14 +421,14 @@ static parsed_operand Parse_Operand(assembler_context *Context, string Operand,
    }
    else if(Operand.Data[0] >= '0' && Operand.Data[0] <= '9')
    {
-      Data = Parse_Operand_Data(Context, Operand, Addressing_Modes, Constants);
+      Data = Parse_Operand_Data(Context, Operand, Addressing_Modes);
       Addressing_Mode = (Data.Length == 1)
          ? (Addressing_Modes[ADDRMODE_RELATIVE].Encoding_Length) ? ADDRMODE_RELATIVE : ADDRMODE_IMMEDIATE
          : ADDRMODE_ABSOLUTE;
    }
    else // Label/Constant
    {
-      Data = Parse_Operand_Data(Context, Operand, Addressing_Modes, Constants);
+      Data = Parse_Operand_Data(Context, Operand, Addressing_Modes);
       Addressing_Mode = (Addressing_Modes[ADDRMODE_RELATIVE].Encoding_Length) ? ADDRMODE_RELATIVE : ADDRMODE_ABSOLUTE;
    }
 
@@ -438,41 +445,70 @@ static parsed_operand Parse_Operand(assembler_context *Context, string Operand,
    return(Result);
 }
 
-static map *Encoding_Map;
-
-static INITIALIZE_ARCHITECTURE(Initialize_Architecture)
+static INITIALIZE_ARCHITECTURE(Initialize_6502)
 {
+   // NOTE: The mnemonic lookup table is generated at build time, so there is
+   // nothing to construct here.
+   (void)Context;
    assert(Array_Count(Encoding_Table) == MNEMONIC_COUNT);
-
-#  define X(M) Insert(&Context->Arena, &Encoding_Map, S(#M), MNEMONIC_##M);
-   MNEMONICS_LIST;
-#  undef X
 }
 
-static ENCODE_INSTRUCTION(Encode_Instruction)
+static ENCODE_INSTRUCTION(Encode_Instruction_6502)
 {
    machine_code Result = {0};
 
    cut Instruction_Operand = Cut_Whitespace(Instruction);
    string Mnemonic_String = Instruction_Operand.Before;
 
-   lookup_result Mnemonic = Lookup(Encoding_Map, Mnemonic_String);
+   mnemonic_lookup Mnemonic = Lookup_Mnemonic(&Mnemonic_Hash_6502, Mnemonic_String);
    if(Mnemonic.Found)
    {
       string Operand_String = Trim_Left(Instruction_Operand.After);
-      opcode_data *Addressing_Modes = Encoding_Table[Mnemonic.Value];
-      parsed_operand Operand = Parse_Operand(Context, Operand_String, Addressing_Modes, Context->Constants);
-      if(Operand.Data.Unresolved_Label.Length)
-      {
-         Request_Patch(&Context->Arena, &Result, Operand.Data.Unresolved_Label, 1, Operand.Data.Length);
-      }
-
+      opcode_data *Addressing_Modes = Encoding_Table[Mnemonic.Mnemonic];
+      parsed_operand Operand = Parse_Operand(Context, Operand_String, Addressing_Modes);
       opcode_data Opcode_Data = Addressing_Modes[Operand.Addressing_Mode];
 
-      Result.Length = Opcode_Data.Encoding_Length;
-      Result.Bytes[0] = Opcode_Data.Opcode;
-      if(Result.Length > 1) Result.Bytes[1] = (u8)(Operand.Data.Value << 0);
-      if(Result.Length > 2) Result.Bytes[2] = (u8)(Operand.Data.Value << 8);
+      if(Operand.Addressing_Mode == ADDRMODE_RELATIVE && Operand.Data.Symbol && Context->Relaxation)
+      {
+         // NOTE: The label is out of reach of a branch, so branch on the
+         // opposite condition, bit 5 of the opcode, over a jmp to it.
+         Result.Length = 5;
+         Result.Bytes[0] = Opcode_Data.Opcode ^ 0x20;
+         Result.Bytes[1] = 3;
+         Result.Bytes[2] = Encoding_Table[MNEMONIC_jmp][ADDRMODE_ABSOLUTE].Opcode;
+         Result.Bytes[3] = (u8)(Operand.Data.Value >> 0);
+         Result.Bytes[4] = (u8)(Operand.Data.Value >> 8);
+         if(Operand.Data.Unresolved_Symbol)
+         {
+            Request_Relocation(Context, Operand.Data.Unresolved_Symbol, Context->Current_Address + 3,
+                               2, RELOCATION_ABSOLUTE, ENDIAN_LITTLE);
+         }
+      }
+      else
+      {
+         if(Operand.Addressing_Mode == ADDRMODE_RELATIVE && Operand.Data.Symbol)
+         {
+            // NOTE: Branches to labels encode the displacement from the next
+            // instruction, which is only known once the label's address is.
+            Request_Relaxable_Relocation(Context, Operand.Data.Symbol, Context->Current_Address + 1,
+                                         1, RELOCATION_RELATIVE_8, ENDIAN_LITTLE);
+         }
+         else if(Operand.Data.Speculative)
+         {
+            Request_Relaxable_Relocation(Context, Operand.Data.Unresolved_Symbol, Context->Current_Address + 1,
+                                         1, RELOCATION_ABSOLUTE, ENDIAN_LITTLE);
+         }
+         else if(Operand.Data.Unresolved_Symbol)
+         {
+            Request_Relocation(Context, Operand.Data.Unresolved_Symbol, Context->Current_Address + 1,
+                               Opcode_Data.Encoding_Length - 1, RELOCATION_ABSOLUTE, ENDIAN_LITTLE);
+         }
+
+         Result.Length = Opcode_Data.Encoding_Length;
+         Result.Bytes[0] = Opcode_Data.Opcode;
+         if(Result.Length > 1) Result.Bytes[1] = (u8)(Operand.Data.Value >> 0);
+         if(Result.Length > 2) Result.Bytes[2] = (u8)(Operand.Data.Value >> 8);
+      }
    }
    else
    {
@@ -481,3 +517,13 @@ static ENCODE_INSTRUCTION(Encode_Instruction)
 
    return(Result);
 }
+
+static architecture Architecture_6502 =
+{
+   .Name = "6502",
+   .Endianness = ENDIAN_LITTLE,
+   .Relocation_Kinds = (RELOCATION_KIND_BIT(RELOCATION_ABSOLUTE) |
+                       RELOCATION_KIND_BIT(RELOCATION_RELATIVE_8)),
+   .Initialize = Initialize_6502,
+   .Encode_Instruction = Encode_Instruction_6502,
+};
@@ -1,5 +1,20 @@
 /* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
 
+#include "mnemonics_armv4.h"
+
+enum
+{
+#  define X(M) ARMV4_MNEMONIC_##M,
+   MNEMONICS_LIST
+#  undef X
+   ARMV4_MNEMONIC_COUNT,
+};
+#undef MNEMONICS_LIST
+#undef MNEMONIC_PREFIX
+
+// NOTE: Generated from MNEMONICS_LIST by the build, see mnemonic_hash.h.
+#include "mnemonic_hash_armv4.h"
+
 typedef enum {
    CONDITION_CODE_EQ    = 0x0, // Equal (Z set)
    CONDITION_CODE_NE    = 0x1, // Not equal (Z clear)
@@ -40,16 +55,1562 @@ typedef enum {
    OPCODE_MVN = 0xF, // Move Not
 } opcode;
 
-static INITIALIZE_ARCHITECTURE(Initialize_Architecture)
+typedef enum {
+   ARM_SHIFT_LSL = 0x0,
+   ARM_SHIFT_LSR = 0x1,
+   ARM_SHIFT_ASR = 0x2,
+   ARM_SHIFT_ROR = 0x3,
+} arm_shift;
+
+enum
+{
+   // NOTE: Values of Context->Instruction_Set, which starts out as ARM.
+   ARM_INSTRUCTION_SET_ARM   = 0,
+   ARM_INSTRUCTION_SET_THUMB = 1,
+};
+
+static char ARM_Condition_Names[][3] =
+{
+   [CONDITION_CODE_EQ]    = "eq", [CONDITION_CODE_NE]    = "ne",
+   [CONDITION_CODE_CS_HS] = "cs", [CONDITION_CODE_CC_LO] = "cc",
+   [CONDITION_CODE_MI]    = "mi", [CONDITION_CODE_PL]    = "pl",
+   [CONDITION_CODE_VS]    = "vs", [CONDITION_CODE_VC]    = "vc",
+   [CONDITION_CODE_HI]    = "hi", [CONDITION_CODE_LS]    = "ls",
+   [CONDITION_CODE_GE]    = "ge", [CONDITION_CODE_LT]    = "lt",
+   [CONDITION_CODE_GT]    = "gt", [CONDITION_CODE_LE]    = "le",
+   [CONDITION_CODE_AL]    = "al",
+};
+
+static char ARM_Shift_Names[][4] =
+{
+   [ARM_SHIFT_LSL] = "lsl",
+   [ARM_SHIFT_LSR] = "lsr",
+   [ARM_SHIFT_ASR] = "asr",
+   [ARM_SHIFT_ROR] = "ror",
+};
+
+// NOTE: A data-processing immediate is an 8-bit value rotated right by an even
+// amount. Every encodable value (3073 distinct ones) is put in a hash table
+// when the backend is initialized, mapped to its 12-bit operand field, so
+// checking an operand is one multiply and usually a single probe. Values are
+// inserted smallest rotation first, which is the canonical encoding.
+
+#define ARM_IMMEDIATE_SLOT_BITS 13
+#define ARM_IMMEDIATE_SLOT_COUNT (1 << ARM_IMMEDIATE_SLOT_BITS)
+
+typedef struct {
+   u32 Value;
+   u16 Field;
+   u16 Used;
+} arm_immediate_slot;
+
+static arm_immediate_slot *ARM_Immediate_Slots;
+
+static u32 ARM_Immediate_Slot_Index(u32 Value)
+{
+   u32 Result = (Value * 0x9E3779B1u) >> (32 - ARM_IMMEDIATE_SLOT_BITS);
+   return(Result);
+}
+
+static u32 Rotate_Right_32(u32 Value, int Amount)
+{
+   u32 Result = (Amount & 31) ? ((Value >> (Amount & 31)) | (Value << (32 - (Amount & 31)))) : Value;
+   return(Result);
+}
+
+static bool ARM_Encode_Immediate(u32 Value, u32 *Field)
+{
+   bool Result = false;
+
+   u32 Mask = ARM_IMMEDIATE_SLOT_COUNT - 1;
+   for(u32 Index = ARM_Immediate_Slot_Index(Value); ARM_Immediate_Slots[Index].Used; Index = (Index + 1) & Mask)
+   {
+      if(ARM_Immediate_Slots[Index].Value == Value)
+      {
+         *Field = ARM_Immediate_Slots[Index].Field;
+         Result = true;
+         break;
+      }
+   }
+
+   return(Result);
+}
+
+typedef struct {
+   bool Found;
+   u32 Mnemonic;
+   condition_code Condition;
+   bool Set_Flags;
+} arm_mnemonic;
+
+static bool ARM_Parse_Condition(string Suffix, condition_code *Condition)
+{
+   bool Result = false;
+   if(Suffix.Length == 2)
+   {
+      if(Equals(Suffix, S("hs")))      { *Condition = CONDITION_CODE_CS_HS; Result = true; }
+      else if(Equals(Suffix, S("lo"))) { *Condition = CONDITION_CODE_CC_LO; Result = true; }
+
+      for(int Code = 0; !Result && Code < Array_Count(ARM_Condition_Names); ++Code)
+      {
+         if(Suffix.Data[0] == ARM_Condition_Names[Code][0] && Suffix.Data[1] == ARM_Condition_Names[Code][1])
+         {
+            *Condition = (condition_code)Code;
+            Result = true;
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static arm_mnemonic ARM_Parse_Mnemonic(string Mnemonic)
+{
+   // NOTE: Split a mnemonic into its base and suffixes, trying the longest
+   // base first so that e.g. "bls" is b + ls rather than bl + s. Flags may be
+   // set before or after the condition (adds{cond} and add{cond}s), and the
+   // older ldr{cond}b form is accepted for byte and halfword transfers.
+   arm_mnemonic Result = {0};
+
+   index Longest = (Mnemonic.Length < 5) ? Mnemonic.Length : 5;
+   for(index Base_Length = Longest; !Result.Found && Base_Length > 0; --Base_Length)
+   {
+      mnemonic_lookup Base = Lookup_Mnemonic(&Mnemonic_Hash_armv4, (string){Mnemonic.Data, Base_Length});
+      if(Base.Found)
+      {
+         arm_mnemonic Parsed = {true, Base.Mnemonic, CONDITION_CODE_AL, false};
+         string Suffix = {Mnemonic.Data + Base_Length, Mnemonic.Length - Base_Length};
+
+         bool Flags_Allowed = ((Base.Mnemonic <= ARMV4_MNEMONIC_mvn &&
+                                !(Base.Mnemonic >= ARMV4_MNEMONIC_tst && Base.Mnemonic <= ARMV4_MNEMONIC_cmn)) ||
+                               Base.Mnemonic >= ARMV4_MNEMONIC_mul);
+         if(Flags_Allowed && Has_Prefix_Then_Remove(&Suffix, S("s")))
+         {
+            Parsed.Set_Flags = true;
+         }
+         if(Suffix.Length >= 2 && ARM_Parse_Condition((string){Suffix.Data, 2}, &Parsed.Condition))
+         {
+            Suffix = Remove_Prefix(Suffix, (string){Suffix.Data, 2});
+         }
+         if(Flags_Allowed && !Parsed.Set_Flags && Has_Prefix_Then_Remove(&Suffix, S("s")))
+         {
+            Parsed.Set_Flags = true;
+         }
+         if(Base.Mnemonic == ARMV4_MNEMONIC_ldr || Base.Mnemonic == ARMV4_MNEMONIC_str)
+         {
+            bool Load = (Base.Mnemonic == ARMV4_MNEMONIC_ldr);
+            if(Has_Prefix_Then_Remove(&Suffix, S("b")))
+            {
+               Parsed.Mnemonic = (Load) ? ARMV4_MNEMONIC_ldrb : ARMV4_MNEMONIC_strb;
+            }
+            else if(Has_Prefix_Then_Remove(&Suffix, S("h")))
+            {
+               Parsed.Mnemonic = (Load) ? ARMV4_MNEMONIC_ldrh : ARMV4_MNEMONIC_strh;
+            }
+            else if(Load && Has_Prefix_Then_Remove(&Suffix, S("sb")))
+            {
+               Parsed.Mnemonic = ARMV4_MNEMONIC_ldrsb;
+            }
+            else if(Load && Has_Prefix_Then_Remove(&Suffix, S("sh")))
+            {
+               Parsed.Mnemonic = ARMV4_MNEMONIC_ldrsh;
+            }
+         }
+
+         if(Suffix.Length == 0)
+         {
+            Result = Parsed;
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static string ARM_Next_Operand(string *Operands)
+{
+   // NOTE: Operands are separated by commas, except inside brackets and
+   // register lists.
+   int Depth = 0;
+   index Index = 0;
+   for(; Index < Operands->Length; ++Index)
+   {
+      u8 Character = Operands->Data[Index];
+      if(Character == '[' || Character == '{') Depth++;
+      else if(Character == ']' || Character == '}') Depth--;
+      else if(Character == ',' && Depth == 0) break;
+   }
+
+   string Result = Trim((string){Operands->Data, Index});
+   if(Index < Operands->Length)
+   {
+      *Operands = Trim_Left((string){Operands->Data + Index + 1, Operands->Length - Index - 1});
+   }
+   else
+   {
+      *Operands = (string){0};
+   }
+
+   return(Result);
+}
+
+static int ARM_Parse_Register(string Operand)
+{
+   // NOTE: Returns -1 if the operand is not a register. Called for nearly
+   // every operand, so it avoids the general string and number parsers.
+   int Result = -1;
+
+   u8 *Data = Operand.Data;
+   if(Operand.Length == 2)
+   {
+      if(Data[0] == 'r' && Data[1] >= '0' && Data[1] <= '9') Result = Data[1] - '0';
+      else if(Data[0] == 's' && Data[1] == 'p') Result = 13;
+      else if(Data[0] == 'l' && Data[1] == 'r') Result = 14;
+      else if(Data[0] == 'p' && Data[1] == 'c') Result = 15;
+   }
+   else if(Operand.Length == 3 && Data[0] == 'r' && Data[1] == '1' && Data[2] >= '0' && Data[2] <= '5')
+   {
+      Result = 10 + (Data[2] - '0');
+   }
+
+   return(Result);
+}
+
+static bool ARM_Parse_Constant(assembler_context *Context, string Operand, s64 *Value)
+{
+   // NOTE: Immediates are number literals or constants that are already
+   // defined, since their encoding depends on the value.
+   bool Result = false;
+
+   if(Operand.Length && ((Operand.Data[0] >= '0' && Operand.Data[0] <= '9') || Operand.Data[0] == '-'))
+   {
+      parsed_integer Parsed = Parse_Integer(Operand);
+      if(Parsed.Ok)
+      {
+         *Value = Parsed.Value;
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Could not parse number literal \"%.*s\".", SF(Operand));
+      }
+   }
+   else if(Operand.Length)
+   {
+      lookup_result Constant = Resolve_Symbol(Context, Intern_Symbol(&Context->Symbols, Operand));
+      if(Constant.Found)
+      {
+         *Value = (s64)Constant.Value;
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Immediate \"%.*s\" must be a constant defined before use.", SF(Operand));
+      }
+   }
+   else
+   {
+      Report_Error(Context, "Missing operand.");
+   }
+
+   return(Result);
+}
+
+static bool ARM_Encode_Shift(assembler_context *Context, arm_shift Shift, string Amount, bool Allow_Register, u32 *Bits)
+{
+   // NOTE: Bits 4-11 of a register operand shifted by a register or a
+   // constant. Shifts by 32 (lsr and asr) are encoded as zero.
+   bool Result = false;
+
+   int Shift_Register = ARM_Parse_Register(Amount);
+   s64 Shift_Amount = 0;
+   if(Shift_Register >= 0)
+   {
+      if(Allow_Register)
+      {
+         *Bits = (Shift_Register << 8) | (Shift << 5) | (1 << 4);
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Shift by register is not allowed here: \"%.*s\".", SF(Amount));
+      }
+   }
+   else if(ARM_Parse_Constant(Context, Amount, &Shift_Amount))
+   {
+      s64 Minimum = (Shift == ARM_SHIFT_LSL) ? 0 : 1;
+      s64 Maximum = (Shift == ARM_SHIFT_LSR || Shift == ARM_SHIFT_ASR) ? 32 : 31;
+      if(Shift_Amount >= Minimum && Shift_Amount <= Maximum)
+      {
+         *Bits = ((Shift_Amount & 31) << 7) | (Shift << 5);
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Shift amount %lld is out of range for %s.", (long long)Shift_Amount, ARM_Shift_Names[Shift]);
+      }
+   }
+
+   return(Result);
+}
+
+static bool ARM_Parse_Shift(assembler_context *Context, string Operand, bool Allow_Register, u32 *Bits)
+{
+   // NOTE: Produces bits 4-11 of a register operand: "lsl 2", "lsr r3" or
+   // "rrx".
+   bool Result = false;
+
+   if(Equals(Operand, S("rrx")))
+   {
+      *Bits = ARM_SHIFT_ROR << 5;
+      Result = true;
+   }
+   else
+   {
+      cut Parts = Cut_Whitespace(Operand);
+      string Amount = Trim(Parts.After);
+
+      int Shift = -1;
+      for(int Index = 0; Index < Array_Count(ARM_Shift_Names); ++Index)
+      {
+         if(Equals(Parts.Before, From_C_String(ARM_Shift_Names[Index])))
+         {
+            Shift = Index;
+         }
+      }
+
+      if(Shift < 0)
+      {
+         Report_Error(Context, "Unrecognized shift \"%.*s\".", SF(Operand));
+      }
+      else
+      {
+         Result = ARM_Encode_Shift(Context, (arm_shift)Shift, Amount, Allow_Register, Bits);
+      }
+   }
+
+   return(Result);
+}
+
+static bool ARM_Parse_Register_Operand(assembler_context *Context, string Register, string Shift, bool Allow_Register_Shift, u32 *Bits)
+{
+   // NOTE: A register, optionally shifted, as bits 0-11 of an instruction.
+   bool Result = false;
+
+   int Rm = ARM_Parse_Register(Register);
+   if(Rm >= 0)
+   {
+      u32 Shift_Bits = 0;
+      Result = (Shift.Length == 0) || ARM_Parse_Shift(Context, Shift, Allow_Register_Shift, &Shift_Bits);
+      *Bits = Shift_Bits | Rm;
+   }
+   else
+   {
+      Report_Error(Context, "Expected a register, got \"%.*s\".", SF(Register));
+   }
+
+   return(Result);
+}
+
+static bool ARM_Encode_Data_Processing(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   // NOTE: <op> rd, rn, <operand2> in general, with no rn for mov and mvn and
+   // no rd for the comparisons, which always set flags.
+   bool Result = false;
+
+   u32 Opcode = Mnemonic.Mnemonic;
+   bool Has_Rd = !(Opcode >= OPCODE_TST && Opcode <= OPCODE_CMN);
+   bool Has_Rn = !(Opcode == OPCODE_MOV || Opcode == OPCODE_MVN);
+   bool Set_Flags = Mnemonic.Set_Flags || !Has_Rd;
+
+   int Rd = 0;
+   int Rn = 0;
+   string Operand = ARM_Next_Operand(&Operands);
+   if(Has_Rd)
+   {
+      Rd = ARM_Parse_Register(Operand);
+      Operand = ARM_Next_Operand(&Operands);
+   }
+   if(Has_Rn)
+   {
+      Rn = ARM_Parse_Register(Operand);
+      Operand = ARM_Next_Operand(&Operands);
+   }
+   string Shift = ARM_Next_Operand(&Operands);
+
+   if(Rd < 0 || Rn < 0)
+   {
+      Report_Error(Context, "Expected a register operand.");
+   }
+   else if(Operands.Length)
+   {
+      Report_Error(Context, "Too many operands: \"%.*s\".", SF(Operands));
+   }
+   else if(ARM_Parse_Register(Operand) >= 0)
+   {
+      u32 Operand_Bits = 0;
+      if(ARM_Parse_Register_Operand(Context, Operand, Shift, true, &Operand_Bits))
+      {
+         *Encoding = (Opcode << 21) | (Set_Flags << 20) | (Rn << 16) | (Rd << 12) | Operand_Bits;
+         Result = true;
+      }
+   }
+   else if(Shift.Length)
+   {
+      Report_Error(Context, "An immediate operand can't be shifted.");
+   }
+   else
+   {
+      s64 Value = 0;
+      if(ARM_Parse_Constant(Context, Operand, &Value))
+      {
+         // NOTE: A value that doesn't fit may still fit the complementary
+         // instruction, e.g. mov r0, 0xFFFFFF00 as mvn r0, 0xFF.
+         u32 Field = 0;
+         if(Value < -(s64)0x80000000 || Value > 0xFFFFFFFF)
+         {
+            Report_Error(Context, "Immediate %lld does not fit in 32 bits.", (long long)Value);
+         }
+         else if(ARM_Encode_Immediate((u32)Value, &Field))
+         {
+            Result = true;
+         }
+         else
+         {
+            u32 Complement = 0;
+            u32 Other_Opcode = Opcode;
+            switch(Opcode)
+            {
+               case OPCODE_MOV: { Other_Opcode = OPCODE_MVN; Complement = ~(u32)Value; } break;
+               case OPCODE_MVN: { Other_Opcode = OPCODE_MOV; Complement = ~(u32)Value; } break;
+               case OPCODE_AND: { Other_Opcode = OPCODE_BIC; Complement = ~(u32)Value; } break;
+               case OPCODE_BIC: { Other_Opcode = OPCODE_AND; Complement = ~(u32)Value; } break;
+               case OPCODE_ADC: { Other_Opcode = OPCODE_SBC; Complement = ~(u32)Value; } break;
+               case OPCODE_SBC: { Other_Opcode = OPCODE_ADC; Complement = ~(u32)Value; } break;
+               case OPCODE_ADD: { Other_Opcode = OPCODE_SUB; Complement = -(u32)Value; } break;
+               case OPCODE_SUB: { Other_Opcode = OPCODE_ADD; Complement = -(u32)Value; } break;
+               case OPCODE_CMP: { Other_Opcode = OPCODE_CMN; Complement = -(u32)Value; } break;
+               case OPCODE_CMN: { Other_Opcode = OPCODE_CMP; Complement = -(u32)Value; } break;
+            }
+
+            if(Other_Opcode != Opcode && ARM_Encode_Immediate(Complement, &Field))
+            {
+               Opcode = Other_Opcode;
+               Result = true;
+            }
+            else
+            {
+               Report_Error(Context, "Immediate 0x%llx can't be encoded as a rotated 8-bit value.", (unsigned long long)(u32)Value);
+            }
+         }
+
+         if(Result)
+         {
+            *Encoding = (1 << 25) | (Opcode << 21) | (Set_Flags << 20) | (Rn << 16) | (Rd << 12) | Field;
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static bool ARM_Encode_Offset(assembler_context *Context, string Offset, string Shift, bool Halfword, u32 *Encoding)
+{
+   // NOTE: The offset of a load or store: a 12-bit magnitude, or a register
+   // shifted by a constant, with the sign in the U bit. Halfword and signed
+   // transfers only have an 8-bit magnitude, split around bits 4-7, or an
+   // unshifted register.
+   bool Result = false;
+
+   bool Negative = Has_Prefix_Then_Remove(&Offset, S("-"));
+   if(ARM_Parse_Register(Offset) >= 0)
+   {
+      u32 Operand_Bits = 0;
+      if(Halfword && Shift.Length)
+      {
+         Report_Error(Context, "A halfword or signed transfer can't shift its offset.");
+      }
+      else if(ARM_Parse_Register_Operand(Context, Offset, Shift, false, &Operand_Bits))
+      {
+         *Encoding |= (!Halfword << 25) | (!Negative << 23) | Operand_Bits;
+         Result = true;
+      }
+   }
+   else if(Shift.Length)
+   {
+      Report_Error(Context, "An immediate offset can't be shifted.");
+   }
+   else
+   {
+      s64 Value = 0;
+      if(ARM_Parse_Constant(Context, Offset, &Value))
+      {
+         if(Negative)
+         {
+            Value = -Value;
+         }
+
+         s64 Magnitude = (Value < 0) ? -Value : Value;
+         s64 Limit = (Halfword) ? 0xFF : 0xFFF;
+         if(Magnitude > Limit)
+         {
+            Report_Error(Context, "Offset %lld is out of range, the limit is %lld.", (long long)Value, (long long)Limit);
+         }
+         else if(Halfword)
+         {
+            *Encoding |= (1 << 22) | ((Value >= 0) << 23) | ((u32)(Magnitude & 0xF0) << 4) | (u32)(Magnitude & 0xF);
+            Result = true;
+         }
+         else
+         {
+            *Encoding |= ((Value >= 0) << 23) | (u32)Magnitude;
+            Result = true;
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static bool ARM_Encode_Load_Literal(assembler_context *Context, int Rd, string Literal, u32 *Encoding)
+{
+   // NOTE: ldr rd, =value. A known value that fits a data-processing immediate
+   // becomes a mov or mvn, anything else is loaded from the literal pool.
+   bool Result = false;
+
+   s64 Value = 0;
+   bool Known = false;
+   symbol_id Symbol = 0;
+   if(Literal.Length && ((Literal.Data[0] >= '0' && Literal.Data[0] <= '9') || Literal.Data[0] == '-'))
+   {
+      Known = ARM_Parse_Constant(Context, Literal, &Value);
+      if(Known && (Value < -(s64)0x80000000 || Value > 0xFFFFFFFF))
+      {
+         Report_Error(Context, "Literal %lld does not fit in 32 bits.", (long long)Value);
+         Known = false;
+      }
+   }
+   else if(Literal.Length)
+   {
+      Symbol = Intern_Symbol(&Context->Symbols, Literal);
+      lookup_result Lookup = Resolve_Symbol(Context, Symbol);
+      Known = Lookup.Found;
+      Value = (s64)Lookup.Value;
+   }
+   else
+   {
+      Report_Error(Context, "Missing literal after \"=\".");
+   }
+
+   u32 Field = 0;
+   if(Known && ARM_Encode_Immediate((u32)Value, &Field))
+   {
+      *Encoding = (1 << 25) | (OPCODE_MOV << 21) | (Rd << 12) | Field;
+      Result = true;
+   }
+   else if(Known && ARM_Encode_Immediate(~(u32)Value, &Field))
+   {
+      *Encoding = (1 << 25) | (OPCODE_MVN << 21) | (Rd << 12) | Field;
+      Result = true;
+   }
+   else if(Known || Symbol)
+   {
+      // NOTE: The entry is within 4095 bytes of PC + 8 either way.
+      index PC = Context->Current_Address + 8;
+      symbol_id Label = (Known)
+         ? Add_Literal(Context, (u32)Value, false, 4, PC - 0xFFF, PC + 0xFFF)
+         : Add_Literal(Context, Symbol, true, 4, PC - 0xFFF, PC + 0xFFF);
+
+      if(Label)
+      {
+         Request_Relocation(Context, Label, Context->Current_Address, 4, RELOCATION_ARM_LOAD12, ENDIAN_LITTLE);
+         *Encoding = (1 << 26) | (1 << 24) | (1 << 23) | (1 << 20) | (15 << 16) | (Rd << 12);
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static bool ARM_Encode_Load_Store(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   // NOTE: ldr rd, [rn{, offset}]{!} for pre-indexing, or ldr rd, [rn], offset
+   // for post-indexing, or ldr rd, =value for a literal.
+   bool Result = false;
+
+   u32 Op = Mnemonic.Mnemonic;
+   bool Load = (Op == ARMV4_MNEMONIC_ldr || Op == ARMV4_MNEMONIC_ldrb || Op == ARMV4_MNEMONIC_ldrh ||
+                Op == ARMV4_MNEMONIC_ldrsb || Op == ARMV4_MNEMONIC_ldrsh);
+   bool Byte = (Op == ARMV4_MNEMONIC_ldrb || Op == ARMV4_MNEMONIC_strb);
+   bool Halfword = (Op >= ARMV4_MNEMONIC_ldrh && Op <= ARMV4_MNEMONIC_ldrsh);
+
+   int Rd = ARM_Parse_Register(ARM_Next_Operand(&Operands));
+   string Address = ARM_Next_Operand(&Operands);
+   bool Write_Back = Has_Suffix_Then_Remove(&Address, S("!"));
+
+   if(Rd < 0)
+   {
+      Report_Error(Context, "Expected a register operand.");
+   }
+   else if(Has_Prefix_Then_Remove(&Address, S("=")))
+   {
+      if(Mnemonic.Mnemonic != ARMV4_MNEMONIC_ldr)
+      {
+         Report_Error(Context, "Only ldr can load a literal.");
+      }
+      else if(Operands.Length || Write_Back)
+      {
+         Report_Error(Context, "Expected a single literal, e.g. ldr r0, =0x04000000.");
+      }
+      else
+      {
+         Result = ARM_Encode_Load_Literal(Context, Rd, Trim_Left(Address), Encoding);
+      }
+   }
+   else if(!Has_Prefix_Then_Remove(&Address, S("[")) || !Has_Suffix_Then_Remove(&Address, S("]")))
+   {
+      Report_Error(Context, "Expected an address in brackets, e.g. [r1, 4].");
+   }
+   else
+   {
+      int Rn = ARM_Parse_Register(ARM_Next_Operand(&Address));
+      u32 Bits = (1 << 26) | (Byte << 22) | (Load << 20) | (Rd << 12);
+      if(Halfword)
+      {
+         // NOTE: S and H select between ldrh/strh, ldrsb and ldrsh.
+         bool Signed = (Op == ARMV4_MNEMONIC_ldrsb || Op == ARMV4_MNEMONIC_ldrsh);
+         bool Half = (Op != ARMV4_MNEMONIC_ldrsb);
+         Bits = (Load << 20) | (Rd << 12) | (1 << 7) | (Signed << 6) | (Half << 5) | (1 << 4);
+      }
+
+      if(Rn < 0)
+      {
+         Report_Error(Context, "Expected a base register.");
+      }
+      else if(Address.Length && !Operands.Length)
+      {
+         // NOTE: Pre-indexed, with the offset inside the brackets.
+         string Offset = ARM_Next_Operand(&Address);
+         string Shift = ARM_Next_Operand(&Address);
+         Bits |= (1 << 24) | (Write_Back << 21) | (Rn << 16);
+         if(Address.Length)
+         {
+            Report_Error(Context, "Too many operands in address: \"%.*s\".", SF(Address));
+         }
+         else
+         {
+            Result = ARM_Encode_Offset(Context, Offset, Shift, Halfword, &Bits);
+         }
+      }
+      else if(Operands.Length && !Write_Back)
+      {
+         // NOTE: Post-indexed, which always writes back without the W bit.
+         string Offset = ARM_Next_Operand(&Operands);
+         string Shift = ARM_Next_Operand(&Operands);
+         Bits |= (Rn << 16);
+         if(Address.Length || Operands.Length)
+         {
+            Report_Error(Context, "Unsupported addressing form for %s.", (Load) ? "a load" : "a store");
+         }
+         else
+         {
+            Result = ARM_Encode_Offset(Context, Offset, Shift, Halfword, &Bits);
+         }
+      }
+      else if(!Address.Length && !Operands.Length)
+      {
+         Bits |= (1 << 24) | (1 << 23) | (Halfword << 22) | (Write_Back << 21) | (Rn << 16);
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Unsupported addressing form for %s.", (Load) ? "a load" : "a store");
+      }
+
+      if(Result)
+      {
+         *Encoding = Bits;
+      }
+   }
+
+   return(Result);
+}
+
+static bool ARM_Encode_Branch(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   // NOTE: Targets are always labels and always go through a relocation,
+   // since the offset depends on this instruction's own address.
+   bool Result = false;
+
+   string Target = ARM_Next_Operand(&Operands);
+   if(Target.Length == 0 || Operands.Length)
+   {
+      Report_Error(Context, "Expected a single branch target.");
+   }
+   else if((Target.Data[0] >= '0' && Target.Data[0] <= '9') || ARM_Parse_Register(Target) >= 0)
+   {
+      Report_Error(Context, "Branch target must be a label: \"%.*s\".", SF(Target));
+   }
+   else
+   {
+      symbol_id Symbol = Intern_Symbol(&Context->Symbols, Target);
+      Request_Relocation(Context, Symbol, Context->Current_Address, 4, RELOCATION_ARM_BRANCH24, ENDIAN_LITTLE);
+
+      *Encoding = (0x5 << 25) | ((Mnemonic.Mnemonic == ARMV4_MNEMONIC_bl) << 24);
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool ARM_Parse_Register_List(assembler_context *Context, string Operand, u32 *List)
+{
+   // NOTE: A register list such as {r0-r3, r7, lr}, as a bit per register.
+   bool Result = false;
+
+   if(Has_Prefix_Then_Remove(&Operand, S("{")) && Has_Suffix_Then_Remove(&Operand, S("}")))
+   {
+      Result = true;
+      *List = 0;
+
+      cut Items = {0};
+      Items.After = Trim(Operand);
+      while(Result && Items.After.Length)
+      {
+         Items = Cut(Items.After, ',');
+         cut Range = Cut(Trim(Items.Before), '-');
+         int First = ARM_Parse_Register(Trim(Range.Before));
+         int Last = (Range.Found) ? ARM_Parse_Register(Trim(Range.After)) : First;
+
+         if(First < 0 || Last < First)
+         {
+            Report_Error(Context, "Invalid register list entry \"%.*s\".", SF(Trim(Items.Before)));
+            Result = false;
+         }
+         for(int Register = First; Result && Register <= Last; ++Register)
+         {
+            *List |= 1u << Register;
+         }
+      }
+
+      if(Result && *List == 0)
+      {
+         Report_Error(Context, "The register list is empty.");
+         Result = false;
+      }
+   }
+   else
+   {
+      Report_Error(Context, "Expected a register list in braces, e.g. {r4-r7, lr}.");
+   }
+
+   return(Result);
+}
+
+static int ARM_Split_Operands(assembler_context *Context, string Operands, string *Results, int Capacity)
+{
+   // NOTE: Returns the operand count, or -1 if there are too many.
+   int Result = 0;
+   while(Result >= 0 && Operands.Length)
+   {
+      if(Result == Capacity)
+      {
+         Report_Error(Context, "Too many operands: \"%.*s\".", SF(Operands));
+         Result = -1;
+      }
+      else
+      {
+         Results[Result++] = ARM_Next_Operand(&Operands);
+      }
+   }
+
+   return(Result);
+}
+
+static bool ARM_Encode_Block_Transfer(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   // NOTE: ldmia/stmia rn{!}, {list}, and push and pop as their full
+   // descending stack forms, stmdb sp! and ldmia sp!.
+   bool Result = false;
+
+   u32 Op = Mnemonic.Mnemonic;
+   bool Load = (Op == ARMV4_MNEMONIC_ldmia || Op == ARMV4_MNEMONIC_pop);
+
+   string Base = (Op == ARMV4_MNEMONIC_push || Op == ARMV4_MNEMONIC_pop) ? S("sp!") : ARM_Next_Operand(&Operands);
+   bool Write_Back = Has_Suffix_Then_Remove(&Base, S("!"));
+   int Rn = ARM_Parse_Register(Trim(Base));
+   string List_Operand = ARM_Next_Operand(&Operands);
+
+   u32 List = 0;
+   if(Rn < 0)
+   {
+      Report_Error(Context, "Expected a base register.");
+   }
+   else if(Operands.Length)
+   {
+      Report_Error(Context, "Too many operands: \"%.*s\".", SF(Operands));
+   }
+   else if(ARM_Parse_Register_List(Context, List_Operand, &List))
+   {
+      bool Before = (Op == ARMV4_MNEMONIC_push);
+      *Encoding = (1 << 27) | (Before << 24) | (!Before << 23) | (Write_Back << 21) | (Load << 20) | (Rn << 16) | List;
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool ARM_Encode_Miscellaneous(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   // NOTE: bx, swi, mul, and neg and the shifts, which are aliases of rsb and
+   // mov with a shifted register.
+   bool Result = false;
+
+   string Operand[3];
+   int Count = ARM_Split_Operands(Context, Operands, Operand, Array_Count(Operand));
+   int Rd = (Count > 0) ? ARM_Parse_Register(Operand[0]) : -1;
+   u32 Set_Flags = Mnemonic.Set_Flags;
+
+   switch(Mnemonic.Mnemonic)
+   {
+      case ARMV4_MNEMONIC_bx: {
+         if(Count == 1 && Rd >= 0)
+         {
+            *Encoding = 0x012FFF10 | Rd;
+            Result = true;
+         }
+         else if(Count >= 0)
+         {
+            Report_Error(Context, "Expected a single register, e.g. bx lr.");
+         }
+      } break;
+
+      case ARMV4_MNEMONIC_swi: {
+         s64 Value = 0;
+         if(Count != 1)
+         {
+            Report_Error(Context, "Expected a single comment field, e.g. swi 0x60000.");
+         }
+         else if(ARM_Parse_Constant(Context, Operand[0], &Value))
+         {
+            if(Value >= 0 && Value <= 0xFFFFFF)
+            {
+               *Encoding = 0x0F000000 | (u32)Value;
+               Result = true;
+            }
+            else
+            {
+               Report_Error(Context, "The comment field of swi must fit in 24 bits.");
+            }
+         }
+      } break;
+
+      case ARMV4_MNEMONIC_mul: {
+         // NOTE: mul rd, rm, rs, where mul rd, rm is short for mul rd, rm, rd.
+         int Rm = (Count > 1) ? ARM_Parse_Register(Operand[1]) : -1;
+         int Rs = (Count > 2) ? ARM_Parse_Register(Operand[2]) : Rd;
+         if((Count == 2 || Count == 3) && Rd >= 0 && Rm >= 0 && Rs >= 0)
+         {
+            *Encoding = (Set_Flags << 20) | (Rd << 16) | (Rs << 8) | 0x90 | Rm;
+            Result = true;
+         }
+         else if(Count >= 0)
+         {
+            Report_Error(Context, "Expected registers, e.g. mul r0, r1, r2.");
+         }
+      } break;
+
+      case ARMV4_MNEMONIC_neg: {
+         int Rm = (Count > 1) ? ARM_Parse_Register(Operand[1]) : -1;
+         if(Count == 2 && Rd >= 0 && Rm >= 0)
+         {
+            *Encoding = (1 << 25) | (OPCODE_RSB << 21) | (Set_Flags << 20) | (Rm << 16) | (Rd << 12);
+            Result = true;
+         }
+         else if(Count >= 0)
+         {
+            Report_Error(Context, "Expected two registers, e.g. neg r0, r1.");
+         }
+      } break;
+
+      default: {
+         // NOTE: lsl rd, rm, amount, where lsl rd, amount shifts rd itself.
+         arm_shift Shift = (arm_shift)(Mnemonic.Mnemonic - ARMV4_MNEMONIC_lsl);
+         int Rm = (Count == 3) ? ARM_Parse_Register(Operand[1]) : Rd;
+         string Amount = (Count > 1) ? Operand[Count - 1] : (string){0};
+
+         u32 Shift_Bits = 0;
+         if((Count != 2 && Count != 3) || Rd < 0 || Rm < 0)
+         {
+            if(Count >= 0)
+            {
+               Report_Error(Context, "Expected e.g. %s r0, r1, 2.", ARM_Shift_Names[Shift]);
+            }
+         }
+         else if(ARM_Encode_Shift(Context, Shift, Amount, true, &Shift_Bits))
+         {
+            *Encoding = (OPCODE_MOV << 21) | (Set_Flags << 20) | (Rd << 12) | Shift_Bits | Rm;
+            Result = true;
+         }
+      } break;
+   }
+
+   return(Result);
+}
+
+// NOTE: Thumb is the 16-bit instruction set of ARMv4T, entered with #thumb and
+// left with #arm. Most instructions only reach r0-r7 and always set flags, so
+// an S suffix is accepted but changes nothing, and only b can be conditional.
+// Each instruction is encoded in the first form that fits its operands.
+
+#define THUMB_FORMAT_4_NONE 0xFF
+
+static u8 Thumb_Format_4_Opcodes[ARMV4_MNEMONIC_COUNT] =
+{
+   // NOTE: Two-register ALU operations, rd = rd <op> rs.
+   [ARMV4_MNEMONIC_and] = 0x0, [ARMV4_MNEMONIC_eor] = 0x1, [ARMV4_MNEMONIC_lsl] = 0x2, [ARMV4_MNEMONIC_lsr] = 0x3,
+   [ARMV4_MNEMONIC_asr] = 0x4, [ARMV4_MNEMONIC_adc] = 0x5, [ARMV4_MNEMONIC_sbc] = 0x6, [ARMV4_MNEMONIC_ror] = 0x7,
+   [ARMV4_MNEMONIC_tst] = 0x8, [ARMV4_MNEMONIC_neg] = 0x9, [ARMV4_MNEMONIC_cmp] = 0xA, [ARMV4_MNEMONIC_cmn] = 0xB,
+   [ARMV4_MNEMONIC_orr] = 0xC, [ARMV4_MNEMONIC_mul] = 0xD, [ARMV4_MNEMONIC_bic] = 0xE, [ARMV4_MNEMONIC_mvn] = 0xF,
+
+   [ARMV4_MNEMONIC_sub] = THUMB_FORMAT_4_NONE, [ARMV4_MNEMONIC_rsb] = THUMB_FORMAT_4_NONE,
+   [ARMV4_MNEMONIC_add] = THUMB_FORMAT_4_NONE, [ARMV4_MNEMONIC_rsc] = THUMB_FORMAT_4_NONE,
+   [ARMV4_MNEMONIC_teq] = THUMB_FORMAT_4_NONE, [ARMV4_MNEMONIC_mov] = THUMB_FORMAT_4_NONE,
+};
+
+static bool Thumb_Low(int Register)
+{
+   bool Result = (Register >= 0 && Register < 8);
+   return(Result);
+}
+
+static bool Thumb_Encode_Data_Processing(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   bool Result = false;
+
+   string Operand[3];
+   int Count = ARM_Split_Operands(Context, Operands, Operand, Array_Count(Operand));
+   if(Count < 0)
+   {
+      return(false);
+   }
+
+   int Rd = (Count > 0) ? ARM_Parse_Register(Operand[0]) : -1;
+   int Rs = (Count > 1) ? ARM_Parse_Register(Operand[1]) : -1;
+   int Rn = (Count > 2) ? ARM_Parse_Register(Operand[2]) : -1;
+   bool Immediate = (Count >= 2 && ARM_Parse_Register(Operand[Count - 1]) < 0);
+
+   s64 Value = 0;
+   u32 Op = Mnemonic.Mnemonic;
+   if(Count < 2 || Rd < 0 || (Count == 3 && Rs < 0))
+   {
+      Report_Error(Context, "Expected a register operand.");
+   }
+   else if(Immediate && !ARM_Parse_Constant(Context, Operand[Count - 1], &Value))
+   {
+      // NOTE: Already reported.
+   }
+   else if(Op == ARMV4_MNEMONIC_add || Op == ARMV4_MNEMONIC_sub)
+   {
+      // NOTE: Subtracting is adding the negated value, so either mnemonic
+      // can use the other's immediate forms.
+      bool Sub = (Op == ARMV4_MNEMONIC_sub);
+      s64 Addend = (Sub) ? -Value : Value;
+      s64 Magnitude = (Addend < 0) ? -Addend : Addend;
+      int Base = (Count == 3) ? Rs : Rd;
+
+      if(Immediate && Rd == 13 && Base == 13)
+      {
+         if((Magnitude & 3) == 0 && Magnitude <= 508)
+         {
+            *Encoding = 0xB000 | ((Addend < 0) << 7) | (u32)(Magnitude >> 2);
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Stack adjustments must be a multiple of 4 up to 508.");
+         }
+      }
+      else if(Immediate && Count == 3 && (Rs == 13 || Rs == 15))
+      {
+         if(Thumb_Low(Rd) && Addend >= 0 && Addend <= 1020 && (Addend & 3) == 0)
+         {
+            *Encoding = 0xA000 | ((Rs == 13) << 11) | (Rd << 8) | (u32)(Addend >> 2);
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Expected a low register and a multiple of 4 up to 1020.");
+         }
+      }
+      else if(Immediate)
+      {
+         if(!Thumb_Low(Rd) || !Thumb_Low(Base))
+         {
+            Report_Error(Context, "Only r0-r7 can take an immediate here.");
+         }
+         else if(Count == 3 && Magnitude <= 7)
+         {
+            *Encoding = ((Addend < 0) ? 0x1E00 : 0x1C00) | ((u32)Magnitude << 6) | (Rs << 3) | Rd;
+            Result = true;
+         }
+         else if(Rd == Base && Magnitude <= 255)
+         {
+            *Encoding = ((Addend < 0) ? 0x3800 : 0x3000) | (Rd << 8) | (u32)Magnitude;
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Immediate %lld is out of range for %s.", (long long)Value, (Sub) ? "sub" : "add");
+         }
+      }
+      else
+      {
+         // NOTE: add rd, rs is short for add rd, rd, rs.
+         int Left = (Count == 3) ? Rs : Rd;
+         int Right = (Count == 3) ? Rn : Rs;
+         if(Thumb_Low(Rd) && Thumb_Low(Left) && Thumb_Low(Right))
+         {
+            *Encoding = ((Sub) ? 0x1A00 : 0x1800) | (Right << 6) | (Left << 3) | Rd;
+            Result = true;
+         }
+         else if(!Sub && Left == Rd)
+         {
+            *Encoding = 0x4400 | ((Rd >> 3) << 7) | (Right << 3) | (Rd & 7);
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Unsupported register operands for %s.", (Sub) ? "sub" : "add");
+         }
+      }
+   }
+   else if(Op == ARMV4_MNEMONIC_mov || Op == ARMV4_MNEMONIC_cmp)
+   {
+      bool Compare = (Op == ARMV4_MNEMONIC_cmp);
+      if(Count != 2)
+      {
+         Report_Error(Context, "Expected two operands.");
+      }
+      else if(Immediate)
+      {
+         if(Thumb_Low(Rd) && Value >= 0 && Value <= 255)
+         {
+            *Encoding = ((Compare) ? 0x2800 : 0x2000) | (Rd << 8) | (u32)Value;
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Only r0-r7 and values up to 255 are allowed here.");
+         }
+      }
+      else if(Thumb_Low(Rd) && Thumb_Low(Rs))
+      {
+         // NOTE: Between low registers, mov is lsl rd, rs, 0, which is how UAL
+         // assemblers (e.g. llvm-mc, movs rd, rs) encode it. Pre-UAL Thumb
+         // assemblers emit MOV(2), add rd, rs, 0, instead. Both set N and Z,
+         // but the add also clears C and V where the lsl leaves them alone, so
+         // code ported from those may see different carry flags after a mov.
+         *Encoding = ((Compare) ? 0x4280 : 0x0000) | (Rs << 3) | Rd;
+         Result = true;
+      }
+      else
+      {
+         *Encoding = ((Compare) ? 0x4500 : 0x4600) | ((Rd >> 3) << 7) | (Rs << 3) | (Rd & 7);
+         Result = true;
+      }
+   }
+   else if(Op >= ARMV4_MNEMONIC_lsl && Op <= ARMV4_MNEMONIC_asr && Immediate)
+   {
+      // NOTE: lsl rd, rs, amount, where lsl rd, amount shifts rd itself.
+      int Source = (Count == 3) ? Rs : Rd;
+      s64 Minimum = (Op == ARMV4_MNEMONIC_lsl) ? 0 : 1;
+      s64 Maximum = (Op == ARMV4_MNEMONIC_lsl) ? 31 : 32;
+      if(!Thumb_Low(Rd) || !Thumb_Low(Source))
+      {
+         Report_Error(Context, "Only r0-r7 can be shifted.");
+      }
+      else if(Value < Minimum || Value > Maximum)
+      {
+         Report_Error(Context, "Shift amount %lld is out of range.", (long long)Value);
+      }
+      else
+      {
+         *Encoding = ((Op - ARMV4_MNEMONIC_lsl) << 11) | ((u32)(Value & 31) << 6) | (Source << 3) | Rd;
+         Result = true;
+      }
+   }
+   else if(Op == ARMV4_MNEMONIC_rsb && Immediate && Value == 0 && Count == 3)
+   {
+      *Encoding = 0x4000 | (Thumb_Format_4_Opcodes[ARMV4_MNEMONIC_neg] << 6) | (Rs << 3) | Rd;
+      Result = Thumb_Low(Rd) && Thumb_Low(Rs);
+      if(!Result)
+      {
+         Report_Error(Context, "Only r0-r7 can be negated.");
+      }
+   }
+   else if(Thumb_Format_4_Opcodes[Op] == THUMB_FORMAT_4_NONE || Immediate)
+   {
+      Report_Error(Context, "Unsupported operands for %.*s in Thumb state.", SF(Trim(Operands)));
+   }
+   else
+   {
+      // NOTE: op rd, rs, or op rd, rd, rs. Multiplying also takes mul rd, rs, rd.
+      int Source = Rs;
+      if(Count == 3)
+      {
+         Source = (Rd == Rs) ? Rn : (Op == ARMV4_MNEMONIC_mul && Rd == Rn) ? Rs : -1;
+      }
+
+      if(Thumb_Low(Rd) && Thumb_Low(Source))
+      {
+         *Encoding = 0x4000 | (Thumb_Format_4_Opcodes[Op] << 6) | (Source << 3) | Rd;
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Expected r0-r7, with the destination as the first source.");
+      }
+   }
+
+   return(Result);
+}
+
+static bool Thumb_Encode_Load_Literal(assembler_context *Context, int Rd, string Literal, u32 *Encoding)
 {
-   (void)Context;
+   // NOTE: Always loaded from the literal pool, even if the value would fit a
+   // mov, since that would also set flags.
+   bool Result = false;
+
+   s64 Value = 0;
+   symbol_id Label = 0;
+   index PC = (Context->Current_Address + 4) & ~(index)3;
+   if(Literal.Length && ((Literal.Data[0] >= '0' && Literal.Data[0] <= '9') || Literal.Data[0] == '-'))
+   {
+      if(ARM_Parse_Constant(Context, Literal, &Value))
+      {
+         if(Value < -(s64)0x80000000 || Value > 0xFFFFFFFF)
+         {
+            Report_Error(Context, "Literal %lld does not fit in 32 bits.", (long long)Value);
+         }
+         else
+         {
+            Label = Add_Literal(Context, (u32)Value, false, 4, PC, PC + 1020);
+         }
+      }
+   }
+   else if(Literal.Length)
+   {
+      symbol_id Symbol = Intern_Symbol(&Context->Symbols, Literal);
+      lookup_result Lookup = Resolve_Symbol(Context, Symbol);
+      Label = (Lookup.Found)
+         ? Add_Literal(Context, (u32)Lookup.Value, false, 4, PC, PC + 1020)
+         : Add_Literal(Context, Symbol, true, 4, PC, PC + 1020);
+   }
+   else
+   {
+      Report_Error(Context, "Missing literal after \"=\".");
+   }
+
+   if(Label)
+   {
+      Request_Relocation(Context, Label, Context->Current_Address, 2, RELOCATION_THUMB_LOAD8, ENDIAN_LITTLE);
+      *Encoding = 0x4800 | (Rd << 8);
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool Thumb_Encode_Load_Store(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   // NOTE: ldr rd, [rb, ro] or ldr rd, [rb{, offset}], with pc- and
+   // sp-relative forms for words. There is no write-back or post-indexing.
+   bool Result = false;
+
+   u32 Op = Mnemonic.Mnemonic;
+   int Rd = ARM_Parse_Register(ARM_Next_Operand(&Operands));
+   string Address = ARM_Next_Operand(&Operands);
+
+   bool Load = (Op == ARMV4_MNEMONIC_ldr || Op == ARMV4_MNEMONIC_ldrb || Op == ARMV4_MNEMONIC_ldrh ||
+                Op == ARMV4_MNEMONIC_ldrsb || Op == ARMV4_MNEMONIC_ldrsh);
+   if(!Thumb_Low(Rd))
+   {
+      Report_Error(Context, "Expected r0-r7 as the register to transfer.");
+   }
+   else if(Operands.Length)
+   {
+      Report_Error(Context, "Post-indexing is not available in Thumb state.");
+   }
+   else if(Has_Prefix_Then_Remove(&Address, S("=")))
+   {
+      if(Op == ARMV4_MNEMONIC_ldr)
+      {
+         Result = Thumb_Encode_Load_Literal(Context, Rd, Trim_Left(Address), Encoding);
+      }
+      else
+      {
+         Report_Error(Context, "Only ldr can load a literal.");
+      }
+   }
+   else if(!Has_Prefix_Then_Remove(&Address, S("[")) || !Has_Suffix_Then_Remove(&Address, S("]")))
+   {
+      Report_Error(Context, "Expected an address in brackets, e.g. [r1, 4].");
+   }
+   else
+   {
+      int Rb = ARM_Parse_Register(ARM_Next_Operand(&Address));
+      string Offset = ARM_Next_Operand(&Address);
+      int Ro = ARM_Parse_Register(Offset);
+
+      s64 Value = 0;
+      if(Address.Length)
+      {
+         Report_Error(Context, "Too many operands in address: \"%.*s\".", SF(Address));
+      }
+      else if(Ro >= 0)
+      {
+         // NOTE: Register offsets, in order of the L, B and H/S bits.
+         static u16 Register_Opcodes[] =
+         {
+            [ARMV4_MNEMONIC_str] = 0x5000, [ARMV4_MNEMONIC_strh] = 0x5200, [ARMV4_MNEMONIC_strb] = 0x5400,
+            [ARMV4_MNEMONIC_ldrsb] = 0x5600, [ARMV4_MNEMONIC_ldr] = 0x5800, [ARMV4_MNEMONIC_ldrh] = 0x5A00,
+            [ARMV4_MNEMONIC_ldrb] = 0x5C00, [ARMV4_MNEMONIC_ldrsh] = 0x5E00,
+         };
+
+         if(Thumb_Low(Rb) && Thumb_Low(Ro))
+         {
+            *Encoding = Register_Opcodes[Op] | (Ro << 6) | (Rb << 3) | Rd;
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Expected r0-r7 as base and offset registers.");
+         }
+      }
+      else if(Offset.Length == 0 || ARM_Parse_Constant(Context, Offset, &Value))
+      {
+         // NOTE: Immediate offsets are scaled by the transfer size.
+         int Scale = (Op == ARMV4_MNEMONIC_ldr || Op == ARMV4_MNEMONIC_str) ? 4 :
+                     (Op == ARMV4_MNEMONIC_ldrh || Op == ARMV4_MNEMONIC_strh) ? 2 : 1;
+         s64 Limit = (Rb == 13 || Rb == 15) ? 1020 : (31 * Scale);
+
+         if(Op == ARMV4_MNEMONIC_ldrsb || Op == ARMV4_MNEMONIC_ldrsh)
+         {
+            Report_Error(Context, "Signed loads need a register offset in Thumb state.");
+         }
+         else if(Value < 0 || Value > Limit || (Value % Scale) != 0)
+         {
+            Report_Error(Context, "Offset %lld must be a multiple of %d up to %lld.", (long long)Value, Scale, (long long)Limit);
+         }
+         else if(Rb == 15 && Op == ARMV4_MNEMONIC_ldr)
+         {
+            *Encoding = 0x4800 | (Rd << 8) | (u32)(Value >> 2);
+            Result = true;
+         }
+         else if(Rb == 13 && Scale == 4)
+         {
+            *Encoding = 0x9000 | (Load << 11) | (Rd << 8) | (u32)(Value >> 2);
+            Result = true;
+         }
+         else if(Thumb_Low(Rb))
+         {
+            u32 Opcode = (Scale == 4) ? 0x6000 : (Scale == 2) ? 0x8000 : 0x7000;
+            *Encoding = Opcode | (Load << 11) | ((u32)(Value / Scale) << 6) | (Rb << 3) | Rd;
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Unsupported base register for this transfer.");
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static bool Thumb_Encode_Block_Transfer(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   // NOTE: push and pop take r0-r7 plus lr and pc respectively, ldmia and
+   // stmia take r0-r7 and always write back.
+   bool Result = false;
+
+   u32 Op = Mnemonic.Mnemonic;
+   bool Stack = (Op == ARMV4_MNEMONIC_push || Op == ARMV4_MNEMONIC_pop);
+   bool Load = (Op == ARMV4_MNEMONIC_ldmia || Op == ARMV4_MNEMONIC_pop);
+
+   int Rb = 13;
+   bool Write_Back = true;
+   if(!Stack)
+   {
+      string Base = ARM_Next_Operand(&Operands);
+      Write_Back = Has_Suffix_Then_Remove(&Base, S("!"));
+      Rb = ARM_Parse_Register(Trim(Base));
+   }
+   string List_Operand = ARM_Next_Operand(&Operands);
+
+   u32 List = 0;
+   if(!Stack && (!Thumb_Low(Rb) || !Write_Back))
+   {
+      Report_Error(Context, "Expected r0-r7 with write-back as the base, e.g. ldmia r0!, {r1-r3}.");
+   }
+   else if(Operands.Length)
+   {
+      Report_Error(Context, "Too many operands: \"%.*s\".", SF(Operands));
+   }
+   else if(ARM_Parse_Register_List(Context, List_Operand, &List))
+   {
+      u32 Extra = (Stack) ? (1u << ((Load) ? 15 : 14)) : 0;
+      if(List & ~(0xFF | Extra))
+      {
+         Report_Error(Context, "Only r0-r7%s can be listed here.", (Stack) ? ((Load) ? " and pc" : " and lr") : "");
+      }
+      else if(Stack)
+      {
+         *Encoding = 0xB400 | (Load << 11) | (((List & Extra) != 0) << 8) | (List & 0xFF);
+         Result = true;
+      }
+      else
+      {
+         *Encoding = 0xC000 | (Load << 11) | (Rb << 8) | List;
+         Result = true;
+      }
+   }
+
+   return(Result);
 }
 
-static ENCODE_INSTRUCTION(Encode_Instruction)
+static bool Thumb_Encode_Branch(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
 {
-   (void)Context;
-   (void)Instruction;
+   // NOTE: bl is a pair of halfwords, with the first one in the low half.
+   bool Result = false;
 
+   string Target = ARM_Next_Operand(&Operands);
+   bool Link = (Mnemonic.Mnemonic == ARMV4_MNEMONIC_bl);
+   if(Target.Length == 0 || Operands.Length)
+   {
+      Report_Error(Context, "Expected a single branch target.");
+   }
+   else if((Target.Data[0] >= '0' && Target.Data[0] <= '9') || ARM_Parse_Register(Target) >= 0)
+   {
+      Report_Error(Context, "Branch target must be a label: \"%.*s\".", SF(Target));
+   }
+   else if(Link && Mnemonic.Condition != CONDITION_CODE_AL)
+   {
+      Report_Error(Context, "bl can't be conditional in Thumb state.");
+   }
+   else
+   {
+      symbol_id Symbol = Intern_Symbol(&Context->Symbols, Target);
+      if(Link)
+      {
+         Request_Relocation(Context, Symbol, Context->Current_Address, 4, RELOCATION_THUMB_BL, ENDIAN_LITTLE);
+         *Encoding = 0xF800F000;
+      }
+      else if(Mnemonic.Condition == CONDITION_CODE_AL)
+      {
+         Request_Relocation(Context, Symbol, Context->Current_Address, 2, RELOCATION_THUMB_BRANCH11, ENDIAN_LITTLE);
+         *Encoding = 0xE000;
+      }
+      else
+      {
+         Request_Relocation(Context, Symbol, Context->Current_Address, 2, RELOCATION_THUMB_BRANCH8, ENDIAN_LITTLE);
+         *Encoding = 0xD000 | (Mnemonic.Condition << 8);
+      }
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool Thumb_Encode_Instruction(assembler_context *Context, arm_mnemonic Mnemonic, string Operands, u32 *Encoding)
+{
+   bool Result = false;
+
+   u32 Op = Mnemonic.Mnemonic;
+   if(Mnemonic.Condition != CONDITION_CODE_AL && Op != ARMV4_MNEMONIC_b && Op != ARMV4_MNEMONIC_bl)
+   {
+      Report_Error(Context, "Only branches can be conditional in Thumb state.");
+   }
+   else if(Op == ARMV4_MNEMONIC_b || Op == ARMV4_MNEMONIC_bl)
+   {
+      Result = Thumb_Encode_Branch(Context, Mnemonic, Operands, Encoding);
+   }
+   else if(Op == ARMV4_MNEMONIC_bx)
+   {
+      string Operand = ARM_Next_Operand(&Operands);
+      int Rs = ARM_Parse_Register(Operand);
+      if(Rs >= 0 && !Operands.Length)
+      {
+         *Encoding = 0x4700 | (Rs << 3);
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Expected a single register, e.g. bx lr.");
+      }
+   }
+   else if(Op == ARMV4_MNEMONIC_swi)
+   {
+      s64 Value = 0;
+      if(ARM_Parse_Constant(Context, Trim(Operands), &Value))
+      {
+         if(Value >= 0 && Value <= 255)
+         {
+            *Encoding = 0xDF00 | (u32)Value;
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "The comment field of swi must fit in 8 bits in Thumb state.");
+         }
+      }
+   }
+   else if(Op >= ARMV4_MNEMONIC_ldr && Op <= ARMV4_MNEMONIC_ldrsh)
+   {
+      Result = Thumb_Encode_Load_Store(Context, Mnemonic, Operands, Encoding);
+   }
+   else if(Op >= ARMV4_MNEMONIC_ldmia && Op <= ARMV4_MNEMONIC_pop)
+   {
+      Result = Thumb_Encode_Block_Transfer(Context, Mnemonic, Operands, Encoding);
+   }
+   else
+   {
+      Result = Thumb_Encode_Data_Processing(Context, Mnemonic, Operands, Encoding);
+   }
+
+   return(Result);
+}
+
+static PARSE_DIRECTIVE(Parse_Directive_ARMv4)
+{
+   // NOTE: #thumb and #arm switch instruction sets. ARM code is word aligned,
+   // so switching back pads with a Thumb nop (mov r8, r8) if needed.
+   bool Result = true;
+   if(Equals(Directive, S("thumb")))
+   {
+      Context->Instruction_Set = ARM_INSTRUCTION_SET_THUMB;
+   }
+   else if(Equals(Directive, S("arm")))
+   {
+      if(Context->Current_Address & 2)
+      {
+         u8 *Destination = Reserve_Output(Context, Context->Current_Address, 2);
+         Destination[0] = 0xC0;
+         Destination[1] = 0x46;
+         Context->Current_Address += 2;
+      }
+      Context->Instruction_Set = ARM_INSTRUCTION_SET_ARM;
+   }
+   else
+   {
+      Result = false;
+   }
+
+   return(Result);
+}
+
+static INITIALIZE_ARCHITECTURE(Initialize_ARMv4)
+{
+   assert((int)ARMV4_MNEMONIC_mvn == (int)OPCODE_MVN);
+
+   u32 Mask = ARM_IMMEDIATE_SLOT_COUNT - 1;
+   ARM_Immediate_Slots = Allocate(&Context->Arena, arm_immediate_slot, ARM_IMMEDIATE_SLOT_COUNT);
+   for(int Rotation = 0; Rotation < 16; ++Rotation)
+   {
+      for(u32 Byte = 0; Byte < 256; ++Byte)
+      {
+         u32 Value = Rotate_Right_32(Byte, Rotation * 2);
+
+         u32 Index = ARM_Immediate_Slot_Index(Value);
+         while(ARM_Immediate_Slots[Index].Used && ARM_Immediate_Slots[Index].Value != Value)
+         {
+            Index = (Index + 1) & Mask;
+         }
+
+         if(!ARM_Immediate_Slots[Index].Used)
+         {
+            ARM_Immediate_Slots[Index].Value = Value;
+            ARM_Immediate_Slots[Index].Field = (u16)((Rotation << 8) | Byte);
+            ARM_Immediate_Slots[Index].Used = 1;
+         }
+      }
+   }
+}
+
+static ENCODE_INSTRUCTION(Encode_Instruction_ARMv4)
+{
    machine_code Result = {0};
+
+   cut Instruction_Operands = Cut_Whitespace(Instruction);
+   string Mnemonic_String = Instruction_Operands.Before;
+   string Operands = Trim(Instruction_Operands.After);
+
+   arm_mnemonic Mnemonic = ARM_Parse_Mnemonic(Mnemonic_String);
+   if(Mnemonic.Found)
+   {
+      u32 Op = Mnemonic.Mnemonic;
+      u32 Encoding = 0;
+      bool Encoded = false;
+      if(Context->Instruction_Set == ARM_INSTRUCTION_SET_THUMB)
+      {
+         Encoded = Thumb_Encode_Instruction(Context, Mnemonic, Operands, &Encoding);
+         Result.Length = (Op == ARMV4_MNEMONIC_bl) ? 4 : 2;
+      }
+      else
+      {
+         if(Op <= ARMV4_MNEMONIC_mvn)
+         {
+            Encoded = ARM_Encode_Data_Processing(Context, Mnemonic, Operands, &Encoding);
+         }
+         else if(Op == ARMV4_MNEMONIC_b || Op == ARMV4_MNEMONIC_bl)
+         {
+            Encoded = ARM_Encode_Branch(Context, Mnemonic, Operands, &Encoding);
+         }
+         else if(Op >= ARMV4_MNEMONIC_ldr && Op <= ARMV4_MNEMONIC_ldrsh)
+         {
+            Encoded = ARM_Encode_Load_Store(Context, Mnemonic, Operands, &Encoding);
+         }
+         else if(Op >= ARMV4_MNEMONIC_ldmia && Op <= ARMV4_MNEMONIC_pop)
+         {
+            Encoded = ARM_Encode_Block_Transfer(Context, Mnemonic, Operands, &Encoding);
+         }
+         else
+         {
+            Encoded = ARM_Encode_Miscellaneous(Context, Mnemonic, Operands, &Encoding);
+         }
+         Encoding |= (u32)Mnemonic.Condition << 28;
+         Result.Length = 4;
+      }
+
+      // NOTE: Instructions have a fixed size for each mnemonic, so a line that
+      // failed to encode still takes its place and later addresses don't shift.
+      for(int Byte_Index = 0; Encoded && Byte_Index < Result.Length; ++Byte_Index)
+      {
+         Result.Bytes[Byte_Index] = (u8)(Encoding >> (Byte_Index * 8));
+      }
+   }
+   else
+   {
+      Report_Error(Context, "Did not recognize mnemonic \"%.*s\".", SF(Mnemonic_String));
+   }
+
    return(Result);
 }
+
+static architecture Architecture_ARMv4 =
+{
+   .Name = "armv4",
+   .Aliases = {"armv4t"},
+   .Endianness = ENDIAN_LITTLE,
+   .Relocation_Kinds = (RELOCATION_KIND_BIT(RELOCATION_ABSOLUTE) |
+                       RELOCATION_KIND_BIT(RELOCATION_ARM_BRANCH24) |
+                       RELOCATION_KIND_BIT(RELOCATION_ARM_LOAD12) |
+                       RELOCATION_KIND_BIT(RELOCATION_THUMB_BRANCH8) |
+                       RELOCATION_KIND_BIT(RELOCATION_THUMB_BRANCH11) |
+                       RELOCATION_KIND_BIT(RELOCATION_THUMB_BL) |
+                       RELOCATION_KIND_BIT(RELOCATION_THUMB_LOAD8)),
+   .Initialize = Initialize_ARMv4,
+   .Encode_Instruction = Encode_Instruction_ARMv4,
+   .Parse_Directive = Parse_Directive_ARMv4,
+};
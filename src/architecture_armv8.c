@@ -1,15 +1,3093 @@
 /* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
 
-static INITIALIZE_ARCHITECTURE(Initialize_Architecture)
+#include "mnemonics_armv8.h"
+
+enum
+{
+#  define X(M) ARMV8_MNEMONIC_##M,
+   MNEMONICS_LIST
+#  undef X
+   ARMV8_MNEMONIC_COUNT,
+};
+#undef MNEMONICS_LIST
+#undef MNEMONIC_PREFIX
+
+// NOTE: Generated from MNEMONICS_LIST by the build, see mnemonic_hash.h.
+#include "mnemonic_hash_armv8.h"
+
+// NOTE: A64 instructions are always four bytes. Operands follow the usual
+// syntax without the '#' in front of immediates, since that starts a
+// directive here, e.g.:
+//
+//    add x0, x1, x2, lsl 3
+//    ldr w0, [sp, 16]
+//    adrp x0, table
+//    add x0, x0, %lo12(table)
+//
+// %lo12(symbol) takes the place of GAS's :lo12:symbol, since a colon ends a
+// label.
+
+#define A64_CONDITION_AL 0xE
+
+static char A64_Condition_Names[][3] =
+{
+   "eq", "ne", "cs", "cc", "mi", "pl", "vs", "vc",
+   "hi", "ls", "ge", "lt", "gt", "le", "al", "nv",
+};
+
+static char A64_Shift_Names[][4] =
+{
+   "lsl", "lsr", "asr", "ror",
+};
+
+static char A64_Extend_Names[][5] =
+{
+   "uxtb", "uxth", "uxtw", "uxtx", "sxtb", "sxth", "sxtw", "sxtx",
+};
+
+#define A64_EXTEND_UXTW 2
+#define A64_EXTEND_UXTX 3
+#define A64_EXTEND_LSL  8 // Not an option, resolved to uxtw or uxtx by the caller.
+
+// NOTE: A logical immediate is a run of ones, rotated, within an element of 2,
+// 4, 8, 16, 32 or 64 bits that is repeated to fill the register. That gives
+// 5,334 distinct 64-bit values. They are generated when the backend is
+// initialized and sorted, with their N:immr:imms fields in a parallel array, so
+// checking an operand is a branchless binary search over 42 KB of values rather
+// than a loop over every element size and rotation. 32-bit operands are
+// replicated to 64 bits first, and only match values with elements of at most
+// 32 bits, which are exactly the ones with N clear.
+
+#define A64_BITMASK_COUNT 5334
+
+static u64 *A64_Bitmask_Values;
+static u16 *A64_Bitmask_Fields;
+
+typedef struct {
+   u64 Value;
+   u16 Field;
+} a64_bitmask;
+
+static int Compare_A64_Bitmasks(const void *A, const void *B)
+{
+   u64 Left = ((a64_bitmask *)A)->Value;
+   u64 Right = ((a64_bitmask *)B)->Value;
+   int Result = (Left > Right) - (Left < Right);
+   return(Result);
+}
+
+static bool A64_Encode_Bitmask(u64 Value, bool Is_64, u32 *Field)
+{
+   // NOTE: Produces N:immr:imms as a 13-bit field, placed at bit 10.
+   bool Result = false;
+
+   if(!Is_64)
+   {
+      Value = (Value & 0xFFFFFFFF) | (Value << 32);
+   }
+
+   u64 *Base = A64_Bitmask_Values;
+   index Count = A64_BITMASK_COUNT;
+   while(Count > 1)
+   {
+      index Half = Count / 2;
+      Base = (Base[Half] <= Value) ? (Base + Half) : Base;
+      Count -= Half;
+   }
+
+   if(*Base == Value)
+   {
+      *Field = A64_Bitmask_Fields[Base - A64_Bitmask_Values];
+      Result = (Is_64 || !(*Field & (1 << 12)));
+   }
+
+   return(Result);
+}
+
+typedef struct {
+   bool Found;
+   u32 Mnemonic;
+   int Condition; // Only b.cond has one, -1 otherwise.
+} a64_mnemonic;
+
+static bool A64_Parse_Condition(string Name, int *Condition)
+{
+   bool Result = false;
+   if(Name.Length == 2)
+   {
+      if(Equals(Name, S("hs")))      { *Condition = 0x2; Result = true; }
+      else if(Equals(Name, S("lo"))) { *Condition = 0x3; Result = true; }
+
+      for(int Code = 0; !Result && Code < Array_Count(A64_Condition_Names); ++Code)
+      {
+         if(Name.Data[0] == A64_Condition_Names[Code][0] && Name.Data[1] == A64_Condition_Names[Code][1])
+         {
+            *Condition = Code;
+            Result = true;
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static a64_mnemonic A64_Parse_Mnemonic(string Mnemonic)
+{
+   a64_mnemonic Result = {0};
+
+   cut Parts = Cut(Mnemonic, '.');
+   mnemonic_lookup Base = Lookup_Mnemonic(&Mnemonic_Hash_armv8, Parts.Before);
+   if(Base.Found)
+   {
+      Result.Mnemonic = Base.Mnemonic;
+      Result.Condition = -1;
+      if(!Parts.Found)
+      {
+         Result.Found = true;
+      }
+      else if(Base.Mnemonic == ARMV8_MNEMONIC_b)
+      {
+         Result.Found = A64_Parse_Condition(Parts.After, &Result.Condition);
+      }
+   }
+
+   return(Result);
+}
+
+static int A64_Split_Operands(assembler_context *Context, string Operands, string *Results, int Capacity)
+{
+   // NOTE: Operands are separated by commas, except inside brackets and
+   // braces. Returns the operand count, or -1 if there are too many.
+   int Result = 0;
+   while(Result >= 0 && Operands.Length)
+   {
+      int Depth = 0;
+      index Index = 0;
+      for(; Index < Operands.Length; ++Index)
+      {
+         u8 Character = Operands.Data[Index];
+         if(Character == '[' || Character == '{') Depth++;
+         else if(Character == ']' || Character == '}') Depth--;
+         else if(Character == ',' && Depth == 0) break;
+      }
+
+      if(Result == Capacity)
+      {
+         Report_Error(Context, "Too many operands: \"%.*s\".", SF(Operands));
+         Result = -1;
+      }
+      else
+      {
+         Results[Result++] = Trim((string){Operands.Data, Index});
+         Operands = (Index < Operands.Length) ? Trim_Left((string){Operands.Data + Index + 1, Operands.Length - Index - 1}) : (string){0};
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Expect_Operand_Count(assembler_context *Context, int Count, int Minimum, int Maximum)
+{
+   bool Result = (Count >= Minimum && Count <= Maximum);
+   if(!Result && Count >= 0)
+   {
+      if(Minimum == Maximum)
+      {
+         Report_Error(Context, "Expected %d operands, got %d.", Minimum, Count);
+      }
+      else
+      {
+         Report_Error(Context, "Expected %d to %d operands, got %d.", Minimum, Maximum, Count);
+      }
+   }
+
+   return(Result);
+}
+
+typedef struct {
+   int Number; // -1 if the operand is not a register.
+   bool Is_64;
+   bool Is_SP; // Register 31 as sp or wsp, rather than the zero register.
+} a64_register;
+
+typedef enum {
+   A64_ZR, // Register 31 is the zero register in this operand.
+   A64_SP, // Register 31 is the stack pointer in this operand.
+} a64_register_31;
+
+static a64_register A64_Parse_Register(string Operand)
+{
+   // NOTE: Called for nearly every operand, so it avoids the general string
+   // and number parsers.
+   a64_register Result = {-1, false, false};
+
+   u8 *Data = Operand.Data;
+   index Length = Operand.Length;
+   if((Length == 2 || Length == 3) && (Data[0] == 'x' || Data[0] == 'w') && Data[1] >= '0' && Data[1] <= '9')
+   {
+      int Number = Data[1] - '0';
+      if(Length == 3)
+      {
+         Number = (Number != 0 && Data[2] >= '0' && Data[2] <= '9') ? (Number * 10 + (Data[2] - '0')) : 31;
+      }
+      if(Number <= 30)
+      {
+         Result = (a64_register){Number, Data[0] == 'x', false};
+      }
+   }
+   else if(Length == 2 || Length == 3)
+   {
+      if(Equals(Operand, S("sp")))       Result = (a64_register){31, true, true};
+      else if(Equals(Operand, S("wsp"))) Result = (a64_register){31, false, true};
+      else if(Equals(Operand, S("xzr"))) Result = (a64_register){31, true, false};
+      else if(Equals(Operand, S("wzr"))) Result = (a64_register){31, false, false};
+      else if(Equals(Operand, S("lr")))  Result = (a64_register){30, true, false};
+      else if(Equals(Operand, S("fp")))  Result = (a64_register){29, true, false};
+   }
+
+   return(Result);
+}
+
+typedef struct {
+   int Number; // -1 if the operand is not a SIMD register.
+   int Size;   // Element size as a power of two bytes, b 0 up to d 3, and q 4.
+   int Lanes;  // Element count of an arrangement, e.g. 4 for v0.4s, else 0.
+   int Index;  // Element index, e.g. 1 for v0.s[1], else -1.
+   bool Is_Scalar; // A b, h, s, d or q register rather than part of a v register.
+} a64_vector;
+
+static int A64_Size_Letter(u8 Letter)
+{
+   int Result = (Letter == 'b') ? 0 : (Letter == 'h') ? 1 : (Letter == 's') ? 2 :
+                (Letter == 'd') ? 3 : (Letter == 'q') ? 4 : -1;
+   return(Result);
+}
+
+static a64_vector A64_Parse_Vector(string Operand)
+{
+   // NOTE: Scalar registers such as q0 or s1, arrangements such as v0.4s, and
+   // single elements such as v0.s[1]. With only the letter, as in the lists
+   // of single structure loads, Lanes is 0 and Index -1.
+   a64_vector Result = {-1, 0, 0, -1, false};
+
+   u8 *Data = Operand.Data;
+   index Length = Operand.Length;
+   int Letter_Size = (Length >= 2) ? A64_Size_Letter(Data[0]) : -1;
+   if(Length >= 2 && (Data[0] == 'v' || Letter_Size >= 0))
+   {
+      index At = 1;
+      int Number = 0;
+      while(At < Length && At < 3 && Data[At] >= '0' && Data[At] <= '9')
+      {
+         Number = Number * 10 + (Data[At++] - '0');
+      }
+
+      if(At == 1 || Number > 31)
+      {
+         // NOTE: Not a register.
+      }
+      else if(Data[0] != 'v')
+      {
+         if(At == Length)
+         {
+            Result = (a64_vector){Number, Letter_Size, 0, -1, true};
+         }
+      }
+      else if(At + 1 < Length && Data[At] == '.')
+      {
+         At++;
+         int Lanes = 0;
+         while(At < Length && Data[At] >= '0' && Data[At] <= '9')
+         {
+            Lanes = Lanes * 10 + (Data[At++] - '0');
+         }
+
+         int Size = (At < Length) ? A64_Size_Letter(Data[At++]) : -1;
+         int Index = -1;
+         if(At + 2 < Length && Data[At] == '[' && Data[Length - 1] == ']' && !Lanes)
+         {
+            parsed_integer Parsed = Parse_Integer((string){Data + At + 1, Length - At - 2});
+            Index = (Parsed.Ok && Parsed.Value >= 0 && Parsed.Value < (16 >> Size)) ? (int)Parsed.Value : -2;
+            At = Length;
+         }
+
+         bool Valid_Lanes = (!Lanes || (Size < 4 && ((Lanes << Size) == 8 || (Lanes << Size) == 16)));
+         if(Size >= 0 && Size < 4 && At == Length && Index != -2 && Valid_Lanes)
+         {
+            Result = (a64_vector){Number, Size, Lanes, Index, false};
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Is_Scalar(a64_vector Vector)
+{
+   bool Result = (Vector.Number >= 0 && Vector.Is_Scalar);
+   return(Result);
+}
+
+static bool A64_Check_Register(assembler_context *Context, a64_register Register, string Operand, a64_register_31 Meaning)
+{
+   bool Result = false;
+   if(Register.Number < 0)
+   {
+      Report_Error(Context, "Expected a register, got \"%.*s\".", SF(Operand));
+   }
+   else if(Register.Number == 31 && Register.Is_SP != (Meaning == A64_SP))
+   {
+      Report_Error(Context, "\"%.*s\" can't be used in this operand.", SF(Operand));
+   }
+   else
+   {
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Expect_Register(assembler_context *Context, string Operand, a64_register_31 Meaning, a64_register *Register)
+{
+   *Register = A64_Parse_Register(Operand);
+   bool Result = A64_Check_Register(Context, *Register, Operand, Meaning);
+   return(Result);
+}
+
+static bool A64_Check_Width(assembler_context *Context, a64_register Register, bool Is_64)
+{
+   bool Result = (Register.Is_64 == Is_64);
+   if(!Result)
+   {
+      Report_Error(Context, "Expected a %s register.", (Is_64) ? "64-bit x" : "32-bit w");
+   }
+
+   return(Result);
+}
+
+static string A64_Zero_Register(bool Is_64)
+{
+   string Result = (Is_64) ? S("xzr") : S("wzr");
+   return(Result);
+}
+
+static bool A64_Parse_Constant(assembler_context *Context, string Operand, s64 *Value)
+{
+   // NOTE: Immediates are number literals or constants that are already
+   // defined, since their encoding depends on the value.
+   bool Result = false;
+
+   if(Operand.Length && ((Operand.Data[0] >= '0' && Operand.Data[0] <= '9') || Operand.Data[0] == '-'))
+   {
+      parsed_integer Parsed = Parse_Integer(Operand);
+      if(Parsed.Ok)
+      {
+         *Value = Parsed.Value;
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Could not parse number literal \"%.*s\".", SF(Operand));
+      }
+   }
+   else if(Operand.Length)
+   {
+      lookup_result Constant = Resolve_Symbol(Context, Intern_Symbol(&Context->Symbols, Operand));
+      if(Constant.Found)
+      {
+         *Value = (s64)Constant.Value;
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Immediate \"%.*s\" must be a constant defined before use.", SF(Operand));
+      }
+   }
+   else
+   {
+      Report_Error(Context, "Missing operand.");
+   }
+
+   return(Result);
+}
+
+static bool A64_Parse_Constant_Range(assembler_context *Context, string Operand, s64 Minimum, s64 Maximum, s64 *Value)
+{
+   bool Result = A64_Parse_Constant(Context, Operand, Value);
+   if(Result && (*Value < Minimum || *Value > Maximum))
+   {
+      Report_Error(Context, "Immediate %lld is out of range, expected %lld to %lld.", (long long)*Value, (long long)Minimum, (long long)Maximum);
+      Result = false;
+   }
+
+   return(Result);
+}
+
+static bool A64_Parse_Width_Constant(assembler_context *Context, string Operand, bool Is_64, u64 *Value)
+{
+   // NOTE: A value for a 32-bit register may be given signed or unsigned.
+   s64 Parsed = 0;
+   bool Result = A64_Parse_Constant(Context, Operand, &Parsed);
+   if(Result && !Is_64)
+   {
+      if(Parsed < -(s64)0x80000000 || Parsed > 0xFFFFFFFF)
+      {
+         Report_Error(Context, "Immediate %lld does not fit in 32 bits.", (long long)Parsed);
+         Result = false;
+      }
+      Parsed &= 0xFFFFFFFF;
+   }
+   *Value = (u64)Parsed;
+
+   return(Result);
+}
+
+static bool A64_Parse_Low12(string Operand, string *Symbol)
+{
+   // NOTE: %lo12(symbol), the offset of a symbol within its 4 KB page.
+   bool Result = (Has_Prefix_Then_Remove(&Operand, S("%lo12(")) && Has_Suffix_Then_Remove(&Operand, S(")")));
+   *Symbol = Trim(Operand);
+   return(Result);
+}
+
+static bool A64_Is_Label(assembler_context *Context, string Operand)
+{
+   bool Result = false;
+   if(Operand.Length == 0)
+   {
+      Report_Error(Context, "Missing target.");
+   }
+   else if((Operand.Data[0] >= '0' && Operand.Data[0] <= '9') || Operand.Data[0] == '-' ||
+           A64_Parse_Register(Operand).Number >= 0)
+   {
+      Report_Error(Context, "Target must be a label: \"%.*s\".", SF(Operand));
+   }
+   else
+   {
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Parse_Shift(assembler_context *Context, string Operand, bool Allow_Ror, bool Is_64, u32 *Bits)
+{
+   // NOTE: "lsl 3" and so on, as the shift type in bits 22-23 and the amount
+   // in bits 10-15 of a shifted register operand.
+   bool Result = false;
+
+   cut Parts = Cut_Whitespace(Operand);
+   int Shift = -1;
+   for(int Index = 0; Index < Array_Count(A64_Shift_Names); ++Index)
+   {
+      if(Equals(Parts.Before, From_C_String(A64_Shift_Names[Index])))
+      {
+         Shift = Index;
+      }
+   }
+
+   s64 Amount = 0;
+   if(Shift < 0 || (Shift == 3 && !Allow_Ror))
+   {
+      Report_Error(Context, "Unsupported shift \"%.*s\".", SF(Operand));
+   }
+   else if(A64_Parse_Constant_Range(Context, Trim(Parts.After), 0, (Is_64) ? 63 : 31, &Amount))
+   {
+      *Bits = (Shift << 22) | ((u32)Amount << 10);
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Is_Extend(string Operand)
+{
+   bool Result = (Operand.Length >= 4 && (Operand.Data[0] == 'u' || Operand.Data[0] == 's') &&
+                  Operand.Data[1] == 'x' && Operand.Data[2] == 't');
+   return(Result);
+}
+
+static bool A64_Parse_Extend(assembler_context *Context, string Operand, int *Option, s64 *Amount, bool *Has_Amount)
+{
+   // NOTE: "uxtw 2", "sxtx" or "lsl 2". The option is A64_EXTEND_LSL for lsl.
+   bool Result = false;
+
+   cut Parts = Cut_Whitespace(Operand);
+   string Amount_String = Trim(Parts.After);
+
+   *Option = -1;
+   if(Equals(Parts.Before, S("lsl")))
+   {
+      *Option = A64_EXTEND_LSL;
+   }
+   for(int Index = 0; Index < Array_Count(A64_Extend_Names); ++Index)
+   {
+      if(Equals(Parts.Before, From_C_String(A64_Extend_Names[Index])))
+      {
+         *Option = Index;
+      }
+   }
+
+   *Amount = 0;
+   *Has_Amount = (Amount_String.Length > 0);
+   if(*Option < 0)
+   {
+      Report_Error(Context, "Unsupported extend \"%.*s\".", SF(Operand));
+   }
+   else if(*Option == A64_EXTEND_LSL && !*Has_Amount)
+   {
+      Report_Error(Context, "Missing shift amount.");
+   }
+   else
+   {
+      Result = (!*Has_Amount || A64_Parse_Constant_Range(Context, Amount_String, 0, 4, Amount));
+   }
+
+   return(Result);
+}
+
+static void A64_Request_Label(assembler_context *Context, string Label, relocation_kind Kind)
+{
+   symbol_id Symbol = Intern_Symbol(&Context->Symbols, Label);
+   Request_Relocation(Context, Symbol, Context->Current_Address, 4, Kind, ENDIAN_LITTLE);
+}
+
+static bool A64_Encode_Add_Sub(assembler_context *Context, u32 Op, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: Op is the index among add, adds, sub and subs, i.e. the op and S
+   // bits. The third operand is an immediate, optionally shifted by 12, a
+   // shifted register, or an extended register. Register 31 is sp in the
+   // immediate and extended forms, so a register operand involving sp picks
+   // the extended form.
+   bool Result = false;
+   if(!A64_Expect_Operand_Count(Context, Count, 3, 4))
+   {
+      return(false);
+   }
+
+   bool Set_Flags = Op & 1;
+   bool Subtract = Op >> 1;
+
+   a64_register Rd = A64_Parse_Register(Operand[0]);
+   a64_register Rn = A64_Parse_Register(Operand[1]);
+   a64_register Rm = A64_Parse_Register(Operand[2]);
+   bool Extended = (Rm.Number >= 0 && ((Count == 4 && A64_Is_Extend(Operand[3])) || (Rd.Is_SP && !Set_Flags) || Rn.Is_SP));
+
+   a64_register_31 Destination = (Set_Flags || (Rm.Number >= 0 && !Extended)) ? A64_ZR : A64_SP;
+   a64_register_31 Source = (Rm.Number >= 0 && !Extended) ? A64_ZR : A64_SP;
+   if(!A64_Check_Register(Context, Rd, Operand[0], Destination) ||
+      !A64_Check_Register(Context, Rn, Operand[1], Source) ||
+      !A64_Check_Width(Context, Rn, Rd.Is_64))
+   {
+      return(false);
+   }
+
+   u32 Base = ((u32)Rd.Is_64 << 31) | (Set_Flags << 29) | (Rn.Number << 5) | Rd.Number;
+
+   string Symbol;
+   if(Rm.Number < 0 && A64_Parse_Low12(Operand[2], &Symbol))
+   {
+      if(Subtract || Count != 3)
+      {
+         Report_Error(Context, "%%lo12 can only be added.");
+      }
+      else
+      {
+         A64_Request_Label(Context, Symbol, RELOCATION_A64_LO12);
+         *Encoding = Base | 0x11000000;
+         Result = true;
+      }
+   }
+   else if(Rm.Number < 0)
+   {
+      s64 Value = 0;
+      bool Explicit_Shift = (Count == 4);
+      if(Explicit_Shift && !Equals(Operand[3], S("lsl 12")) && !Equals(Operand[3], S("lsl 0")))
+      {
+         Report_Error(Context, "Immediates can only be shifted by lsl 0 or lsl 12.");
+      }
+      else if(A64_Parse_Constant(Context, Operand[2], &Value))
+      {
+         // NOTE: Adding a negative value is subtracting, and the other way around.
+         if(Value < 0 && Value > -((s64)1 << 24))
+         {
+            Subtract = !Subtract;
+            Value = -Value;
+         }
+
+         bool Shifted = Explicit_Shift && Equals(Operand[3], S("lsl 12"));
+         if(!Explicit_Shift && Value > 0xFFF && (Value & 0xFFF) == 0)
+         {
+            Value >>= 12;
+            Shifted = true;
+         }
+
+         if(Value >= 0 && Value <= 0xFFF)
+         {
+            *Encoding = Base | 0x11000000 | ((u32)Subtract << 30) | ((u32)Shifted << 22) | ((u32)Value << 10);
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Immediate %lld does not fit in 12 bits, optionally shifted by 12.", (long long)Value);
+         }
+      }
+   }
+   else if(Extended)
+   {
+      int Option = (Rd.Is_64) ? A64_EXTEND_UXTX : A64_EXTEND_UXTW;
+      s64 Amount = 0;
+      bool Has_Amount = false;
+      if(Count == 4 && !A64_Parse_Extend(Context, Operand[3], &Option, &Amount, &Has_Amount))
+      {
+         // NOTE: Already reported.
+      }
+      else
+      {
+         if(Option == A64_EXTEND_LSL)
+         {
+            Option = (Rd.Is_64) ? A64_EXTEND_UXTX : A64_EXTEND_UXTW;
+         }
+
+         // NOTE: Only uxtx and sxtx take a 64-bit register.
+         bool Rm_64 = Rd.Is_64 && (Option & 3) == 3;
+         if(A64_Check_Register(Context, Rm, Operand[2], A64_ZR) && A64_Check_Width(Context, Rm, Rm_64))
+         {
+            *Encoding = Base | 0x0B200000 | ((u32)Subtract << 30) | (Rm.Number << 16) | (Option << 13) | ((u32)Amount << 10);
+            Result = true;
+         }
+      }
+   }
+   else
+   {
+      u32 Shift_Bits = 0;
+      if(A64_Check_Register(Context, Rm, Operand[2], A64_ZR) && A64_Check_Width(Context, Rm, Rd.Is_64) &&
+         (Count == 3 || A64_Parse_Shift(Context, Operand[3], false, Rd.Is_64, &Shift_Bits)))
+      {
+         *Encoding = Base | 0x0B000000 | ((u32)Subtract << 30) | Shift_Bits | (Rm.Number << 16);
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Logical(assembler_context *Context, u32 Op, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: Op is the index among and, orr, eor, ands, bic, orn, eon and bics,
+   // i.e. opc in the low two bits and the inverting N bit above them. The
+   // inverting forms have no immediate encoding of their own, so their
+   // immediate is inverted and given to the plain form instead.
+   bool Result = false;
+   if(!A64_Expect_Operand_Count(Context, Count, 3, 4))
+   {
+      return(false);
+   }
+
+   u32 Opc = Op & 3;
+   bool Invert = Op >> 2;
+
+   a64_register Rd = A64_Parse_Register(Operand[0]);
+   a64_register Rn = {0};
+   a64_register Rm = A64_Parse_Register(Operand[2]);
+   a64_register_31 Destination = (Rm.Number < 0 && Opc != 3) ? A64_SP : A64_ZR;
+   if(!A64_Check_Register(Context, Rd, Operand[0], Destination) ||
+      !A64_Expect_Register(Context, Operand[1], A64_ZR, &Rn) ||
+      !A64_Check_Width(Context, Rn, Rd.Is_64))
+   {
+      return(false);
+   }
+
+   u32 Base = ((u32)Rd.Is_64 << 31) | (Opc << 29) | (Rn.Number << 5) | Rd.Number;
+   if(Rm.Number < 0)
+   {
+      u64 Value = 0;
+      u32 Field = 0;
+      if(Count != 3)
+      {
+         Report_Error(Context, "Immediates can't be shifted here.");
+      }
+      else if(A64_Parse_Width_Constant(Context, Operand[2], Rd.Is_64, &Value))
+      {
+         if(Invert)
+         {
+            Value = (Rd.Is_64) ? ~Value : (~Value & 0xFFFFFFFF);
+         }
+
+         if(A64_Encode_Bitmask(Value, Rd.Is_64, &Field))
+         {
+            *Encoding = Base | 0x12000000 | (Field << 10);
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "0x%llx is not a valid logical immediate.", (unsigned long long)Value);
+         }
+      }
+   }
+   else
+   {
+      u32 Shift_Bits = 0;
+      if(A64_Check_Register(Context, Rm, Operand[2], A64_ZR) && A64_Check_Width(Context, Rm, Rd.Is_64) &&
+         (Count == 3 || A64_Parse_Shift(Context, Operand[3], true, Rd.Is_64, &Shift_Bits)))
+      {
+         *Encoding = Base | 0x0A000000 | ((u32)Invert << 21) | Shift_Bits | (Rm.Number << 16);
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Single_Halfword(u64 Value, bool Is_64, u32 *Field)
+{
+   // NOTE: True if at most one halfword of the value is non-zero, which is
+   // then given as hw:imm16, i.e. bits 5-22 of a move wide instruction.
+   bool Result = false;
+   for(int Halfword = 0; !Result && Halfword < ((Is_64) ? 4 : 2); ++Halfword)
+   {
+      if((Value & ~((u64)0xFFFF << (Halfword * 16))) == 0)
+      {
+         *Field = (Halfword << 16) | (u32)(Value >> (Halfword * 16));
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Move_Immediate(a64_register Rd, u64 Value, u32 *Encoding)
+{
+   // NOTE: mov of a constant that fits a single movz, movn or orr, in that
+   // order of preference. Value is already truncated to the register size.
+   bool Result = true;
+
+   u64 Size_Mask = (Rd.Is_64) ? ~(u64)0 : 0xFFFFFFFF;
+   u32 Base = ((u32)Rd.Is_64 << 31) | Rd.Number;
+   u32 Field = 0;
+   if(!Rd.Is_SP && A64_Single_Halfword(Value, Rd.Is_64, &Field))
+   {
+      *Encoding = Base | 0x52800000 | (Field << 5);
+   }
+   else if(!Rd.Is_SP && A64_Single_Halfword(~Value & Size_Mask, Rd.Is_64, &Field))
+   {
+      *Encoding = Base | 0x12800000 | (Field << 5);
+   }
+   else if(A64_Encode_Bitmask(Value, Rd.Is_64, &Field))
+   {
+      *Encoding = Base | 0x32000000 | (Field << 10) | (31 << 5);
+   }
+   else
+   {
+      Result = false;
+   }
+
+   return(Result);
+}
+
+static int A64_Count_Halfwords_Not(u64 Value, int Halfword_Count, u16 Halfword)
+{
+   int Result = 0;
+   for(int Index = 0; Index < Halfword_Count; ++Index)
+   {
+      Result += ((u16)(Value >> (Index * 16)) != Halfword);
+   }
+
+   return(Result);
+}
+
+static int A64_Encode_Move_Sequence(a64_register Rd, u64 Value, u32 *Encoding)
+{
+   // NOTE: The shortest sequence that builds a constant, and its length.
+   // After a single movz, movn or orr, the options are a movz or movn that
+   // covers every halfword that is all zeros or all ones, or an orr of the
+   // bitmask immediate that shares the most halfwords with the value, each
+   // followed by a movk for every halfword still wrong. The orr search is
+   // exhaustive, but only runs when the move wide chain takes three or more
+   // instructions. Returns zero if the value can't be moved, which only
+   // happens for sp, since movk can't write it.
+   int Result = 1;
+   if(!A64_Encode_Move_Immediate(Rd, Value, Encoding))
+   {
+      int Halfword_Count = (Rd.Is_64) ? 4 : 2;
+      u64 Size_Mask = (Rd.Is_64) ? ~(u64)0 : 0xFFFFFFFF;
+      u32 Base = ((u32)Rd.Is_64 << 31) | Rd.Number;
+
+      // NOTE: movz leaves the other halfwords zero, movn leaves them all ones.
+      int Zero_Length = A64_Count_Halfwords_Not(Value, Halfword_Count, 0x0000);
+      int Ones_Length = A64_Count_Halfwords_Not(Value, Halfword_Count, 0xFFFF);
+      bool Inverted = (Ones_Length < Zero_Length);
+      u16 Fill = (Inverted) ? 0xFFFF : 0x0000;
+      Result = (Inverted) ? Ones_Length : Zero_Length;
+
+      int First = 0;
+      while((u16)(Value >> (First * 16)) == Fill)
+      {
+         First++;
+      }
+      u64 First_Halfword = (Value >> (First * 16)) & 0xFFFF;
+      u64 Start = (Inverted) ? (~((First_Halfword ^ 0xFFFF) << (First * 16)) & Size_Mask) : (First_Halfword << (First * 16));
+      if(Inverted)
+      {
+         Encoding[0] = Base | 0x12800000 | (First << 21) | ((u32)(First_Halfword ^ 0xFFFF) << 5);
+      }
+      else
+      {
+         Encoding[0] = Base | 0x52800000 | (First << 21) | ((u32)First_Halfword << 5);
+      }
+
+      if(Rd.Is_64 && Result >= 3)
+      {
+         u64 *Best = 0;
+         for(u64 *Bitmask = A64_Bitmask_Values; Bitmask < A64_Bitmask_Values + A64_BITMASK_COUNT; ++Bitmask)
+         {
+            int Length = 1 + A64_Count_Halfwords_Not(*Bitmask ^ Value, 4, 0);
+            if(Length < Result)
+            {
+               Best = Bitmask;
+               Result = Length;
+            }
+         }
+
+         if(Best)
+         {
+            Start = *Best;
+            Encoding[0] = Base | 0x32000000 | ((u32)A64_Bitmask_Fields[Best - A64_Bitmask_Values] << 10) | (31 << 5);
+         }
+      }
+
+      int Length = 1;
+      for(int Halfword = 0; Halfword < Halfword_Count; ++Halfword)
+      {
+         u64 Part = (Value >> (Halfword * 16)) & 0xFFFF;
+         if(((Start >> (Halfword * 16)) & 0xFFFF) != Part)
+         {
+            Encoding[Length++] = Base | 0x72800000 | (Halfword << 21) | ((u32)Part << 5);
+         }
+      }
+      assert(Length == Result);
+
+      if(Rd.Is_SP)
+      {
+         Result = 0;
+      }
+   }
+
+   return(Result);
+}
+
+static int A64_Encode_Move(assembler_context *Context, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: mov between registers is orr with the zero register, or add with
+   // zero if either is sp. mov of a constant is the shortest sequence that
+   // builds it, see A64_Encode_Move_Sequence. A symbol that isn't defined yet
+   // can't be sized by its value, so it always takes the full movz and movk
+   // chain, with each halfword filled in by relocation. Returns the
+   // instruction count, or zero on error.
+   int Result = 0;
+   if(!A64_Expect_Operand_Count(Context, Count, 2, 2))
+   {
+      return(0);
+   }
+
+   a64_register Rd = A64_Parse_Register(Operand[0]);
+   a64_register Rm = A64_Parse_Register(Operand[1]);
+   string Source = Operand[1];
+   bool Is_Number = (Source.Length && ((Source.Data[0] >= '0' && Source.Data[0] <= '9') || Source.Data[0] == '-'));
+   if(Rd.Number < 0)
+   {
+      Report_Error(Context, "Expected a register, got \"%.*s\".", SF(Operand[0]));
+   }
+   else if(Rm.Number >= 0)
+   {
+      if(A64_Check_Width(Context, Rm, Rd.Is_64))
+      {
+         if(Rd.Is_SP || Rm.Is_SP)
+         {
+            *Encoding = ((u32)Rd.Is_64 << 31) | 0x11000000 | (Rm.Number << 5) | Rd.Number;
+         }
+         else
+         {
+            *Encoding = ((u32)Rd.Is_64 << 31) | 0x2A000000 | (Rm.Number << 16) | (31 << 5) | Rd.Number;
+         }
+         Result = 1;
+      }
+   }
+   else if(!Is_Number && Source.Length && !Resolve_Symbol(Context, Intern_Symbol(&Context->Symbols, Source)).Found)
+   {
+      if(Rd.Is_SP)
+      {
+         Report_Error(Context, "sp can only be set from a symbol through another register.");
+      }
+      else
+      {
+         symbol_id Symbol = Intern_Symbol(&Context->Symbols, Source);
+         u32 Base = ((u32)Rd.Is_64 << 31) | Rd.Number;
+         Result = (Rd.Is_64) ? 4 : 2;
+         for(int Halfword = 0; Halfword < Result; ++Halfword)
+         {
+            Request_Relocation(Context, Symbol, Context->Current_Address + Halfword * 4, 4,
+                               (relocation_kind)(RELOCATION_A64_MOVW_G0 + Halfword), ENDIAN_LITTLE);
+            Encoding[Halfword] = Base | ((Halfword) ? 0x72800000 : 0x52800000) | (Halfword << 21);
+         }
+      }
+   }
+   else
+   {
+      u64 Value = 0;
+      if(A64_Parse_Width_Constant(Context, Source, Rd.Is_64, &Value))
+      {
+         Result = A64_Encode_Move_Sequence(Rd, Value, Encoding);
+         if(!Result)
+         {
+            Report_Error(Context, "0x%llx can't be moved to sp with a single instruction.", (unsigned long long)Value);
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Move_Wide(assembler_context *Context, u32 Op, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: movn, movz and movk rd, imm16{, lsl shift}. Without a shift, a
+   // larger value with a single non-zero halfword picks its own.
+   bool Result = false;
+   if(!A64_Expect_Operand_Count(Context, Count, 2, 3))
+   {
+      return(false);
+   }
+
+   a64_register Rd;
+   s64 Value = 0;
+   s64 Shift = 0;
+   if(A64_Expect_Register(Context, Operand[0], A64_ZR, &Rd) &&
+      A64_Parse_Constant(Context, Operand[1], &Value))
+   {
+      u32 Field = 0;
+      u32 Opc = (Op) ? (Op + 1) : 0;
+      u32 Base = ((u32)Rd.Is_64 << 31) | (Opc << 29) | 0x12800000 | Rd.Number;
+      if(Count == 3)
+      {
+         cut Parts = Cut_Whitespace(Operand[2]);
+         if(!Equals(Parts.Before, S("lsl")))
+         {
+            Report_Error(Context, "Expected lsl 0, 16, 32 or 48.");
+         }
+         else if(A64_Parse_Constant_Range(Context, Trim(Parts.After), 0, (Rd.Is_64) ? 48 : 16, &Shift))
+         {
+            if((Shift & 15) || Value < 0 || Value > 0xFFFF)
+            {
+               Report_Error(Context, "Expected a 16-bit value shifted by a multiple of 16.");
+            }
+            else
+            {
+               *Encoding = Base | ((u32)(Shift / 16) << 21) | ((u32)Value << 5);
+               Result = true;
+            }
+         }
+      }
+      else if(Value >= 0 && A64_Single_Halfword((u64)Value, Rd.Is_64, &Field))
+      {
+         *Encoding = Base | (Field << 5);
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Immediate %lld is not a shifted 16-bit value.", (long long)Value);
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Expect_Same_Registers(assembler_context *Context, string *Operand, int Count, a64_register *Registers)
+{
+   // NOTE: All general purpose registers of the same size, where 31 is zr.
+   bool Result = true;
+   for(int Index = 0; Result && Index < Count; ++Index)
+   {
+      Result = A64_Expect_Register(Context, Operand[Index], A64_ZR, Registers + Index) &&
+               A64_Check_Width(Context, Registers[Index], Registers[0].Is_64);
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Multiply(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   bool Result = false;
+
+   a64_register R[4];
+   if(Mnemonic <= ARMV8_MNEMONIC_mneg)
+   {
+      // NOTE: madd and msub rd, rn, rm, ra, and mul and mneg without ra.
+      bool Accumulate = (Mnemonic <= ARMV8_MNEMONIC_msub);
+      int Expected = (Accumulate) ? 4 : 3;
+      bool Negate = (Mnemonic == ARMV8_MNEMONIC_msub || Mnemonic == ARMV8_MNEMONIC_mneg);
+      if(A64_Expect_Operand_Count(Context, Count, Expected, Expected) && A64_Expect_Same_Registers(Context, Operand, Count, R))
+      {
+         int Ra = (Accumulate) ? R[3].Number : 31;
+         *Encoding = ((u32)R[0].Is_64 << 31) | 0x1B000000 | (R[2].Number << 16) | ((u32)Negate << 15) |
+                     (Ra << 10) | (R[1].Number << 5) | R[0].Number;
+         Result = true;
+      }
+   }
+   else if(Mnemonic <= ARMV8_MNEMONIC_umnegl)
+   {
+      // NOTE: Long multiplies, xd = wn * wm (+ xa).
+      bool Accumulate = (Mnemonic <= ARMV8_MNEMONIC_umsubl);
+      u32 Index = Mnemonic - ((Accumulate) ? ARMV8_MNEMONIC_smaddl : ARMV8_MNEMONIC_smull);
+      int Expected = (Accumulate) ? 4 : 3;
+      if(A64_Expect_Operand_Count(Context, Count, Expected, Expected) &&
+         A64_Expect_Register(Context, Operand[0], A64_ZR, R + 0) && A64_Check_Width(Context, R[0], true) &&
+         A64_Expect_Register(Context, Operand[1], A64_ZR, R + 1) && A64_Check_Width(Context, R[1], false) &&
+         A64_Expect_Register(Context, Operand[2], A64_ZR, R + 2) && A64_Check_Width(Context, R[2], false) &&
+         (!Accumulate || (A64_Expect_Register(Context, Operand[3], A64_ZR, R + 3) && A64_Check_Width(Context, R[3], true))))
+      {
+         int Ra = (Accumulate) ? R[3].Number : 31;
+         *Encoding = 0x9B200000 | ((Index >> 1) << 23) | (R[2].Number << 16) | ((Index & 1) << 15) |
+                     (Ra << 10) | (R[1].Number << 5) | R[0].Number;
+         Result = true;
+      }
+   }
+   else
+   {
+      // NOTE: smulh and umulh, the high half of a 128-bit product.
+      bool Unsigned = (Mnemonic == ARMV8_MNEMONIC_umulh);
+      if(A64_Expect_Operand_Count(Context, Count, 3, 3) && A64_Expect_Same_Registers(Context, Operand, 3, R) &&
+         A64_Check_Width(Context, R[0], true))
+      {
+         *Encoding = 0x9B400000 | ((u32)Unsigned << 23) | (R[2].Number << 16) | (31 << 10) | (R[1].Number << 5) | R[0].Number;
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static u32 A64_Bitfield(a64_register Rd, a64_register Rn, u32 Opc, u32 Immr, u32 Imms)
+{
+   u32 Result = ((u32)Rd.Is_64 << 31) | (Opc << 29) | 0x13000000 | ((u32)Rd.Is_64 << 22) |
+                (Immr << 16) | (Imms << 10) | (Rn.Number << 5) | Rd.Number;
+   return(Result);
+}
+
+static bool A64_Encode_Shift(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: lsl, lsr, asr and ror by a register are lslv and so on. By a
+   // constant, they are aliases of ubfm, sbfm and extr.
+   bool Result = false;
+
+   a64_register R[3];
+   if(!A64_Expect_Operand_Count(Context, Count, 3, 3) || !A64_Expect_Same_Registers(Context, Operand, 2, R))
+   {
+      return(false);
+   }
+
+   u32 Shift = Mnemonic - ARMV8_MNEMONIC_lsl;
+   int Size = (R[0].Is_64) ? 64 : 32;
+   s64 Amount = 0;
+   if(A64_Parse_Register(Operand[2]).Number >= 0)
+   {
+      if(A64_Expect_Same_Registers(Context, Operand, 3, R))
+      {
+         *Encoding = ((u32)R[0].Is_64 << 31) | 0x1AC02000 | (R[2].Number << 16) | (Shift << 10) | (R[1].Number << 5) | R[0].Number;
+         Result = true;
+      }
+   }
+   else if(A64_Parse_Constant_Range(Context, Operand[2], 0, Size - 1, &Amount))
+   {
+      u32 S = (u32)Amount;
+      switch(Mnemonic)
+      {
+         case ARMV8_MNEMONIC_lsl: *Encoding = A64_Bitfield(R[0], R[1], 2, (Size - S) % Size, Size - 1 - S); break;
+         case ARMV8_MNEMONIC_lsr: *Encoding = A64_Bitfield(R[0], R[1], 2, S, Size - 1); break;
+         case ARMV8_MNEMONIC_asr: *Encoding = A64_Bitfield(R[0], R[1], 0, S, Size - 1); break;
+         default: {
+            *Encoding = ((u32)R[0].Is_64 << 31) | 0x13800000 | ((u32)R[0].Is_64 << 22) | (R[1].Number << 16) |
+                        (S << 10) | (R[1].Number << 5) | R[0].Number;
+         } break;
+      }
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Bitfield_Move(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: sbfm, bfm and ubfm, and the aliases that extract or insert a
+   // field given by its lowest bit and width.
+   bool Result = false;
+
+   a64_register R[3];
+   if(!A64_Expect_Operand_Count(Context, Count, 4, 4) || !A64_Expect_Same_Registers(Context, Operand, 2, R))
+   {
+      return(false);
+   }
+
+   int Size = (R[0].Is_64) ? 64 : 32;
+   s64 First = 0;
+   s64 Second = 0;
+   if(Mnemonic == ARMV8_MNEMONIC_extr)
+   {
+      if(A64_Expect_Same_Registers(Context, Operand, 3, R) &&
+         A64_Parse_Constant_Range(Context, Operand[3], 0, Size - 1, &First))
+      {
+         *Encoding = ((u32)R[0].Is_64 << 31) | 0x13800000 | ((u32)R[0].Is_64 << 22) | (R[2].Number << 16) |
+                     ((u32)First << 10) | (R[1].Number << 5) | R[0].Number;
+         Result = true;
+      }
+   }
+   else if(A64_Parse_Constant_Range(Context, Operand[2], 0, Size - 1, &First) &&
+           A64_Parse_Constant_Range(Context, Operand[3], (Mnemonic <= ARMV8_MNEMONIC_ubfm) ? 0 : 1,
+                                    (Mnemonic <= ARMV8_MNEMONIC_ubfm) ? (Size - 1) : (Size - First), &Second))
+   {
+      if(Mnemonic <= ARMV8_MNEMONIC_ubfm)
+      {
+         *Encoding = A64_Bitfield(R[0], R[1], Mnemonic - ARMV8_MNEMONIC_sbfm, (u32)First, (u32)Second);
+      }
+      else if(Mnemonic <= ARMV8_MNEMONIC_ubfx)
+      {
+         *Encoding = A64_Bitfield(R[0], R[1], Mnemonic - ARMV8_MNEMONIC_sbfx, (u32)First, (u32)(First + Second - 1));
+      }
+      else
+      {
+         *Encoding = A64_Bitfield(R[0], R[1], Mnemonic - ARMV8_MNEMONIC_sbfiz, (u32)((Size - First) % Size), (u32)(Second - 1));
+      }
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Extend(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: sxtb, sxth, sxtw, uxtb and uxth rd, wn. Zero-extending to 64 bits
+   // is what any write to a w register already does, so uxt only takes w.
+   bool Result = false;
+
+   a64_register Rd, Rn;
+   bool Signed = (Mnemonic <= ARMV8_MNEMONIC_sxtw);
+   u32 Imms = (Mnemonic == ARMV8_MNEMONIC_sxtb || Mnemonic == ARMV8_MNEMONIC_uxtb) ? 7 :
+              (Mnemonic == ARMV8_MNEMONIC_sxtw) ? 31 : 15;
+   if(A64_Expect_Operand_Count(Context, Count, 2, 2) &&
+      A64_Expect_Register(Context, Operand[0], A64_ZR, &Rd) &&
+      A64_Expect_Register(Context, Operand[1], A64_ZR, &Rn) &&
+      A64_Check_Width(Context, Rn, false) &&
+      ((Signed && Mnemonic != ARMV8_MNEMONIC_sxtw) || A64_Check_Width(Context, Rd, Signed)))
+   {
+      *Encoding = A64_Bitfield(Rd, Rn, (Signed) ? 0 : 2, 0, Imms);
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Conditional(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: csel, csinc, csinv and csneg rd, rn, rm, cond, in op:op2 order,
+   // and their aliases, which take the inverted condition.
+   bool Result = false;
+
+   a64_register R[3];
+   int Condition = 0;
+   u32 Op = 0;
+   int Registers = 0;
+   bool Invert = false;
+   switch(Mnemonic)
+   {
+      case ARMV8_MNEMONIC_cset:  { Op = 1; Registers = 1; } break;
+      case ARMV8_MNEMONIC_csetm: { Op = 2; Registers = 1; } break;
+      case ARMV8_MNEMONIC_cinc:  { Op = 1; Registers = 2; } break;
+      case ARMV8_MNEMONIC_cinv:  { Op = 2; Registers = 2; } break;
+      case ARMV8_MNEMONIC_cneg:  { Op = 3; Registers = 2; } break;
+      default: { Op = Mnemonic - ARMV8_MNEMONIC_csel; Registers = 3; } break;
+   }
+   Invert = (Registers < 3);
+
+   if(A64_Expect_Operand_Count(Context, Count, Registers + 1, Registers + 1) &&
+      A64_Expect_Same_Registers(Context, Operand, Registers, R))
+   {
+      if(!A64_Parse_Condition(Operand[Registers], &Condition))
+      {
+         Report_Error(Context, "Expected a condition, got \"%.*s\".", SF(Operand[Registers]));
+      }
+      else if(Invert && Condition >= A64_CONDITION_AL)
+      {
+         Report_Error(Context, "al and nv can't be used here.");
+      }
+      else
+      {
+         int Rn = (Registers == 1) ? 31 : R[1].Number;
+         int Rm = (Registers == 3) ? R[2].Number : Rn;
+         Condition ^= Invert;
+         *Encoding = ((u32)R[0].Is_64 << 31) | ((Op >> 1) << 30) | 0x1A800000 | (Rm << 16) | (Condition << 12) |
+                     ((Op & 1) << 10) | (Rn << 5) | R[0].Number;
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Conditional_Compare(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: ccmn and ccmp rn, rm|imm5, nzcv, cond.
+   bool Result = false;
+
+   a64_register Rn;
+   a64_register Rm = {0};
+   s64 Immediate = 0;
+   s64 Flags = 0;
+   int Condition = 0;
+   if(!A64_Expect_Operand_Count(Context, Count, 4, 4) || !A64_Expect_Register(Context, Operand[0], A64_ZR, &Rn))
+   {
+      return(false);
+   }
+
+   bool Is_Register = (A64_Parse_Register(Operand[1]).Number >= 0);
+   if((Is_Register) ? (A64_Expect_Register(Context, Operand[1], A64_ZR, &Rm) && A64_Check_Width(Context, Rm, Rn.Is_64))
+                    : A64_Parse_Constant_Range(Context, Operand[1], 0, 31, &Immediate))
+   {
+      if(!A64_Parse_Constant_Range(Context, Operand[2], 0, 15, &Flags))
+      {
+         // NOTE: Already reported.
+      }
+      else if(!A64_Parse_Condition(Operand[3], &Condition))
+      {
+         Report_Error(Context, "Expected a condition, got \"%.*s\".", SF(Operand[3]));
+      }
+      else
+      {
+         u32 Field = (Is_Register) ? (u32)Rm.Number : (u32)Immediate;
+         *Encoding = ((u32)Rn.Is_64 << 31) | ((Mnemonic - ARMV8_MNEMONIC_ccmn) << 30) | 0x3A400000 | (Field << 16) |
+                     (Condition << 12) | ((u32)!Is_Register << 11) | (Rn.Number << 5) | (u32)Flags;
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Load_Literal(assembler_context *Context, a64_register Rt, string Literal, u32 *Encoding)
+{
+   // NOTE: A known value that fits a single mov becomes one, anything else is
+   // loaded PC-relative from the literal pool, within 1 MB either way.
+   bool Result = false;
+
+   u64 Value = 0;
+   symbol_id Label = 0;
+   index Minimum = Context->Current_Address - 0x100000;
+   index Maximum = Context->Current_Address + 0xFFFFC;
+   int Width = (Rt.Is_64) ? 8 : 4;
+   if(Literal.Length && ((Literal.Data[0] >= '0' && Literal.Data[0] <= '9') || Literal.Data[0] == '-'))
+   {
+      if(A64_Parse_Width_Constant(Context, Literal, Rt.Is_64, &Value))
+      {
+         if(A64_Encode_Move_Immediate(Rt, Value, Encoding))
+         {
+            Result = true;
+         }
+         else
+         {
+            Label = Add_Literal(Context, Value, false, Width, Minimum, Maximum);
+         }
+      }
+   }
+   else if(Literal.Length)
+   {
+      symbol_id Symbol = Intern_Symbol(&Context->Symbols, Literal);
+      lookup_result Lookup = Resolve_Symbol(Context, Symbol);
+      Label = (Lookup.Found)
+         ? Add_Literal(Context, Lookup.Value, false, Width, Minimum, Maximum)
+         : Add_Literal(Context, Symbol, true, Width, Minimum, Maximum);
+   }
+   else
+   {
+      Report_Error(Context, "Missing literal after \"=\".");
+   }
+
+   if(Label)
+   {
+      Request_Relocation(Context, Label, Context->Current_Address, 4, RELOCATION_A64_BRANCH19, ENDIAN_LITTLE);
+      *Encoding = ((u32)Rt.Is_64 << 30) | 0x18000000 | Rt.Number;
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Load_Store(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
 {
-   (void)Context;
+   // NOTE: Single register transfers. The mnemonics come in threes (store,
+   // load, signed load) for each size, so the size and opc fields follow from
+   // the enum value, except that ldr and str take their size from the
+   // register. Addresses may be:
+   //
+   //    [xn]                  [xn, imm]             [xn, %lo12(symbol)]
+   //    [xn, imm]!            [xn], imm             [xn, xm{, lsl n}]
+   //    [xn, wm, uxtw|sxtw{ n}]                     label or =value
+   //
+   // An offset that doesn't fit the scaled unsigned form falls back to the
+   // unscaled one, as ldur would encode it.
+   bool Result = false;
+   if(!A64_Expect_Operand_Count(Context, Count, 2, 3))
+   {
+      return(false);
+   }
+
+   bool Unscaled = (Mnemonic >= ARMV8_MNEMONIC_sturb);
+   u32 Index = Mnemonic - ((Unscaled) ? ARMV8_MNEMONIC_sturb : ARMV8_MNEMONIC_strb);
+   u32 Kind = Index % 3; // Store, load, signed load.
+   u32 Size = Index / 3;
+
+   // NOTE: ldr, str, ldur and stur also take b, h, s, d and q registers,
+   // through the same forms with the V bit set. q registers have no size of
+   // their own, and take opc 2 and 3 instead.
+   a64_register Rt = {0};
+   a64_vector Vt = A64_Parse_Vector(Operand[0]);
+   u32 Base = 0;
+   u32 Literal_Encoding = 0;
+   if(Vt.Number >= 0)
+   {
+      if(Size != 2 || Kind == 2 || !A64_Is_Scalar(Vt))
+      {
+         Report_Error(Context, "Expected a general purpose register or, for ldr and str, a b, h, s, d or q register.");
+         return(false);
+      }
+      Size = Vt.Size;
+      Base = ((Size & 3) << 30) | 0x04000000 | ((Kind + ((Size == 4) ? 2 : 0)) << 22) | Vt.Number;
+      Literal_Encoding = (Size >= 2) ? (((Size - 2) << 30) | 0x1C000000 | Vt.Number) : 0;
+   }
+   else
+   {
+      if(!A64_Expect_Register(Context, Operand[0], A64_ZR, &Rt))
+      {
+         return(false);
+      }
+      if(Size == 2 && Kind != 2)
+      {
+         Size += Rt.Is_64;
+      }
+      else if(!A64_Check_Width(Context, Rt, (Kind == 2 && (Size == 2 || Rt.Is_64))))
+      {
+         return(false);
+      }
+
+      u32 Opc = (Kind < 2) ? Kind : (Rt.Is_64) ? 2 : 3;
+      Base = (Size << 30) | (Opc << 22) | Rt.Number;
+      Literal_Encoding = (Mnemonic == ARMV8_MNEMONIC_ldrsw) ? (0x98000000 | Rt.Number) : (((u32)Rt.Is_64 << 30) | 0x18000000 | Rt.Number);
+   }
+
+   string Address = Operand[1];
+   bool Write_Back = Has_Suffix_Then_Remove(&Address, S("!"));
+   if(Has_Prefix_Then_Remove(&Address, S("=")))
+   {
+      if(Mnemonic == ARMV8_MNEMONIC_ldr && Count == 2 && !Write_Back && Vt.Number < 0)
+      {
+         Result = A64_Encode_Load_Literal(Context, Rt, Trim_Left(Address), Encoding);
+      }
+      else
+      {
+         Report_Error(Context, "Only ldr can load a literal.");
+      }
+   }
+   else if(!Has_Prefix_Then_Remove(&Address, S("[")))
+   {
+      // NOTE: A load from a label, PC-relative.
+      if((Mnemonic == ARMV8_MNEMONIC_ldr || Mnemonic == ARMV8_MNEMONIC_ldrsw) && Count == 2 && !Write_Back &&
+         Literal_Encoding && A64_Is_Label(Context, Address))
+      {
+         A64_Request_Label(Context, Address, RELOCATION_A64_BRANCH19);
+         *Encoding = Literal_Encoding;
+         Result = true;
+      }
+      else if(Mnemonic != ARMV8_MNEMONIC_ldr && Mnemonic != ARMV8_MNEMONIC_ldrsw)
+      {
+         Report_Error(Context, "Expected an address in brackets, e.g. [x1, 8].");
+      }
+   }
+   else if(!Has_Suffix_Then_Remove(&Address, S("]")))
+   {
+      Report_Error(Context, "Expected an address in brackets, e.g. [x1, 8].");
+   }
+   else
+   {
+      string Part[3];
+      int Part_Count = A64_Split_Operands(Context, Address, Part, Array_Count(Part));
+
+      a64_register Rn;
+      a64_register Rm = (Part_Count > 1) ? A64_Parse_Register(Part[1]) : (a64_register){-1, false, false};
+      string Symbol = {0};
+      s64 Offset = 0;
+      if(Part_Count < 1 || !A64_Expect_Register(Context, Part[0], A64_SP, &Rn) || !A64_Check_Width(Context, Rn, true))
+      {
+         // NOTE: Already reported.
+      }
+      else if(Count == 3 || Write_Back)
+      {
+         // NOTE: Post- and pre-indexed, with a signed 9-bit offset.
+         bool Post = (Count == 3);
+         if(Post == Write_Back || (Post && Part_Count != 1) || Unscaled)
+         {
+            Report_Error(Context, "Expected [xn, imm]! or [xn], imm.");
+         }
+         else if(A64_Parse_Constant_Range(Context, (Post) ? Operand[2] : ((Part_Count > 1) ? Part[1] : S("0")), -256, 255, &Offset))
+         {
+            *Encoding = Base | 0x38000000 | (((u32)Offset & 0x1FF) << 12) | ((Post) ? 0x400 : 0xC00) | (Rn.Number << 5);
+            Result = true;
+         }
+      }
+      else if(Rm.Number >= 0)
+      {
+         // NOTE: Register offsets, shifted by nothing or the access size.
+         int Option = A64_EXTEND_UXTX;
+         s64 Amount = 0;
+         bool Has_Amount = false;
+         if(Unscaled || Part_Count > 3)
+         {
+            Report_Error(Context, "Unsupported address.");
+         }
+         else if(Part_Count == 3 && !A64_Parse_Extend(Context, Part[2], &Option, &Amount, &Has_Amount))
+         {
+            // NOTE: Already reported.
+         }
+         else
+         {
+            Option = (Option == A64_EXTEND_LSL) ? A64_EXTEND_UXTX : Option;
+            bool Rm_64 = (Option & 1);
+            if(Option != A64_EXTEND_UXTW && Option != A64_EXTEND_UXTX && Option != 6 && Option != 7)
+            {
+               Report_Error(Context, "Register offsets take lsl, uxtw, sxtw or sxtx.");
+            }
+            else if(Has_Amount && Amount != 0 && Amount != (s64)Size)
+            {
+               Report_Error(Context, "Register offsets can only be shifted by 0 or %u.", Size);
+            }
+            else if(A64_Check_Register(Context, Rm, Part[1], A64_ZR) && A64_Check_Width(Context, Rm, Rm_64))
+            {
+               bool Scaled = Has_Amount && (Size == 0 || Amount != 0);
+               *Encoding = Base | 0x38200800 | (Rm.Number << 16) | (Option << 13) | ((u32)Scaled << 12) | (Rn.Number << 5);
+               Result = true;
+            }
+         }
+      }
+      else if(Part_Count > 2)
+      {
+         Report_Error(Context, "Unsupported address.");
+      }
+      else if(Part_Count == 2 && A64_Parse_Low12(Part[1], &Symbol))
+      {
+         if(Unscaled)
+         {
+            Report_Error(Context, "%%lo12 needs the scaled form.");
+         }
+         else
+         {
+            A64_Request_Label(Context, Symbol, (relocation_kind)(RELOCATION_A64_LO12 + Size));
+            *Encoding = Base | 0x39000000 | (Rn.Number << 5);
+            Result = true;
+         }
+      }
+      else if(Part_Count == 1 || A64_Parse_Constant(Context, Part[1], &Offset))
+      {
+         s64 Scale = (s64)1 << Size;
+         if(!Unscaled && Offset >= 0 && (Offset & (Scale - 1)) == 0 && (Offset >> Size) <= 0xFFF)
+         {
+            *Encoding = Base | 0x39000000 | ((u32)(Offset >> Size) << 10) | (Rn.Number << 5);
+            Result = true;
+         }
+         else if(Offset >= -256 && Offset <= 255)
+         {
+            *Encoding = Base | 0x38000000 | (((u32)Offset & 0x1FF) << 12) | (Rn.Number << 5);
+            Result = true;
+         }
+         else
+         {
+            Report_Error(Context, "Offset %lld is out of range.", (long long)Offset);
+         }
+      }
+   }
+
+   return(Result);
 }
 
-static ENCODE_INSTRUCTION(Encode_Instruction)
+static bool A64_Encode_Load_Store_Pair(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
 {
-   (void)Context;
-   (void)Instruction;
+   // NOTE: stp, ldp and ldpsw rt, rt2, with a signed 7-bit offset scaled by
+   // the register size: [xn{, imm}], [xn, imm]! or [xn], imm.
+   bool Result = false;
+   if(!A64_Expect_Operand_Count(Context, Count, 3, 4))
+   {
+      return(false);
+   }
+
+   a64_register Rt, Rt2, Rn;
+   bool Signed = (Mnemonic == ARMV8_MNEMONIC_ldpsw);
+   bool Load = (Mnemonic != ARMV8_MNEMONIC_stp);
+   a64_vector Vt = A64_Parse_Vector(Operand[0]);
+   a64_vector Vt2 = A64_Parse_Vector(Operand[1]);
+
+   u32 Opc = 0;
+   u32 Vector_Bit = 0;
+   int Scale = 0;
+   if(Vt.Number >= 0)
+   {
+      // NOTE: s, d and q registers, with opc 0, 1 and 2.
+      if(Signed || !A64_Is_Scalar(Vt) || Vt.Size < 2 || !A64_Is_Scalar(Vt2) || Vt2.Size != Vt.Size)
+      {
+         Report_Error(Context, "Expected two s, d or q registers.");
+         return(false);
+      }
+      Rt.Number = Vt.Number;
+      Rt2.Number = Vt2.Number;
+      Opc = Vt.Size - 2;
+      Vector_Bit = 0x04000000;
+      Scale = Vt.Size;
+   }
+   else if(!A64_Expect_Register(Context, Operand[0], A64_ZR, &Rt) ||
+           !A64_Expect_Register(Context, Operand[1], A64_ZR, &Rt2) ||
+           !A64_Check_Width(Context, Rt2, Rt.Is_64) ||
+           (Signed && !A64_Check_Width(Context, Rt, true)))
+   {
+      return(false);
+   }
+   else
+   {
+      Opc = (Signed) ? 1 : ((u32)Rt.Is_64 << 1);
+      Scale = (Rt.Is_64 && !Signed) ? 3 : 2;
+   }
+
+   string Address = Operand[2];
+   bool Write_Back = Has_Suffix_Then_Remove(&Address, S("!"));
+   bool Post = (Count == 4);
+
+   string Part[2];
+   int Part_Count = 0;
+   s64 Offset = 0;
+   if(!Has_Prefix_Then_Remove(&Address, S("[")) || !Has_Suffix_Then_Remove(&Address, S("]")))
+   {
+      Report_Error(Context, "Expected an address in brackets, e.g. [sp, -16]!.");
+   }
+   else if((Part_Count = A64_Split_Operands(Context, Address, Part, Array_Count(Part))) < 1 ||
+           !A64_Expect_Register(Context, Part[0], A64_SP, &Rn) || !A64_Check_Width(Context, Rn, true))
+   {
+      // NOTE: Already reported.
+   }
+   else if((Post && (Write_Back || Part_Count != 1)) || (Write_Back && Part_Count != 2))
+   {
+      Report_Error(Context, "Expected [xn, imm]! or [xn], imm.");
+   }
+   else if(A64_Parse_Constant_Range(Context, (Post) ? Operand[3] : ((Part_Count > 1) ? Part[1] : S("0")),
+                                    -(64 << Scale), 63 << Scale, &Offset))
+   {
+      if(Offset & ((1 << Scale) - 1))
+      {
+         Report_Error(Context, "Offset %lld must be a multiple of %d.", (long long)Offset, 1 << Scale);
+      }
+      else
+      {
+         u32 Mode = (Post) ? 0x00800000 : (Write_Back) ? 0x01800000 : 0x01000000;
+         *Encoding = (Opc << 30) | 0x28000000 | Vector_Bit | Mode | ((u32)Load << 22) | (((u32)(Offset >> Scale) & 0x7F) << 15) |
+                     (Rt2.Number << 10) | (Rn.Number << 5) | Rt.Number;
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static int A64_Encode_Conditional_Branch(assembler_context *Context, u32 Short, string Label, relocation_kind Kind, u32 *Encoding)
+{
+   // NOTE: Conditional branches reach 1 MB, or 32 KB for tbz and tbnz. Once
+   // relaxed, the opposite branch skips over a b, which reaches 128 MB. The
+   // opposite of b.cond flips the low bit of the condition, of cbz and tbz
+   // bit 24. b.al and b.nv have no opposite, and relax to a plain b.
+   symbol_id Symbol = Intern_Symbol(&Context->Symbols, Label);
+   int Result = 1;
+   bool Always = ((Short & 0xFF00000E) == 0x5400000E);
+   if(!Context->Relaxation)
+   {
+      Request_Relaxable_Relocation(Context, Symbol, Context->Current_Address, 4, Kind, ENDIAN_LITTLE);
+      Encoding[0] = Short;
+   }
+   else if(Always)
+   {
+      Request_Relocation(Context, Symbol, Context->Current_Address, 4, RELOCATION_A64_BRANCH26, ENDIAN_LITTLE);
+      Encoding[0] = 0x14000000;
+   }
+   else
+   {
+      u32 Opposite = ((Short >> 24) == 0x54) ? 0x00000001 : 0x01000000;
+      Request_Relocation(Context, Symbol, Context->Current_Address + 4, 4, RELOCATION_A64_BRANCH26, ENDIAN_LITTLE);
+      Encoding[0] = (Short ^ Opposite) | (2 << 5);
+      Encoding[1] = 0x14000000;
+      Result = 2;
+   }
+
+   return(Result);
+}
+
+static int A64_Encode_Branch(assembler_context *Context, a64_mnemonic Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: Returns the number of instructions, see A64_Encode_Conditional_Branch.
+   int Result = 0;
+
+   a64_register Rt;
+   s64 Bit = 0;
+   switch(Mnemonic.Mnemonic)
+   {
+      case ARMV8_MNEMONIC_b:
+      case ARMV8_MNEMONIC_bl: {
+         if(A64_Expect_Operand_Count(Context, Count, 1, 1) && A64_Is_Label(Context, Operand[0]))
+         {
+            if(Mnemonic.Condition >= 0)
+            {
+               Result = A64_Encode_Conditional_Branch(Context, 0x54000000 | Mnemonic.Condition, Operand[0],
+                                                      RELOCATION_A64_BRANCH19, Encoding);
+            }
+            else
+            {
+               A64_Request_Label(Context, Operand[0], RELOCATION_A64_BRANCH26);
+               *Encoding = (Mnemonic.Mnemonic == ARMV8_MNEMONIC_bl) ? 0x94000000 : 0x14000000;
+               Result = 1;
+            }
+         }
+      } break;
+
+      case ARMV8_MNEMONIC_br:
+      case ARMV8_MNEMONIC_blr:
+      case ARMV8_MNEMONIC_ret: {
+         // NOTE: ret returns through x30 unless told otherwise.
+         static u32 Opcodes[] = {0xD61F0000, 0xD63F0000, 0xD65F0000};
+         Rt = (a64_register){30, true, false};
+         bool Optional = (Mnemonic.Mnemonic == ARMV8_MNEMONIC_ret);
+         if(A64_Expect_Operand_Count(Context, Count, (Optional) ? 0 : 1, 1) &&
+            (Count == 0 || (A64_Expect_Register(Context, Operand[0], A64_ZR, &Rt) && A64_Check_Width(Context, Rt, true))))
+         {
+            *Encoding = Opcodes[Mnemonic.Mnemonic - ARMV8_MNEMONIC_br] | (Rt.Number << 5);
+            Result = 1;
+         }
+      } break;
+
+      case ARMV8_MNEMONIC_cbz:
+      case ARMV8_MNEMONIC_cbnz: {
+         if(A64_Expect_Operand_Count(Context, Count, 2, 2) &&
+            A64_Expect_Register(Context, Operand[0], A64_ZR, &Rt) && A64_Is_Label(Context, Operand[1]))
+         {
+            u32 Short = ((u32)Rt.Is_64 << 31) | 0x34000000 | ((Mnemonic.Mnemonic - ARMV8_MNEMONIC_cbz) << 24) | Rt.Number;
+            Result = A64_Encode_Conditional_Branch(Context, Short, Operand[1], RELOCATION_A64_BRANCH19, Encoding);
+         }
+      } break;
+
+      default: {
+         // NOTE: tbz and tbnz rt, bit, label.
+         if(A64_Expect_Operand_Count(Context, Count, 3, 3) &&
+            A64_Expect_Register(Context, Operand[0], A64_ZR, &Rt) &&
+            A64_Parse_Constant_Range(Context, Operand[1], 0, (Rt.Is_64) ? 63 : 31, &Bit) &&
+            A64_Is_Label(Context, Operand[2]))
+         {
+            u32 Short = ((u32)(Bit >> 5) << 31) | 0x36000000 | ((Mnemonic.Mnemonic - ARMV8_MNEMONIC_tbz) << 24) |
+                        ((u32)(Bit & 31) << 19) | Rt.Number;
+            Result = A64_Encode_Conditional_Branch(Context, Short, Operand[2], RELOCATION_A64_BRANCH14, Encoding);
+         }
+      } break;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Data_Processing(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: Everything else that operates on general purpose registers.
+   // Aliases rewrite their operands into those of the instruction they stand
+   // for, with the zero register filled in.
+   bool Result = false;
+
+   a64_register R[3];
+   string Aliased[4];
+   bool Is_64 = (Count > 0) && A64_Parse_Register(Operand[0]).Is_64;
+   switch(Mnemonic)
+   {
+      case ARMV8_MNEMONIC_cmn:
+      case ARMV8_MNEMONIC_cmp: {
+         if(A64_Expect_Operand_Count(Context, Count, 2, 3))
+         {
+            Aliased[0] = A64_Zero_Register(Is_64);
+            Aliased[1] = Operand[0];
+            Aliased[2] = Operand[1];
+            Aliased[3] = (Count == 3) ? Operand[2] : (string){0};
+            Result = A64_Encode_Add_Sub(Context, (Mnemonic == ARMV8_MNEMONIC_cmp) ? 3 : 1, Aliased, Count + 1, Encoding);
+         }
+      } break;
+
+      case ARMV8_MNEMONIC_neg:
+      case ARMV8_MNEMONIC_negs:
+      case ARMV8_MNEMONIC_mvn: {
+         if(A64_Expect_Operand_Count(Context, Count, 2, 3))
+         {
+            Aliased[0] = Operand[0];
+            Aliased[1] = A64_Zero_Register(Is_64);
+            Aliased[2] = Operand[1];
+            Aliased[3] = (Count == 3) ? Operand[2] : (string){0};
+            if(A64_Parse_Register(Operand[1]).Number < 0)
+            {
+               Report_Error(Context, "Expected a register, got \"%.*s\".", SF(Operand[1]));
+            }
+            else if(Mnemonic == ARMV8_MNEMONIC_mvn)
+            {
+               Result = A64_Encode_Logical(Context, ARMV8_MNEMONIC_orn - ARMV8_MNEMONIC_and, Aliased, Count + 1, Encoding);
+            }
+            else
+            {
+               Result = A64_Encode_Add_Sub(Context, (Mnemonic == ARMV8_MNEMONIC_neg) ? 2 : 3, Aliased, Count + 1, Encoding);
+            }
+         }
+      } break;
+
+      case ARMV8_MNEMONIC_tst: {
+         if(A64_Expect_Operand_Count(Context, Count, 2, 3))
+         {
+            Aliased[0] = A64_Zero_Register(Is_64);
+            Aliased[1] = Operand[0];
+            Aliased[2] = Operand[1];
+            Aliased[3] = (Count == 3) ? Operand[2] : (string){0};
+            Result = A64_Encode_Logical(Context, ARMV8_MNEMONIC_ands - ARMV8_MNEMONIC_and, Aliased, Count + 1, Encoding);
+         }
+      } break;
+
+      case ARMV8_MNEMONIC_udiv:
+      case ARMV8_MNEMONIC_sdiv:
+      case ARMV8_MNEMONIC_lslv:
+      case ARMV8_MNEMONIC_lsrv:
+      case ARMV8_MNEMONIC_asrv:
+      case ARMV8_MNEMONIC_rorv: {
+         static u32 Opcodes[] = {0x2, 0x3, 0x8, 0x9, 0xA, 0xB};
+         if(A64_Expect_Operand_Count(Context, Count, 3, 3) && A64_Expect_Same_Registers(Context, Operand, 3, R))
+         {
+            *Encoding = ((u32)R[0].Is_64 << 31) | 0x1AC00000 | (R[2].Number << 16) |
+                        (Opcodes[Mnemonic - ARMV8_MNEMONIC_udiv] << 10) | (R[1].Number << 5) | R[0].Number;
+            Result = true;
+         }
+      } break;
+
+      case ARMV8_MNEMONIC_rbit:
+      case ARMV8_MNEMONIC_rev16:
+      case ARMV8_MNEMONIC_rev32:
+      case ARMV8_MNEMONIC_rev:
+      case ARMV8_MNEMONIC_clz:
+      case ARMV8_MNEMONIC_cls: {
+         // NOTE: rev reverses all bytes of the register, which is opcode 2 for
+         // w registers and 3 for x registers. rev32 only exists for x.
+         static u32 Opcodes[] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5};
+         if(A64_Expect_Operand_Count(Context, Count, 2, 2) && A64_Expect_Same_Registers(Context, Operand, 2, R) &&
+            (Mnemonic != ARMV8_MNEMONIC_rev32 || A64_Check_Width(Context, R[0], true)))
+         {
+            u32 Opcode = Opcodes[Mnemonic - ARMV8_MNEMONIC_rbit];
+            if(Mnemonic == ARMV8_MNEMONIC_rev && !R[0].Is_64)
+            {
+               Opcode = 0x2;
+            }
+            *Encoding = ((u32)R[0].Is_64 << 31) | 0x5AC00000 | (Opcode << 10) | (R[1].Number << 5) | R[0].Number;
+            Result = true;
+         }
+      } break;
+
+      case ARMV8_MNEMONIC_adc:
+      case ARMV8_MNEMONIC_adcs:
+      case ARMV8_MNEMONIC_sbc:
+      case ARMV8_MNEMONIC_sbcs:
+      case ARMV8_MNEMONIC_ngc:
+      case ARMV8_MNEMONIC_ngcs: {
+         // NOTE: ngc rd, rm is sbc rd, zr, rm.
+         bool Negate = (Mnemonic >= ARMV8_MNEMONIC_ngc);
+         u32 Op = (Negate) ? (Mnemonic - ARMV8_MNEMONIC_ngc + 2) : (Mnemonic - ARMV8_MNEMONIC_adc);
+         int Expected = (Negate) ? 2 : 3;
+         if(A64_Expect_Operand_Count(Context, Count, Expected, Expected) && A64_Expect_Same_Registers(Context, Operand, Count, R))
+         {
+            int Rn = (Negate) ? 31 : R[1].Number;
+            int Rm = (Negate) ? R[1].Number : R[2].Number;
+            *Encoding = ((u32)R[0].Is_64 << 31) | ((Op >> 1) << 30) | ((Op & 1) << 29) | 0x1A000000 |
+                        (Rm << 16) | (Rn << 5) | R[0].Number;
+            Result = true;
+         }
+      } break;
+
+      case ARMV8_MNEMONIC_adr:
+      case ARMV8_MNEMONIC_adrp: {
+         // NOTE: adrp gives the 4 KB page of a symbol, and %lo12 the rest.
+         bool Page = (Mnemonic == ARMV8_MNEMONIC_adrp);
+         if(A64_Expect_Operand_Count(Context, Count, 2, 2) &&
+            A64_Expect_Register(Context, Operand[0], A64_ZR, R) && A64_Check_Width(Context, R[0], true) &&
+            A64_Is_Label(Context, Operand[1]))
+         {
+            A64_Request_Label(Context, Operand[1], (Page) ? RELOCATION_A64_PAGE21 : RELOCATION_A64_ADR21);
+            *Encoding = ((u32)Page << 31) | 0x10000000 | R[0].Number;
+            Result = true;
+         }
+      } break;
+
+      default: {
+         Report_Error(Context, "Unsupported instruction.");
+      } break;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_System(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: nop, and svc, brk and hlt with a 16-bit comment field.
+   bool Result = false;
+
+   s64 Value = 0;
+   if(Mnemonic == ARMV8_MNEMONIC_nop)
+   {
+      if(A64_Expect_Operand_Count(Context, Count, 0, 0))
+      {
+         *Encoding = 0xD503201F;
+         Result = true;
+      }
+   }
+   else if(A64_Expect_Operand_Count(Context, Count, 1, 1) && A64_Parse_Constant_Range(Context, Operand[0], 0, 0xFFFF, &Value))
+   {
+      static u32 Opcodes[] = {0xD4000001, 0xD4200000, 0xD4400000};
+      *Encoding = Opcodes[Mnemonic - ARMV8_MNEMONIC_svc] | ((u32)Value << 5);
+      Result = true;
+   }
+
+   return(Result);
+}
+
+// NOTE: Advanced SIMD. Most vector instructions fall into a few classes that
+// share a layout, so they are described by their class and opcode bits in
+// A64_SIMD_Forms, indexed by mnemonic. The opcode bits include U in bit 29
+// and, for floating point, the a bit in bit 23. Register operands are written
+// with their arrangement (v0.4s), single elements with their index (v0.s[1]).
+// Comparisons against zero take 0 as their last operand.
+
+typedef enum {
+   A64_SIMD_NONE,
+   A64_SIMD_SAME,          // vd.T, vn.T, vm.T
+   A64_SIMD_SAME_LOGICAL,  // vd.T, vn.T, vm.T on bytes, with the size field part of the opcode.
+   A64_SIMD_SAME_FLOAT,    // vd.T, vn.T, vm.T on 2s, 4s or 2d.
+   A64_SIMD_MISC,          // vd.T, vn.T
+   A64_SIMD_MISC_FLOAT,    // vd.T, vn.T on 2s, 4s or 2d.
+   A64_SIMD_ACROSS,        // A scalar of the element size from vn.T.
+   A64_SIMD_ACROSS_LONG,   // A scalar of twice the element size from vn.T.
+   A64_SIMD_ACROSS_FLOAT,  // An s register from vn.4s.
+   A64_SIMD_PAIRWISE_LONG, // vd.T2, vn.T with elements twice the size, half as many.
+   A64_SIMD_PERMUTE,       // vd.T, vn.T, vm.T
+   A64_SIMD_SHIFT_LEFT,    // vd.T, vn.T, shift
+   A64_SIMD_SHIFT_RIGHT,   // vd.T, vn.T, shift
+
+   A64_SIMD_CLASS_COUNT,
+} a64_simd_class;
+
+static u32 A64_SIMD_Class_Bases[A64_SIMD_CLASS_COUNT] =
+{
+   [A64_SIMD_SAME]          = 0x0E200400,
+   [A64_SIMD_SAME_LOGICAL]  = 0x0E200400,
+   [A64_SIMD_SAME_FLOAT]    = 0x0E200400,
+   [A64_SIMD_MISC]          = 0x0E200800,
+   [A64_SIMD_MISC_FLOAT]    = 0x0E200800,
+   [A64_SIMD_ACROSS]        = 0x0E300800,
+   [A64_SIMD_ACROSS_LONG]   = 0x0E300800,
+   [A64_SIMD_ACROSS_FLOAT]  = 0x0E300800,
+   [A64_SIMD_PAIRWISE_LONG] = 0x0E200800,
+   [A64_SIMD_PERMUTE]       = 0x0E000800,
+   [A64_SIMD_SHIFT_LEFT]    = 0x0F000400,
+   [A64_SIMD_SHIFT_RIGHT]   = 0x0F000400,
+};
+
+#define A64_B (1 << 0)
+#define A64_H (1 << 1)
+#define A64_S (1 << 2)
+#define A64_D (1 << 3)
+
+typedef struct {
+   u8 Class;
+   u8 Sizes;           // Element sizes allowed, A64_B and so on.
+   u32 Opcode;
+   u32 Element_Opcode; // Non-zero if the last operand may also be a single element.
+   u32 Zero_Opcode;    // Non-zero if the last operand may also be 0, with the layout of A64_SIMD_MISC.
+   bool Swapped;       // Aliases that compare the other way round, taking vm before vn.
+} a64_simd_form;
+
+static a64_simd_form A64_SIMD_Forms[ARMV8_MNEMONIC_COUNT] =
+{
+   [ARMV8_MNEMONIC_add]     = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00008000},
+   [ARMV8_MNEMONIC_sub]     = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20008000},
+   [ARMV8_MNEMONIC_mul]     = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x00009800, 0x00008000},
+   [ARMV8_MNEMONIC_mla]     = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x00009000, 0x20000000},
+   [ARMV8_MNEMONIC_mls]     = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x20009000, 0x20004000},
+   [ARMV8_MNEMONIC_cmeq]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20008800, 0, 0x00009000},
+   [ARMV8_MNEMONIC_cmtst]   = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00008800},
+   [ARMV8_MNEMONIC_cmgt]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00003000, 0, 0x00008000},
+   [ARMV8_MNEMONIC_cmge]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00003800, 0, 0x20008000},
+   [ARMV8_MNEMONIC_cmhi]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20003000},
+   [ARMV8_MNEMONIC_cmhs]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20003800},
+   [ARMV8_MNEMONIC_cmle]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00003800, 0, 0x20009000, true},
+   [ARMV8_MNEMONIC_cmlt]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00003000, 0, 0x0000A000, true},
+   [ARMV8_MNEMONIC_cmls]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20003800, 0, 0, true},
+   [ARMV8_MNEMONIC_cmlo]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20003000, 0, 0, true},
+   [ARMV8_MNEMONIC_smax]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x00006000},
+   [ARMV8_MNEMONIC_smin]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x00006800},
+   [ARMV8_MNEMONIC_umax]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x20006000},
+   [ARMV8_MNEMONIC_umin]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x20006800},
+   [ARMV8_MNEMONIC_addp]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x0000B800},
+   [ARMV8_MNEMONIC_sabd]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x00007000},
+   [ARMV8_MNEMONIC_uabd]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S,       0x20007000},
+   [ARMV8_MNEMONIC_sqadd]   = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00000800},
+   [ARMV8_MNEMONIC_uqadd]   = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20000800},
+   [ARMV8_MNEMONIC_sqsub]   = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00002800},
+   [ARMV8_MNEMONIC_uqsub]   = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20002800},
+   [ARMV8_MNEMONIC_sshl]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x00004000},
+   [ARMV8_MNEMONIC_ushl]    = {A64_SIMD_SAME, A64_B|A64_H|A64_S|A64_D, 0x20004000},
+
+   [ARMV8_MNEMONIC_and]     = {A64_SIMD_SAME_LOGICAL, A64_B, 0x00001800},
+   [ARMV8_MNEMONIC_bic]     = {A64_SIMD_SAME_LOGICAL, A64_B, 0x00401800},
+   [ARMV8_MNEMONIC_orr]     = {A64_SIMD_SAME_LOGICAL, A64_B, 0x00801800},
+   [ARMV8_MNEMONIC_orn]     = {A64_SIMD_SAME_LOGICAL, A64_B, 0x00C01800},
+   [ARMV8_MNEMONIC_eor]     = {A64_SIMD_SAME_LOGICAL, A64_B, 0x20001800},
+   [ARMV8_MNEMONIC_bsl]     = {A64_SIMD_SAME_LOGICAL, A64_B, 0x20401800},
+   [ARMV8_MNEMONIC_bit]     = {A64_SIMD_SAME_LOGICAL, A64_B, 0x20801800},
+   [ARMV8_MNEMONIC_bif]     = {A64_SIMD_SAME_LOGICAL, A64_B, 0x20C01800},
+
+   [ARMV8_MNEMONIC_abs]     = {A64_SIMD_MISC, A64_B|A64_H|A64_S|A64_D, 0x0000B000},
+   [ARMV8_MNEMONIC_neg]     = {A64_SIMD_MISC, A64_B|A64_H|A64_S|A64_D, 0x2000B000},
+   [ARMV8_MNEMONIC_cnt]     = {A64_SIMD_MISC, A64_B,                   0x00005000},
+   [ARMV8_MNEMONIC_not]     = {A64_SIMD_MISC, A64_B,                   0x20005000},
+   [ARMV8_MNEMONIC_mvn]     = {A64_SIMD_MISC, A64_B,                   0x20005000},
+   [ARMV8_MNEMONIC_rev64]   = {A64_SIMD_MISC, A64_B|A64_H|A64_S,       0x00000000},
+   [ARMV8_MNEMONIC_rev32]   = {A64_SIMD_MISC, A64_B|A64_H,             0x20000000},
+   [ARMV8_MNEMONIC_rev16]   = {A64_SIMD_MISC, A64_B,                   0x00001000},
+   [ARMV8_MNEMONIC_clz]     = {A64_SIMD_MISC, A64_B|A64_H|A64_S,       0x20004000},
+   [ARMV8_MNEMONIC_cls]     = {A64_SIMD_MISC, A64_B|A64_H|A64_S,       0x00004000},
+
+   [ARMV8_MNEMONIC_addv]    = {A64_SIMD_ACROSS, A64_B|A64_H|A64_S, 0x0001B000},
+   [ARMV8_MNEMONIC_smaxv]   = {A64_SIMD_ACROSS, A64_B|A64_H|A64_S, 0x0000A000},
+   [ARMV8_MNEMONIC_sminv]   = {A64_SIMD_ACROSS, A64_B|A64_H|A64_S, 0x0001A000},
+   [ARMV8_MNEMONIC_umaxv]   = {A64_SIMD_ACROSS, A64_B|A64_H|A64_S, 0x2000A000},
+   [ARMV8_MNEMONIC_uminv]   = {A64_SIMD_ACROSS, A64_B|A64_H|A64_S, 0x2001A000},
+   [ARMV8_MNEMONIC_saddlv]  = {A64_SIMD_ACROSS_LONG, A64_B|A64_H|A64_S, 0x00003000},
+   [ARMV8_MNEMONIC_uaddlv]  = {A64_SIMD_ACROSS_LONG, A64_B|A64_H|A64_S, 0x20003000},
+   [ARMV8_MNEMONIC_fmaxv]   = {A64_SIMD_ACROSS_FLOAT, A64_S, 0x2000F000},
+   [ARMV8_MNEMONIC_fminv]   = {A64_SIMD_ACROSS_FLOAT, A64_S, 0x2080F000},
+   [ARMV8_MNEMONIC_fmaxnmv] = {A64_SIMD_ACROSS_FLOAT, A64_S, 0x2000C000},
+   [ARMV8_MNEMONIC_fminnmv] = {A64_SIMD_ACROSS_FLOAT, A64_S, 0x2080C000},
+
+   [ARMV8_MNEMONIC_saddlp]  = {A64_SIMD_PAIRWISE_LONG, A64_B|A64_H|A64_S, 0x00002000},
+   [ARMV8_MNEMONIC_uaddlp]  = {A64_SIMD_PAIRWISE_LONG, A64_B|A64_H|A64_S, 0x20002000},
+   [ARMV8_MNEMONIC_sadalp]  = {A64_SIMD_PAIRWISE_LONG, A64_B|A64_H|A64_S, 0x00006000},
+   [ARMV8_MNEMONIC_uadalp]  = {A64_SIMD_PAIRWISE_LONG, A64_B|A64_H|A64_S, 0x20006000},
+
+   [ARMV8_MNEMONIC_shl]     = {A64_SIMD_SHIFT_LEFT,  A64_B|A64_H|A64_S|A64_D, 0x00005000},
+   [ARMV8_MNEMONIC_sshr]    = {A64_SIMD_SHIFT_RIGHT, A64_B|A64_H|A64_S|A64_D, 0x00000000},
+   [ARMV8_MNEMONIC_ushr]    = {A64_SIMD_SHIFT_RIGHT, A64_B|A64_H|A64_S|A64_D, 0x20000000},
+   [ARMV8_MNEMONIC_ssra]    = {A64_SIMD_SHIFT_RIGHT, A64_B|A64_H|A64_S|A64_D, 0x00001000},
+   [ARMV8_MNEMONIC_usra]    = {A64_SIMD_SHIFT_RIGHT, A64_B|A64_H|A64_S|A64_D, 0x20001000},
+
+   [ARMV8_MNEMONIC_uzp1]    = {A64_SIMD_PERMUTE, A64_B|A64_H|A64_S|A64_D, 0x00001000},
+   [ARMV8_MNEMONIC_trn1]    = {A64_SIMD_PERMUTE, A64_B|A64_H|A64_S|A64_D, 0x00002000},
+   [ARMV8_MNEMONIC_zip1]    = {A64_SIMD_PERMUTE, A64_B|A64_H|A64_S|A64_D, 0x00003000},
+   [ARMV8_MNEMONIC_uzp2]    = {A64_SIMD_PERMUTE, A64_B|A64_H|A64_S|A64_D, 0x00005000},
+   [ARMV8_MNEMONIC_trn2]    = {A64_SIMD_PERMUTE, A64_B|A64_H|A64_S|A64_D, 0x00006000},
+   [ARMV8_MNEMONIC_zip2]    = {A64_SIMD_PERMUTE, A64_B|A64_H|A64_S|A64_D, 0x00007000},
+
+   [ARMV8_MNEMONIC_fmul]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x2000D800, 0x00009000},
+   [ARMV8_MNEMONIC_fdiv]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x2000F800},
+   [ARMV8_MNEMONIC_fadd]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0000D000},
+   [ARMV8_MNEMONIC_fsub]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0080D000},
+   [ARMV8_MNEMONIC_fmax]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0000F000},
+   [ARMV8_MNEMONIC_fmin]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0080F000},
+   [ARMV8_MNEMONIC_fmaxnm]  = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0000C000},
+   [ARMV8_MNEMONIC_fminnm]  = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0080C000},
+   [ARMV8_MNEMONIC_fmla]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0000C800, 0x00001000},
+   [ARMV8_MNEMONIC_fmls]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0080C800, 0x00005000},
+   [ARMV8_MNEMONIC_fabd]    = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x2080D000},
+   [ARMV8_MNEMONIC_faddp]   = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x2000D000},
+   [ARMV8_MNEMONIC_fcmeq]   = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x0000E000, 0, 0x0080D000},
+   [ARMV8_MNEMONIC_fcmge]   = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x2000E000, 0, 0x2080C000},
+   [ARMV8_MNEMONIC_fcmgt]   = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x2080E000, 0, 0x0080C000},
+   [ARMV8_MNEMONIC_fcmle]   = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x2000E000, 0, 0x2080D000, true},
+   [ARMV8_MNEMONIC_fcmlt]   = {A64_SIMD_SAME_FLOAT, A64_S|A64_D, 0x2080E000, 0, 0x0080E000, true},
+
+   [ARMV8_MNEMONIC_fabs]    = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x0080F000},
+   [ARMV8_MNEMONIC_fneg]    = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x2080F000},
+   [ARMV8_MNEMONIC_fsqrt]   = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x2081F000},
+   [ARMV8_MNEMONIC_scvtf]   = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x0001D000},
+   [ARMV8_MNEMONIC_ucvtf]   = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x2001D000},
+   [ARMV8_MNEMONIC_fcvtzs]  = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x0081B000},
+   [ARMV8_MNEMONIC_fcvtzu]  = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x2081B000},
+   [ARMV8_MNEMONIC_frintn]  = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x00018000},
+   [ARMV8_MNEMONIC_frintm]  = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x00019000},
+   [ARMV8_MNEMONIC_frintp]  = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x00818000},
+   [ARMV8_MNEMONIC_frintz]  = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x00819000},
+   [ARMV8_MNEMONIC_frecpe]  = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x0081D000},
+   [ARMV8_MNEMONIC_frsqrte] = {A64_SIMD_MISC_FLOAT, A64_S|A64_D, 0x2081D000},
+};
+
+static bool A64_Is_Zero(string Operand)
+{
+   bool Result = (Equals(Operand, S("0")) || Equals(Operand, S("0.0")));
+   return(Result);
+}
+
+static bool A64_Expect_Arrangement(assembler_context *Context, string Operand, a64_vector *Vector)
+{
+   *Vector = A64_Parse_Vector(Operand);
+   bool Result = (Vector->Number >= 0 && Vector->Lanes > 0);
+   if(!Result)
+   {
+      Report_Error(Context, "Expected a vector register such as v0.4s, got \"%.*s\".", SF(Operand));
+   }
+
+   return(Result);
+}
+
+static bool A64_Expect_Element(assembler_context *Context, string Operand, a64_vector *Vector)
+{
+   *Vector = A64_Parse_Vector(Operand);
+   bool Result = (Vector->Number >= 0 && Vector->Index >= 0);
+   if(!Result)
+   {
+      Report_Error(Context, "Expected a vector element such as v0.s[1], got \"%.*s\".", SF(Operand));
+   }
+
+   return(Result);
+}
+
+static bool A64_Check_Arrangement(assembler_context *Context, a64_vector Vector, a64_vector Expected)
+{
+   bool Result = (Vector.Size == Expected.Size && Vector.Lanes == Expected.Lanes);
+   if(!Result)
+   {
+      Report_Error(Context, "Vector arrangements must match.");
+   }
+
+   return(Result);
+}
 
+static bool A64_Check_Element_Size(assembler_context *Context, a64_vector Vector, int Sizes)
+{
+   // NOTE: 64-bit elements only come in pairs, there is no vector form of 1d.
+   bool Result = ((Sizes >> Vector.Size) & 1) && (Vector.Size != 3 || Vector.Lanes != 1);
+   if(!Result)
+   {
+      Report_Error(Context, "Unsupported vector arrangement.");
+   }
+
+   return(Result);
+}
+
+static u32 A64_Q(a64_vector Vector)
+{
+   // NOTE: Bit 30 is set for 128-bit arrangements.
+   u32 Result = (u32)((Vector.Lanes << Vector.Size) == 16) << 30;
+   return(Result);
+}
+
+static u32 A64_Element_Field(a64_vector Vector)
+{
+   // NOTE: The imm5 field of copies, with the element size marked by its
+   // lowest set bit and the index above it.
+   u32 Result = (((u32)Vector.Index << 1) | 1) << Vector.Size;
+   return(Result);
+}
+
+static bool A64_Encode_SIMD_Element(assembler_context *Context, a64_simd_form Form, a64_vector *Vector, u32 *Encoding)
+{
+   // NOTE: vd.T, vn.T, vm.Ts[index]. The index is spread over the H, L and
+   // M bits, with M taking the top bit of vm for 32- and 64-bit elements, so
+   // 16-bit elements only reach v0 to v15.
+   bool Result = false;
+
+   bool Float = (Form.Class == A64_SIMD_SAME_FLOAT);
+   a64_vector Vd = Vector[0];
+   a64_vector Vn = Vector[1];
+   a64_vector Vm = Vector[2];
+   if(!A64_Check_Element_Size(Context, Vd, (Float) ? (A64_S|A64_D) : (A64_H|A64_S)))
+   {
+      // NOTE: Already reported.
+   }
+   else if(Vm.Size != Vd.Size)
+   {
+      Report_Error(Context, "The element must have the size of the vector elements.");
+   }
+   else if(Vm.Size == 1 && Vm.Number > 15)
+   {
+      Report_Error(Context, "16-bit elements can only come from v0 to v15.");
+   }
+   else
+   {
+      u32 Index = (u32)Vm.Index;
+      u32 Index_Bits = (Vm.Size == 1) ? (((Index >> 2) << 11) | (((Index >> 1) & 1) << 21) | ((Index & 1) << 20)) :
+                       (Vm.Size == 2) ? (((Index >> 1) << 11) | ((Index & 1) << 21)) : (Index << 11);
+      u32 Size_Bits = (Float) ? (0x00800000 | ((u32)(Vd.Size == 3) << 22)) : ((u32)Vd.Size << 22);
+      *Encoding = 0x0F000000 | A64_Q(Vd) | Form.Element_Opcode | Size_Bits | Index_Bits | (Vm.Number << 16) |
+                  (Vn.Number << 5) | Vd.Number;
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_SIMD_Form(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   bool Result = false;
+
+   a64_simd_form Form = A64_SIMD_Forms[Mnemonic];
+   bool Shift = (Form.Class == A64_SIMD_SHIFT_LEFT || Form.Class == A64_SIMD_SHIFT_RIGHT);
+   bool Float = (Form.Class == A64_SIMD_SAME_FLOAT || Form.Class == A64_SIMD_MISC_FLOAT || Form.Class == A64_SIMD_ACROSS_FLOAT);
+   bool Across = (Form.Class == A64_SIMD_ACROSS || Form.Class == A64_SIMD_ACROSS_LONG || Form.Class == A64_SIMD_ACROSS_FLOAT);
+   bool Long = (Form.Class == A64_SIMD_ACROSS_LONG || Form.Class == A64_SIMD_PAIRWISE_LONG);
+   bool Zero = (Form.Zero_Opcode && Count == 3 && A64_Is_Zero(Operand[2]));
+   int Registers = (Form.Class == A64_SIMD_MISC || Form.Class == A64_SIMD_MISC_FLOAT ||
+                    Form.Class == A64_SIMD_PAIRWISE_LONG || Across || Shift || Zero) ? 2 : 3;
+   if(!A64_Expect_Operand_Count(Context, Count, Registers + Shift + Zero, Registers + Shift + Zero))
+   {
+      return(false);
+   }
+
+   a64_vector Vector[3];
+   if(Form.Element_Opcode && A64_Parse_Vector(Operand[2]).Index >= 0)
+   {
+      Result = A64_Expect_Arrangement(Context, Operand[0], Vector + 0) &&
+               A64_Expect_Arrangement(Context, Operand[1], Vector + 1) &&
+               A64_Check_Arrangement(Context, Vector[1], Vector[0]) &&
+               A64_Expect_Element(Context, Operand[2], Vector + 2) &&
+               A64_Encode_SIMD_Element(Context, Form, Vector, Encoding);
+      return(Result);
+   }
+
+   // NOTE: Reductions write a scalar and long pairwise additions a wider
+   // arrangement, the rest take one arrangement throughout.
+   int First = (Across || Form.Class == A64_SIMD_PAIRWISE_LONG) ? 1 : 0;
+   for(int Index = First; Index < Registers; ++Index)
+   {
+      if(!A64_Expect_Arrangement(Context, Operand[Index], Vector + Index) ||
+         !A64_Check_Arrangement(Context, Vector[Index], Vector[First]))
+      {
+         return(false);
+      }
+   }
+
+   a64_vector Source = Vector[First];
+   if(!A64_Check_Element_Size(Context, Source, Form.Sizes))
+   {
+      return(false);
+   }
+
+   u32 Size_Bits = ((u32)Source.Size << 22);
+   if(Float)
+   {
+      Size_Bits = ((u32)(Source.Size == 3) << 22);
+   }
+   else if(Form.Class == A64_SIMD_SAME_LOGICAL || Shift)
+   {
+      Size_Bits = 0;
+   }
+
+   if(Form.Swapped && !Zero)
+   {
+      a64_vector Swap = Vector[1];
+      Vector[1] = Vector[2];
+      Vector[2] = Swap;
+   }
+
+   u32 Opcode = (Zero) ? (A64_SIMD_Class_Bases[A64_SIMD_MISC] | Form.Zero_Opcode) : (A64_SIMD_Class_Bases[Form.Class] | Form.Opcode);
+   u32 Base = Opcode | A64_Q(Source) | Size_Bits | (Vector[1].Number << 5);
+   if(Across)
+   {
+      Vector[0] = A64_Parse_Vector(Operand[0]);
+      if(!A64_Is_Scalar(Vector[0]) || Vector[0].Size != Source.Size + Long)
+      {
+         Report_Error(Context, "Expected a %c register for the result.", "bhsd"[Source.Size + Long]);
+      }
+      else if(Source.Size == 2 && Source.Lanes != 4)
+      {
+         Report_Error(Context, "Unsupported vector arrangement.");
+      }
+      else
+      {
+         *Encoding = Base | Vector[0].Number;
+         Result = true;
+      }
+   }
+   else if(Form.Class == A64_SIMD_PAIRWISE_LONG)
+   {
+      if(!A64_Expect_Arrangement(Context, Operand[0], Vector + 0))
+      {
+         // NOTE: Already reported.
+      }
+      else if(Vector[0].Size != Source.Size + 1 || Vector[0].Lanes * 2 != Source.Lanes)
+      {
+         Report_Error(Context, "The result must have elements twice the size, half as many.");
+      }
+      else
+      {
+         *Encoding = Base | Vector[0].Number;
+         Result = true;
+      }
+   }
+   else if(Shift)
+   {
+      // NOTE: immh:immb holds the element size plus a left shift, or twice
+      // the element size minus a right shift.
+      int Bits = 8 << Source.Size;
+      bool Left = (Form.Class == A64_SIMD_SHIFT_LEFT);
+      s64 Amount = 0;
+      if(A64_Parse_Constant_Range(Context, Operand[2], (Left) ? 0 : 1, (Left) ? (Bits - 1) : Bits, &Amount))
+      {
+         u32 Immediate = (Left) ? (u32)(Bits + Amount) : (u32)(2 * Bits - Amount);
+         *Encoding = Base | (Immediate << 16) | Vector[0].Number;
+         Result = true;
+      }
+   }
+   else
+   {
+      *Encoding = Base | ((Registers == 3) ? (Vector[2].Number << 16) : 0) | Vector[0].Number;
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_SIMD_Move_Immediate(assembler_context *Context, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: movi vd.T, imm8{, lsl n}, with the shift inferred from the value
+   // if not given, or movi vd.2d (or dd), imm64 where every byte is 0x00 or
+   // 0xFF.
+   bool Result = false;
+
+   a64_vector Vd = A64_Parse_Vector(Operand[0]);
+   s64 Value = 0;
+   s64 Shift = -1;
+   if(!(Vd.Number >= 0 && (Vd.Lanes > 0 || (A64_Is_Scalar(Vd) && Vd.Size == 3))))
+   {
+      Report_Error(Context, "Expected a vector register such as v0.4s, or a d register.");
+   }
+   else if(!A64_Parse_Constant(Context, Operand[1], &Value))
+   {
+      // NOTE: Already reported.
+   }
+   else if(Count == 3 && !(Has_Prefix_Then_Remove(&Operand[2], S("lsl ")) &&
+                           A64_Parse_Constant_Range(Context, Trim(Operand[2]), 0, 24, &Shift)))
+   {
+      Report_Error(Context, "Expected lsl 0, 8, 16 or 24.");
+   }
+   else
+   {
+      u32 Op = 0;
+      u32 Cmode = 0xE;
+      u32 Immediate = 0;
+      bool Valid = true;
+      if(Vd.Size == 3)
+      {
+         Op = 1;
+         for(int Byte = 0; Byte < 8; ++Byte)
+         {
+            u8 Part = (u8)((u64)Value >> (Byte * 8));
+            Valid = Valid && (Part == 0x00 || Part == 0xFF);
+            Immediate |= (u32)(Part & 1) << Byte;
+         }
+         Valid = Valid && Shift <= 0;
+      }
+      else
+      {
+         // NOTE: A single non-zero byte, shifted into place.
+         int Shifts = (Vd.Size == 0) ? 1 : (Vd.Size == 1) ? 2 : 4;
+         if(Shift > 0)
+         {
+            Value = (Value >= 0 && Value <= 0xFF) ? (Value << Shift) : -1;
+         }
+         else if(Shift < 0)
+         {
+            for(Shift = 0; Shift < (Shifts - 1) * 8 && (Value & ~((s64)0xFF << Shift)); Shift += 8)
+            {
+            }
+         }
+         Valid = ((Shift & 7) == 0 && Shift < Shifts * 8 && Value >= 0 && (Value >> Shift) <= 0xFF &&
+                  ((Value >> Shift) << Shift) == Value);
+         Immediate = (u32)(Value >> Shift);
+         Cmode = (Vd.Size == 0) ? 0xE : (Vd.Size == 1) ? (0x8 | (u32)(Shift / 4)) : (u32)(Shift / 4);
+      }
+
+      if(!Valid)
+      {
+         Report_Error(Context, "Immediate %lld can't be encoded for this arrangement.", (long long)Value);
+      }
+      else if(Vd.Lanes == 1)
+      {
+         Report_Error(Context, "Unsupported vector arrangement.");
+      }
+      else
+      {
+         *Encoding = 0x0F000400 | A64_Q(Vd) | (Op << 29) | ((Immediate >> 5) << 16) | (Cmode << 12) |
+                     ((Immediate & 31) << 5) | Vd.Number;
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_SIMD_Copy(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: dup, ins, umov and smov, and the mov aliases of ins, umov and
+   // orr. Which one is meant follows from the operands.
+   bool Result = false;
+   if(Mnemonic == ARMV8_MNEMONIC_movi)
+   {
+      Result = (A64_Expect_Operand_Count(Context, Count, 2, 3) && A64_Encode_SIMD_Move_Immediate(Context, Operand, Count, Encoding));
+      return(Result);
+   }
+   if(!A64_Expect_Operand_Count(Context, Count, 2, 2))
+   {
+      return(false);
+   }
+
+   a64_vector Vd = A64_Parse_Vector(Operand[0]);
+   a64_vector Vn = A64_Parse_Vector(Operand[1]);
+   a64_register Rd = A64_Parse_Register(Operand[0]);
+   a64_register Rn = A64_Parse_Register(Operand[1]);
+   bool Is_Move = (Mnemonic == ARMV8_MNEMONIC_mov);
+   if(Mnemonic == ARMV8_MNEMONIC_dup)
+   {
+      if(!A64_Expect_Arrangement(Context, Operand[0], &Vd) || !A64_Check_Element_Size(Context, Vd, A64_B|A64_H|A64_S|A64_D))
+      {
+         // NOTE: Already reported.
+      }
+      else if(Rn.Number >= 0)
+      {
+         if(A64_Check_Register(Context, Rn, Operand[1], A64_ZR) && A64_Check_Width(Context, Rn, Vd.Size == 3))
+         {
+            Vd.Index = 0;
+            *Encoding = 0x0E000C00 | A64_Q(Vd) | (A64_Element_Field(Vd) << 16) | (Rn.Number << 5) | Vd.Number;
+            Result = true;
+         }
+      }
+      else if(A64_Expect_Element(Context, Operand[1], &Vn))
+      {
+         if(Vn.Size != Vd.Size)
+         {
+            Report_Error(Context, "The element must have the size of the vector elements.");
+         }
+         else
+         {
+            *Encoding = 0x0E000400 | A64_Q(Vd) | (A64_Element_Field(Vn) << 16) | (Vn.Number << 5) | Vd.Number;
+            Result = true;
+         }
+      }
+   }
+   else if((Is_Move || Mnemonic == ARMV8_MNEMONIC_ins) && Vd.Index >= 0)
+   {
+      if(Rn.Number >= 0)
+      {
+         if(A64_Check_Register(Context, Rn, Operand[1], A64_ZR) && A64_Check_Width(Context, Rn, Vd.Size == 3))
+         {
+            *Encoding = 0x4E001C00 | (A64_Element_Field(Vd) << 16) | (Rn.Number << 5) | Vd.Number;
+            Result = true;
+         }
+      }
+      else if(A64_Expect_Element(Context, Operand[1], &Vn))
+      {
+         if(Vn.Size != Vd.Size)
+         {
+            Report_Error(Context, "Both elements must have the same size.");
+         }
+         else
+         {
+            *Encoding = 0x6E000400 | (A64_Element_Field(Vd) << 16) | (((u32)Vn.Index << Vn.Size) << 11) |
+                        (Vn.Number << 5) | Vd.Number;
+            Result = true;
+         }
+      }
+   }
+   else if((Is_Move || Mnemonic == ARMV8_MNEMONIC_umov || Mnemonic == ARMV8_MNEMONIC_smov) && Rd.Number >= 0)
+   {
+      // NOTE: umov writes a w register for elements up to 32 bits and an x
+      // register for 64 bits, smov either for elements smaller than that.
+      bool Signed = (Mnemonic == ARMV8_MNEMONIC_smov);
+      if(!A64_Check_Register(Context, Rd, Operand[0], A64_ZR) || !A64_Expect_Element(Context, Operand[1], &Vn))
+      {
+         // NOTE: Already reported.
+      }
+      else if((Signed) ? (Vn.Size == 3 || (Vn.Size == 2 && !Rd.Is_64)) : (Rd.Is_64 != (Vn.Size == 3)) || (Is_Move && Vn.Size < 2))
+      {
+         Report_Error(Context, "Unsupported element size for a %s register.", (Rd.Is_64) ? "64-bit x" : "32-bit w");
+      }
+      else
+      {
+         u32 Q = (u32)((Signed) ? Rd.Is_64 : (Vn.Size == 3)) << 30;
+         *Encoding = ((Signed) ? 0x0E002C00 : 0x0E003C00) | Q | (A64_Element_Field(Vn) << 16) | (Vn.Number << 5) | Rd.Number;
+         Result = true;
+      }
+   }
+   else if(Is_Move && Vd.Lanes > 0)
+   {
+      if(A64_Expect_Arrangement(Context, Operand[1], &Vn) && A64_Check_Arrangement(Context, Vn, Vd))
+      {
+         *Encoding = 0x0EA01C00 | A64_Q(Vd) | (Vn.Number << 16) | (Vn.Number << 5) | Vd.Number;
+         Result = true;
+      }
+   }
+   else
+   {
+      Report_Error(Context, "Unsupported operands.");
+   }
+
+   return(Result);
+}
+
+static int A64_Parse_Vector_List(assembler_context *Context, string Operand, a64_vector *First, int *Index)
+{
+   // NOTE: {v0.4s, v1.4s} or {v0.4s-v3.4s}, of up to four consecutive
+   // registers, wrapping around after v31. Single structures follow the list
+   // with an index, as in {v0.s, v1.s}[1]. Returns the register count, or 0.
+   int Result = 0;
+
+   *Index = -1;
+   index Close = 0;
+   while(Close < Operand.Length && Operand.Data[Close] != '}')
+   {
+      Close++;
+   }
+
+   string After = (Close < Operand.Length) ? Trim((string){Operand.Data + Close + 1, Operand.Length - Close - 1}) : (string){0};
+   if(Close < Operand.Length && Has_Prefix_Then_Remove(&After, S("[")) && Has_Suffix_Then_Remove(&After, S("]")))
+   {
+      parsed_integer Parsed = Parse_Integer(Trim(After));
+      *Index = (Parsed.Ok && Parsed.Value >= 0 && Parsed.Value < 16) ? (int)Parsed.Value : -2;
+      After = (string){0};
+   }
+
+   if(Operand.Length < 2 || Operand.Data[0] != '{' || Close == Operand.Length || After.Length || *Index == -2)
+   {
+      Report_Error(Context, "Expected a register list such as {v0.4s, v1.4s}, got \"%.*s\".", SF(Operand));
+      return(0);
+   }
+
+   string List = Trim((string){Operand.Data + 1, Close - 1});
+   cut Range = Cut(List, '-');
+   a64_vector Vector[4] = {{.Number = -1}};
+   if(Range.Found)
+   {
+      Vector[0] = A64_Parse_Vector(Trim(Range.Before));
+      a64_vector Last = A64_Parse_Vector(Trim(Range.After));
+      Result = ((Last.Number - Vector[0].Number) & 31) + 1;
+      if(Last.Number < 0 || Result > 4 || Last.Size != Vector[0].Size || Last.Lanes != Vector[0].Lanes)
+      {
+         Vector[0].Number = -1;
+      }
+   }
+   else
+   {
+      string Items[5];
+      Result = A64_Split_Operands(Context, List, Items, 4);
+      for(int Item = 0; Item < Result; ++Item)
+      {
+         Vector[Item] = A64_Parse_Vector(Items[Item]);
+         if(Vector[Item].Number < 0 || Vector[Item].Size != Vector[0].Size || Vector[Item].Lanes != Vector[0].Lanes ||
+            Vector[Item].Number != ((Vector[0].Number + Item) & 31))
+         {
+            Vector[0].Number = -1;
+         }
+      }
+   }
+
+   *First = Vector[0];
+   if(Result <= 0 || First->Number < 0 || First->Index >= 0 || A64_Is_Scalar(*First) || (*Index >= 0) != (First->Lanes == 0) ||
+      (*Index >= 0 && *Index >= (16 >> First->Size)))
+   {
+      Report_Error(Context, "Expected consecutive registers of one arrangement in \"%.*s\".", SF(Operand));
+      Result = 0;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_SIMD_Structure(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: ld1-ld4 and st1-st4, of whole registers or a single lane, at
+   // [xn], optionally post-indexed by the transfer size or a register:
+   //
+   //    ld1 {v0.4s-v3.4s}, [x0], 64
+   //    ld2 {v0.8h, v1.8h}, [x0], x2
+   //    st1 {v0.s}[3], [x0]
+   bool Result = false;
+   if(!A64_Expect_Operand_Count(Context, Count, 2, 3))
+   {
+      return(false);
+   }
+
+   bool Load = (Mnemonic <= ARMV8_MNEMONIC_ld4);
+   int Structure = (int)(Mnemonic - ((Load) ? ARMV8_MNEMONIC_ld1 : ARMV8_MNEMONIC_st1)) + 1;
+
+   a64_vector First;
+   int Index = -1;
+   int Registers = A64_Parse_Vector_List(Context, Operand[0], &First, &Index);
+
+   string Address = Operand[1];
+   a64_register Rn;
+   a64_register Rm = {31, true, false};
+   s64 Offset = 0;
+   if(!Registers)
+   {
+      // NOTE: Already reported.
+   }
+   else if(Structure > 1 ? (Registers != Structure) : false)
+   {
+      Report_Error(Context, "Expected %d registers.", Structure);
+   }
+   else if(!Has_Prefix_Then_Remove(&Address, S("[")) || !Has_Suffix_Then_Remove(&Address, S("]")))
+   {
+      Report_Error(Context, "Expected an address such as [x0].");
+   }
+   else if(A64_Expect_Register(Context, Trim(Address), A64_SP, &Rn) && A64_Check_Width(Context, Rn, true))
+   {
+      bool Single = (Index >= 0);
+      int Transfer = (Single) ? (Registers << First.Size) : (Registers * ((First.Lanes << First.Size)));
+      u32 Post = 0;
+      if(Count == 3)
+      {
+         Post = 0x00800000;
+         if(A64_Parse_Register(Operand[2]).Number >= 0)
+         {
+            if(!A64_Expect_Register(Context, Operand[2], A64_ZR, &Rm) || !A64_Check_Width(Context, Rm, true))
+            {
+               return(false);
+            }
+            if(Rm.Number == 31)
+            {
+               Report_Error(Context, "Post-index by the transfer size, not xzr.");
+               return(false);
+            }
+         }
+         else if(!A64_Parse_Constant(Context, Operand[2], &Offset))
+         {
+            return(false);
+         }
+         else if(Offset != Transfer)
+         {
+            Report_Error(Context, "Post-index immediate must be the transfer size, %d.", Transfer);
+            return(false);
+         }
+      }
+
+      u32 Base = ((u32)Load << 22) | Post | ((Post) ? (Rm.Number << 16) : 0) | (Rn.Number << 5) | First.Number;
+      if(Single)
+      {
+         // NOTE: The byte offset of the lane is spread over Q, S and size.
+         static u32 Opcodes[] = {0, 2, 4, 4};
+         u32 Lane = (u32)Index << First.Size;
+         u32 Opcode = Opcodes[First.Size] | (Structure >= 3);
+         u32 Replicate = !(Structure & 1);
+         *Encoding = 0x0D000000 | Base | ((Lane >> 3) << 30) | (Replicate << 21) | (Opcode << 13) |
+                     (((Lane >> 2) & 1) << 12) | (((Lane & 3) | (First.Size == 3)) << 10);
+         Result = true;
+      }
+      else if(First.Size == 3 && First.Lanes == 1 && Structure > 1)
+      {
+         Report_Error(Context, "Unsupported vector arrangement.");
+      }
+      else
+      {
+         static u32 Opcodes[] = {0x7, 0xA, 0x6, 0x2};
+         u32 Opcode = (Structure == 1) ? Opcodes[Registers - 1] : (Structure == 2) ? 0x8 : (Structure == 3) ? 0x4 : 0x0;
+         *Encoding = 0x0C000000 | Base | A64_Q(First) | (Opcode << 12) | ((u32)First.Size << 10);
+         Result = true;
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_SIMD_Table(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: ext vd.T, vn.T, vm.T, index and tbl/tbx vd.T, {table}, vm.T,
+   // all on bytes, with a table of one to four 16b registers.
+   bool Result = false;
+
+   a64_vector Vd, Vn, Vm;
+   if(Mnemonic == ARMV8_MNEMONIC_ext)
+   {
+      s64 Index = 0;
+      if(A64_Expect_Operand_Count(Context, Count, 4, 4) &&
+         A64_Expect_Arrangement(Context, Operand[0], &Vd) && A64_Check_Element_Size(Context, Vd, A64_B) &&
+         A64_Expect_Arrangement(Context, Operand[1], &Vn) && A64_Check_Arrangement(Context, Vn, Vd) &&
+         A64_Expect_Arrangement(Context, Operand[2], &Vm) && A64_Check_Arrangement(Context, Vm, Vd) &&
+         A64_Parse_Constant_Range(Context, Operand[3], 0, Vd.Lanes - 1, &Index))
+      {
+         *Encoding = 0x2E000000 | A64_Q(Vd) | (Vm.Number << 16) | ((u32)Index << 11) | (Vn.Number << 5) | Vd.Number;
+         Result = true;
+      }
+   }
+   else
+   {
+      int Index = -1;
+      int Registers = 0;
+      if(A64_Expect_Operand_Count(Context, Count, 3, 3) &&
+         A64_Expect_Arrangement(Context, Operand[0], &Vd) && A64_Check_Element_Size(Context, Vd, A64_B) &&
+         (Registers = A64_Parse_Vector_List(Context, Operand[1], &Vn, &Index)) > 0 &&
+         A64_Expect_Arrangement(Context, Operand[2], &Vm) && A64_Check_Arrangement(Context, Vm, Vd))
+      {
+         if(Index >= 0 || Vn.Size != 0 || Vn.Lanes != 16)
+         {
+            Report_Error(Context, "Expected a table of 16b registers.");
+         }
+         else
+         {
+            u32 Extension = (Mnemonic == ARMV8_MNEMONIC_tbx);
+            *Encoding = 0x0E000000 | A64_Q(Vd) | (Vm.Number << 16) | ((u32)(Registers - 1) << 13) | (Extension << 12) |
+                        (Vn.Number << 5) | Vd.Number;
+            Result = true;
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static int A64_Float_Immediate(string Operand, bool *Is_Zero)
+{
+   // NOTE: Returns the imm8 of fmov for a value of the form +-(16 + m)/16 *
+   // 2^e, with m in 0 to 15 and e in -3 to 4, or -1. Zero has no imm8 but is
+   // reported, since the scalar forms move it from wzr or xzr instead.
+   int Result = -1;
+   *Is_Zero = false;
+
+   char Text[64];
+   if(Operand.Length > 0 && Operand.Length < (index)sizeof(Text))
+   {
+      memcpy(Text, Operand.Data, Operand.Length);
+      Text[Operand.Length] = 0;
+
+      char *End = 0;
+      double Value = strtod(Text, &End);
+      if(End == Text + Operand.Length)
+      {
+         *Is_Zero = (Value == 0.0 && Text[0] != '-');
+         for(int Immediate = 0; Result < 0 && Immediate < 256; ++Immediate)
+         {
+            // NOTE: VFPExpandImm, b selects the sign of the exponent.
+            int Exponent = (Immediate & 0x40) ? (((Immediate >> 4) & 3) - 3) : (((Immediate >> 4) & 3) + 1);
+            double Expanded = (16 + (Immediate & 15)) / 16.0;
+            for(; Exponent > 0; --Exponent) Expanded *= 2.0;
+            for(; Exponent < 0; ++Exponent) Expanded /= 2.0;
+            if(Immediate & 0x80) Expanded = -Expanded;
+
+            if(Expanded == Value)
+            {
+               Result = Immediate;
+            }
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Float_Move_Immediate(assembler_context *Context, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: fmov sd/dd, value and fmov vd.2s/4s/2d, value. Scalar zero is
+   // fmov from wzr or xzr, as other assemblers encode it.
+   bool Result = false;
+
+   a64_vector Fd = A64_Parse_Vector(Operand[0]);
+   bool Is_Zero = false;
+   int Immediate = (Count == 2) ? A64_Float_Immediate(Operand[1], &Is_Zero) : -1;
+   bool Scalar = A64_Is_Scalar(Fd) && (Fd.Size == 2 || Fd.Size == 3);
+   bool Vector = (Fd.Number >= 0 && ((Fd.Size == 2 && (Fd.Lanes == 2 || Fd.Lanes == 4)) || (Fd.Size == 3 && Fd.Lanes == 2)));
+   if(!A64_Expect_Operand_Count(Context, Count, 2, 2))
+   {
+      // NOTE: Already reported.
+   }
+   else if(!Scalar && !Vector)
+   {
+      Report_Error(Context, "Expected an s or d register, or v0.2s, v0.4s or v0.2d.");
+   }
+   else if(Scalar && Immediate < 0 && Is_Zero)
+   {
+      *Encoding = ((u32)(Fd.Size == 3) << 31) | 0x1E270000 | ((u32)(Fd.Size == 3) << 22) | (31 << 5) | Fd.Number;
+      Result = true;
+   }
+   else if(Immediate < 0)
+   {
+      Report_Error(Context, "Value \"%.*s\" can't be encoded by fmov, expected (16 + m)/16 * 2^e with m in 0 to 15 and e in -3 to 4.",
+                   SF(Operand[1]));
+   }
+   else if(Scalar)
+   {
+      *Encoding = 0x1E201000 | ((u32)(Fd.Size == 3) << 22) | ((u32)Immediate << 13) | Fd.Number;
+      Result = true;
+   }
+   else
+   {
+      u32 Double = (Fd.Size == 3);
+      *Encoding = 0x0F00F400 | A64_Q(Fd) | (Double << 29) | ((u32)(Immediate >> 5) << 16) | ((u32)(Immediate & 31) << 5) | Fd.Number;
+      Result = true;
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_Float_Scalar(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   // NOTE: Scalar floating point on s and d registers: the arithmetic in
+   // fmul to fminnm, which are in opcode order, the single operand fmov to
+   // fsqrt, likewise, conversions from and to general purpose registers,
+   // comparisons, conversions between precisions, which also take h
+   // registers, and faddp of a pair into a scalar.
+   bool Result = false;
+
+   a64_vector Fd = A64_Parse_Vector(Operand[0]);
+   a64_vector Fn = (Count > 1) ? A64_Parse_Vector(Operand[1]) : (a64_vector){-1, 0, 0, -1, false};
+   a64_register Rd = A64_Parse_Register(Operand[0]);
+   a64_register Rn = (Count > 1) ? A64_Parse_Register(Operand[1]) : (a64_register){-1, false, false};
+   bool Scalar_Fd = A64_Is_Scalar(Fd) && (Fd.Size == 2 || Fd.Size == 3);
+   bool Scalar_Fn = A64_Is_Scalar(Fn) && (Fn.Size == 2 || Fn.Size == 3);
+   u32 Type = (u32)(Fd.Size == 3) << 22;
+   if(Mnemonic >= ARMV8_MNEMONIC_fmul && Mnemonic <= ARMV8_MNEMONIC_fminnm)
+   {
+      a64_vector Fm = (Count > 2) ? A64_Parse_Vector(Operand[2]) : (a64_vector){-1, 0, 0, -1, false};
+      if(!A64_Expect_Operand_Count(Context, Count, 3, 3))
+      {
+         // NOTE: Already reported.
+      }
+      else if(!Scalar_Fd || !A64_Is_Scalar(Fn) || !A64_Is_Scalar(Fm) || Fn.Size != Fd.Size || Fm.Size != Fd.Size)
+      {
+         Report_Error(Context, "Expected three s or three d registers.");
+      }
+      else
+      {
+         *Encoding = 0x1E200800 | Type | (Fm.Number << 16) | ((Mnemonic - ARMV8_MNEMONIC_fmul) << 12) | (Fn.Number << 5) | Fd.Number;
+         Result = true;
+      }
+   }
+   else if(!A64_Expect_Operand_Count(Context, Count, 2, 2))
+   {
+      // NOTE: Already reported.
+   }
+   else if(Mnemonic == ARMV8_MNEMONIC_fcmp || Mnemonic == ARMV8_MNEMONIC_fcmpe)
+   {
+      // NOTE: opc bit 3 compares against zero, bit 4 signals on quiet NaNs.
+      u32 Signaling = (Mnemonic - ARMV8_MNEMONIC_fcmp) << 4;
+      if(Scalar_Fd && A64_Is_Zero(Operand[1]))
+      {
+         *Encoding = 0x1E202008 | Type | Signaling | (Fd.Number << 5);
+         Result = true;
+      }
+      else if(Scalar_Fd && Scalar_Fn && Fn.Size == Fd.Size)
+      {
+         *Encoding = 0x1E202000 | Type | (Fn.Number << 16) | Signaling | (Fd.Number << 5);
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Expected two s or two d registers, or one and 0.0.");
+      }
+   }
+   else if(Mnemonic == ARMV8_MNEMONIC_fcvt)
+   {
+      // NOTE: The source size is in ftype and the result size in opc, both
+      // 0 for s, 1 for d and 3 for h.
+      if(A64_Is_Scalar(Fd) && A64_Is_Scalar(Fn) && Fd.Size >= 1 && Fd.Size <= 3 && Fn.Size >= 1 && Fn.Size <= 3 &&
+         Fd.Size != Fn.Size)
+      {
+         u32 Source_Type = (Fn.Size == 1) ? 3 : (u32)(Fn.Size - 2);
+         u32 Result_Type = (Fd.Size == 1) ? 3 : (u32)(Fd.Size - 2);
+         *Encoding = 0x1E224000 | (Source_Type << 22) | (Result_Type << 15) | (Fn.Number << 5) | Fd.Number;
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Expected two h, s or d registers of different sizes.");
+      }
+   }
+   else if(Mnemonic == ARMV8_MNEMONIC_faddp)
+   {
+      if(Scalar_Fd && Fn.Lanes == 2 && Fn.Size == Fd.Size)
+      {
+         *Encoding = 0x7E30D800 | Type | (Fn.Number << 5) | Fd.Number;
+         Result = true;
+      }
+      else
+      {
+         Report_Error(Context, "Expected s0, v1.2s or d0, v1.2d.");
+      }
+   }
+   else if(Mnemonic >= ARMV8_MNEMONIC_fmov && Mnemonic <= ARMV8_MNEMONIC_fsqrt && Scalar_Fd && Scalar_Fn)
+   {
+      if(Fn.Size != Fd.Size)
+      {
+         Report_Error(Context, "Expected two s or two d registers.");
+      }
+      else
+      {
+         *Encoding = 0x1E204000 | Type | ((Mnemonic - ARMV8_MNEMONIC_fmov) << 15) | (Fn.Number << 5) | Fd.Number;
+         Result = true;
+      }
+   }
+   else if((Mnemonic == ARMV8_MNEMONIC_fmov || Mnemonic == ARMV8_MNEMONIC_scvtf || Mnemonic == ARMV8_MNEMONIC_ucvtf) &&
+           Scalar_Fd && Rn.Number >= 0)
+   {
+      // NOTE: fmov keeps the bits, so the sizes must match. The conversions
+      // take either.
+      bool Move = (Mnemonic == ARMV8_MNEMONIC_fmov);
+      if(A64_Check_Register(Context, Rn, Operand[1], A64_ZR) && (!Move || A64_Check_Width(Context, Rn, Fd.Size == 3)))
+      {
+         u32 Opcode = (Move) ? 0x00070000 : (0x00020000 | ((Mnemonic - ARMV8_MNEMONIC_scvtf) << 16));
+         *Encoding = ((u32)Rn.Is_64 << 31) | 0x1E200000 | Type | Opcode | (Rn.Number << 5) | Fd.Number;
+         Result = true;
+      }
+   }
+   else if((Mnemonic == ARMV8_MNEMONIC_fmov || Mnemonic == ARMV8_MNEMONIC_fcvtzs || Mnemonic == ARMV8_MNEMONIC_fcvtzu) &&
+           Rd.Number >= 0 && Scalar_Fn)
+   {
+      bool Move = (Mnemonic == ARMV8_MNEMONIC_fmov);
+      if(A64_Check_Register(Context, Rd, Operand[0], A64_ZR) && (!Move || A64_Check_Width(Context, Rd, Fn.Size == 3)))
+      {
+         u32 Opcode = (Move) ? 0x00060000 : (0x00180000 | ((Mnemonic - ARMV8_MNEMONIC_fcvtzs) << 16));
+         *Encoding = ((u32)Rd.Is_64 << 31) | 0x1E200000 | ((u32)(Fn.Size == 3) << 22) | Opcode | (Fn.Number << 5) | Rd.Number;
+         Result = true;
+      }
+   }
+   else
+   {
+      Report_Error(Context, "Unsupported operands.");
+   }
+
+   return(Result);
+}
+
+static bool A64_Is_SIMD(u32 Mnemonic, string *Operand, int Count)
+{
+   // NOTE: Mnemonics shared with scalar instructions, such as add or mov,
+   // are vector instructions when their first operand is a SIMD register, or
+   // for mov, when the source is a single element. Loads and stores handle
+   // SIMD registers themselves.
+   bool Result = (Mnemonic >= ARMV8_MNEMONIC_mla);
+   if(!Result && Count > 0 && (Mnemonic < ARMV8_MNEMONIC_strb || Mnemonic > ARMV8_MNEMONIC_ldpsw))
+   {
+      Result = (A64_Parse_Vector(Operand[0]).Number >= 0 ||
+                (Mnemonic == ARMV8_MNEMONIC_mov && Count == 2 && A64_Parse_Vector(Operand[1]).Index >= 0));
+   }
+
+   return(Result);
+}
+
+static bool A64_Encode_SIMD(assembler_context *Context, u32 Mnemonic, string *Operand, int Count, u32 *Encoding)
+{
+   bool Result = false;
+
+   bool Vector_Destination = (Count > 0 && A64_Parse_Vector(Operand[0]).Lanes > 0);
+   if(Mnemonic >= ARMV8_MNEMONIC_ld1)
+   {
+      Result = A64_Encode_SIMD_Structure(Context, Mnemonic, Operand, Count, Encoding);
+   }
+   else if((Mnemonic >= ARMV8_MNEMONIC_dup && Mnemonic <= ARMV8_MNEMONIC_movi) || Mnemonic == ARMV8_MNEMONIC_mov)
+   {
+      Result = A64_Encode_SIMD_Copy(Context, Mnemonic, Operand, Count, Encoding);
+   }
+   else if(Mnemonic >= ARMV8_MNEMONIC_ext && Mnemonic <= ARMV8_MNEMONIC_tbx)
+   {
+      Result = A64_Encode_SIMD_Table(Context, Mnemonic, Operand, Count, Encoding);
+   }
+   else if(Mnemonic == ARMV8_MNEMONIC_fmov && Count == 2 &&
+           A64_Parse_Vector(Operand[1]).Number < 0 && A64_Parse_Register(Operand[1]).Number < 0)
+   {
+      Result = A64_Encode_Float_Move_Immediate(Context, Operand, Count, Encoding);
+   }
+   else if(((Mnemonic >= ARMV8_MNEMONIC_fmul && Mnemonic <= ARMV8_MNEMONIC_fcvt) || Mnemonic == ARMV8_MNEMONIC_faddp) &&
+           Count > 0 && !Vector_Destination)
+   {
+      Result = A64_Encode_Float_Scalar(Context, Mnemonic, Operand, Count, Encoding);
+   }
+   else if(A64_SIMD_Forms[Mnemonic].Class != A64_SIMD_NONE)
+   {
+      Result = A64_Encode_SIMD_Form(Context, Mnemonic, Operand, Count, Encoding);
+   }
+   else
+   {
+      Report_Error(Context, "This instruction does not take SIMD registers.");
+   }
+
+   return(Result);
+}
+
+static INITIALIZE_ARCHITECTURE(Initialize_ARMv8)
+{
+   // NOTE: Every element size, number of ones and rotation, see
+   // A64_Encode_Bitmask. The imms field marks the element size with its
+   // leading ones, and N is set for 64-bit elements.
+   a64_bitmask *Bitmasks = Allocate(&Context->Arena, a64_bitmask, A64_BITMASK_COUNT);
+   int Count = 0;
+   for(int Size = 2; Size <= 64; Size *= 2)
+   {
+      u64 Element_Mask = (Size == 64) ? ~(u64)0 : (((u64)1 << Size) - 1);
+      for(int Ones = 1; Ones < Size; ++Ones)
+      {
+         u64 Run = ((u64)1 << Ones) - 1;
+         for(int Rotation = 0; Rotation < Size; ++Rotation)
+         {
+            u64 Element = (Rotation) ? (((Run >> Rotation) | (Run << (Size - Rotation))) & Element_Mask) : Run;
+            u64 Value = Element;
+            for(int Filled = Size; Filled < 64; Filled *= 2)
+            {
+               Value |= Value << Filled;
+            }
+
+            u32 Imms = ((~(u32)(Size - 1) << 1) & 0x3F) | (Ones - 1);
+            Bitmasks[Count].Value = Value;
+            Bitmasks[Count].Field = (u16)(((Size == 64) << 12) | (Rotation << 6) | Imms);
+            Count++;
+         }
+      }
+   }
+   assert(Count == A64_BITMASK_COUNT);
+
+   qsort(Bitmasks, Count, sizeof(*Bitmasks), Compare_A64_Bitmasks);
+
+   A64_Bitmask_Values = Allocate(&Context->Arena, u64, A64_BITMASK_COUNT);
+   A64_Bitmask_Fields = Allocate(&Context->Arena, u16, A64_BITMASK_COUNT);
+   for(int Index = 0; Index < Count; ++Index)
+   {
+      A64_Bitmask_Values[Index] = Bitmasks[Index].Value;
+      A64_Bitmask_Fields[Index] = Bitmasks[Index].Field;
+   }
+}
+
+static ENCODE_INSTRUCTION(Encode_Instruction_ARMv8)
+{
    machine_code Result = {0};
+
+   cut Instruction_Operands = Cut_Whitespace(Instruction);
+   string Mnemonic_String = Instruction_Operands.Before;
+
+   a64_mnemonic Mnemonic = A64_Parse_Mnemonic(Mnemonic_String);
+   if(Mnemonic.Found)
+   {
+      string Operand[5];
+      int Count = A64_Split_Operands(Context, Trim(Instruction_Operands.After), Operand, Array_Count(Operand));
+
+      // NOTE: Only mov and relaxed branches expand to more than one instruction.
+      u32 Op = Mnemonic.Mnemonic;
+      u32 Encoding[4] = {0};
+      int Encoding_Count = 1;
+      bool Encoded = false;
+      if(Count < 0)
+      {
+         // NOTE: Already reported.
+      }
+      else if(A64_Is_SIMD(Op, Operand, Count))
+      {
+         Encoded = A64_Encode_SIMD(Context, Op, Operand, Count, Encoding);
+      }
+      else if(Op == ARMV8_MNEMONIC_mov)
+      {
+         Encoding_Count = A64_Encode_Move(Context, Operand, Count, Encoding);
+         Encoded = (Encoding_Count > 0);
+         Encoding_Count += !Encoded;
+      }
+      else if(Op <= ARMV8_MNEMONIC_subs)
+      {
+         Encoded = A64_Encode_Add_Sub(Context, Op - ARMV8_MNEMONIC_add, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_and && Op <= ARMV8_MNEMONIC_bics)
+      {
+         Encoded = A64_Encode_Logical(Context, Op - ARMV8_MNEMONIC_and, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_movn && Op <= ARMV8_MNEMONIC_movk)
+      {
+         Encoded = A64_Encode_Move_Wide(Context, Op - ARMV8_MNEMONIC_movn, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_madd && Op <= ARMV8_MNEMONIC_umulh)
+      {
+         Encoded = A64_Encode_Multiply(Context, Op, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_lsl && Op <= ARMV8_MNEMONIC_ror)
+      {
+         Encoded = A64_Encode_Shift(Context, Op, Operand, Count, Encoding);
+      }
+      else if((Op >= ARMV8_MNEMONIC_sbfm && Op <= ARMV8_MNEMONIC_ubfiz) || Op == ARMV8_MNEMONIC_extr)
+      {
+         Encoded = A64_Encode_Bitfield_Move(Context, Op, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_sxtb && Op <= ARMV8_MNEMONIC_uxth)
+      {
+         Encoded = A64_Encode_Extend(Context, Op, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_csel && Op <= ARMV8_MNEMONIC_cneg)
+      {
+         Encoded = A64_Encode_Conditional(Context, Op, Operand, Count, Encoding);
+      }
+      else if(Op == ARMV8_MNEMONIC_ccmn || Op == ARMV8_MNEMONIC_ccmp)
+      {
+         Encoded = A64_Encode_Conditional_Compare(Context, Op, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_strb && Op <= ARMV8_MNEMONIC_ldursw)
+      {
+         Encoded = A64_Encode_Load_Store(Context, Op, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_stp && Op <= ARMV8_MNEMONIC_ldpsw)
+      {
+         Encoded = A64_Encode_Load_Store_Pair(Context, Op, Operand, Count, Encoding);
+      }
+      else if(Op >= ARMV8_MNEMONIC_b && Op <= ARMV8_MNEMONIC_tbnz)
+      {
+         Encoding_Count = A64_Encode_Branch(Context, Mnemonic, Operand, Count, Encoding);
+         Encoded = (Encoding_Count > 0);
+         Encoding_Count += !Encoded;
+      }
+      else if(Op >= ARMV8_MNEMONIC_nop && Op <= ARMV8_MNEMONIC_hlt)
+      {
+         Encoded = A64_Encode_System(Context, Op, Operand, Count, Encoding);
+      }
+      else
+      {
+         Encoded = A64_Encode_Data_Processing(Context, Op, Operand, Count, Encoding);
+      }
+
+      // NOTE: Instructions are always four bytes, so a line that failed to
+      // encode still takes the place of one and later addresses don't shift.
+      Result.Length = 4 * Encoding_Count;
+      for(int Byte_Index = 0; Encoded && Byte_Index < Result.Length; ++Byte_Index)
+      {
+         Result.Bytes[Byte_Index] = (u8)(Encoding[Byte_Index / 4] >> ((Byte_Index % 4) * 8));
+      }
+   }
+   else
+   {
+      Report_Error(Context, "Did not recognize mnemonic \"%.*s\".", SF(Mnemonic_String));
+   }
+
    return(Result);
 }
+
+static architecture Architecture_ARMv8 =
+{
+   .Name = "armv8",
+   .Aliases = {"armv8-a", "aarch64"},
+   .Endianness = ENDIAN_LITTLE,
+   .Relocation_Kinds = (RELOCATION_KIND_BIT(RELOCATION_ABSOLUTE) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_BRANCH26) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_BRANCH19) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_BRANCH14) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_ADR21) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_PAGE21) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_LO12) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_LO12_16) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_LO12_32) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_LO12_64) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_LO12_128) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_MOVW_G0) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_MOVW_G1) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_MOVW_G2) |
+                       RELOCATION_KIND_BIT(RELOCATION_A64_MOVW_G3)),
+   .Initialize = Initialize_ARMv8,
+   .Encode_Instruction = Encode_Instruction_ARMv8,
+};
@@ -1,11 +1,11 @@
 /* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
 
-static INITIALIZE_ARCHITECTURE(Initialize_Architecture)
+static INITIALIZE_ARCHITECTURE(Initialize_MIPS)
 {
    (void)Context;
 }
 
-static ENCODE_INSTRUCTION(Encode_Instruction)
+static ENCODE_INSTRUCTION(Encode_Instruction_MIPS)
 {
    (void)Context;
    (void)Instruction;
@@ -13,3 +13,17 @@ static ENCODE_INSTRUCTION(Encode_Instruction)
    machine_code Result = {0};
    return(Result);
 }
+
+static architecture Architecture_MIPS =
+{
+   .Name = "mips",
+   .Aliases = {"mips32"},
+   .Endianness = ENDIAN_BIG,
+   .Relocation_Kinds = (RELOCATION_KIND_BIT(RELOCATION_ABSOLUTE) |
+                       RELOCATION_KIND_BIT(RELOCATION_MIPS_JUMP26) |
+                       RELOCATION_KIND_BIT(RELOCATION_MIPS_BRANCH16) |
+                       RELOCATION_KIND_BIT(RELOCATION_MIPS_HI16) |
+                       RELOCATION_KIND_BIT(RELOCATION_MIPS_LO16)),
+   .Initialize = Initialize_MIPS,
+   .Encode_Instruction = Encode_Instruction_MIPS,
+};
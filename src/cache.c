@@ -0,0 +1,613 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Incremental reassembly cache, enabled with --cache <directory>. Each
+// input file gets one entry, named after a hash of its path and the default
+// architecture, which holds:
+//
+// - A content key hashing the source text, the architecture and the assembler
+//   version. If it matches, the file is not tokenized or encoded at all.
+// - The output file name, the final output segments and the file's symbol
+//   definitions, which is everything needed to reproduce a matching file.
+// - A stream of line records for instruction and data lines: the hash of the
+//   line's text, its encoded bytes before relocation, the relocations it
+//   requested, and the symbols it resolved while encoding along with their
+//   values at the time.
+//
+// When the content key doesn't match, the file is tokenized as usual, but a
+// line whose text matches a cached record, and whose resolved symbols still
+// have the same values, is replayed from the record instead of being encoded.
+//
+// With --watch and no --cache directory, entries are kept resident in memory
+// for the life of the process instead of being written to disk.
+//
+// Files that report errors are never cached, since diagnostics aren't part of
+// an entry. Backends must not fold a line's own address into its bytes other
+// than through relocations, since a replayed line may have moved. Lines that
+// request literal pool entries are never recorded.
+
+// NOTE: Bump both of these together whenever an encoder changes the bytes it
+// produces for some line or the entry layout changes, so stale entries are
+// ignored. Rebuilding without such a change keeps the cache, and the same
+// source always builds the same binary.
+#define CACHE_MAGIC 0x3330454843414341ull // "ACACHE03"
+#define ASSEMBLER_VERSION 3
+
+typedef struct {
+   u64 Magic;
+   u64 Content_Key;
+   u64 Output_Name_Length;
+   u64 Segment_Count;
+   u64 Symbol_Count;
+   u64 Line_Stream_Size;
+} cache_header;
+
+typedef struct {
+   u64 Address;
+   u64 Length;
+} cached_segment; // Followed by the segment's bytes.
+
+typedef struct {
+   u64 Value;
+   u64 Name_Length;
+} cached_symbol; // Followed by the symbol's name.
+
+typedef struct cached_line cached_line;
+struct cached_line
+{
+   u64 Text_Hash;
+   u32 Item_Size; // Bytes of cache_item records following this header.
+   u32 Length;    // Encoded bytes following the items.
+};
+
+typedef enum {
+   CACHE_ITEM_DEPENDENCY,
+   CACHE_ITEM_RELOCATION,
+} cache_item_type;
+
+typedef struct {
+   u8 Type;
+   u8 Found;      // Dependency: whether the symbol was defined.
+   u8 Width;      // Relocation fields.
+   u8 Kind;
+   u8 Endianness;
+   u8 Relaxable;
+   u8 Padding[2];
+   u64 Name_Length;
+   u64 Value;     // Dependency value, or relocation offset from the line.
+} cache_item; // Followed by the symbol's name.
+
+typedef struct {
+   bool Loaded;
+   cache_header *Header;
+   string Output_Name;
+   u8 *Segments;
+   u8 *Symbols;
+   u8 *Line_Stream;
+
+   cached_line **Line_Table; // Open addressing on Text_Hash.
+   u32 Line_Table_Capacity;
+} cache_entry;
+
+typedef struct {
+   u64 Key;
+   string Contents; // Allocated with malloc, replaced whenever the file changes.
+} resident_cache_entry;
+
+static pthread_mutex_t Resident_Cache_Mutex = PTHREAD_MUTEX_INITIALIZER;
+static resident_cache_entry *Resident_Cache;
+static int Resident_Cache_Count;
+
+static bool Cache_Enabled(void)
+{
+   // NOTE: Cache entries hold final images, so objects are never cached.
+   bool Result = (Options.Cache_Directory || Options.Watch) && !Options.Object_Output;
+   return(Result);
+}
+
+static u64 Default_Architecture_Hash(void)
+{
+   // NOTE: Files without #architecture depend on --arch as well as their text.
+   u64 Result = (Options.Architecture) ? Options.Architecture->Name_Hash : 0;
+   return(Result);
+}
+
+static u64 Cache_Content_Key(string Source_Code)
+{
+   u64 Result = Hash_String(Source_Code) ^ Default_Architecture_Hash();
+   Result ^= (u64)ASSEMBLER_VERSION * 0x9E3779B97F4A7C15;
+
+   return(Result);
+}
+
+static u64 Hash_Line(assembler_context *Context, source_code_line *Line)
+{
+   // NOTE: The same text encodes differently under another architecture or
+   // instruction set, or once relaxed.
+   u64 Result = Hash_String(Line->Label) ^ ((Context->Architecture) ? Context->Architecture->Name_Hash : 0);
+   Result ^= ((u64)Context->Instruction_Set << 56) ^ ((u64)Line->Relaxation << 48);
+   Result = (Result * 0x9E3779B97F4A7C15) ^ Hash_String(Line->Instruction);
+   Result = (Result * 0x9E3779B97F4A7C15) ^ Hash_String(Line->Directive);
+
+   return(Result);
+}
+
+static bool Is_Replayable(source_code_line *Line)
+{
+   // NOTE: Only lines whose effects are their bytes, their relocations and
+   // their label can be replayed. Other directives always run.
+   bool Result = false;
+   if(Line->Directive.Length == 0)
+   {
+      Result = (Line->Instruction.Length > 0);
+   }
+   else
+   {
+      string Directive = Line->Directive;
+      Result = (Has_Prefix(Directive, S("bytes ")) || Has_Prefix(Directive, S("2bytes ")) ||
+                Has_Prefix(Directive, S("4bytes ")) || Has_Prefix(Directive, S("8bytes ")) ||
+                Has_Prefix(Directive, S("string ")) || Has_Prefix(Directive, S("cstring ")));
+   }
+
+   return(Result);
+}
+
+static u64 Cache_Entry_Key(char *Path)
+{
+   u64 Result = Hash_String(From_C_String(Path)) ^ Default_Architecture_Hash();
+   return(Result);
+}
+
+static char *Cache_Entry_Path(arena *Arena, char *Path)
+{
+   u64 Hash = Cache_Entry_Key(Path);
+
+   index Length = C_String_Length(Options.Cache_Directory) + 32;
+   char *Result = Allocate(Arena, char, Length);
+   snprintf(Result, Length, "%s/%016llx.cache", Options.Cache_Directory, (unsigned long long)Hash);
+
+   return(Result);
+}
+
+static cached_line *Find_Cached_Line(cache_entry *Entry, u64 Text_Hash)
+{
+   cached_line *Result = 0;
+   if(Entry->Line_Table)
+   {
+      u32 Mask = Entry->Line_Table_Capacity - 1;
+      for(u32 Index = (u32)Text_Hash & Mask; Entry->Line_Table[Index]; Index = (Index + 1) & Mask)
+      {
+         if(Entry->Line_Table[Index]->Text_Hash == Text_Hash)
+         {
+            Result = Entry->Line_Table[Index];
+            break;
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static bool Valid_Cached_Items(cached_line *Line, u8 *Items_Data)
+{
+   // NOTE: Replay trusts the items it reads, so a record whose items overrun
+   // it, or whose relocations fall outside the line's bytes, fails the entry.
+   bool Result = true;
+
+   byte_cursor Items = {Items_Data, Items_Data + Line->Item_Size};
+   while(Result && Items.At < Items.End)
+   {
+      cache_item *Item = Read_Bytes(&Items, sizeof(cache_item));
+      Result = (Item && Read_Length_Bytes(&Items, Item->Name_Length));
+      if(Result && Item->Type == CACHE_ITEM_RELOCATION)
+      {
+         Result = (Item->Width > 0 && Item->Width <= 8 && Item->Kind < RELOCATION_KIND_COUNT &&
+                   Item->Endianness <= ENDIAN_BIG && Item->Value <= Line->Length &&
+                   Item->Width <= Line->Length - Item->Value);
+      }
+      else if(Result)
+      {
+         Result = (Item->Type == CACHE_ITEM_DEPENDENCY);
+      }
+   }
+
+   return(Result);
+}
+
+static cache_entry Load_Cache_Entry(assembler_context *Context, char *Path)
+{
+   cache_entry Result = {0};
+   arena *Arena = &Context->Arena;
+
+   // NOTE: Entries are read into the arena either way, so that nothing loaded
+   // here is invalidated when the entry is replaced later in this run.
+   string Contents = {0};
+   Allocate_Size_Aligned(Arena, 0, 8);
+   if(Options.Cache_Directory)
+   {
+      FILE *File = fopen(Cache_Entry_Path(Arena, Path), "rb");
+      if(File)
+      {
+         Contents = Read_Entire_Stream(Arena, File, Path);
+         fclose(File);
+      }
+   }
+   else
+   {
+      u64 Key = Cache_Entry_Key(Path);
+      pthread_mutex_lock(&Resident_Cache_Mutex);
+      for(int Entry_Index = 0; Entry_Index < Resident_Cache_Count; ++Entry_Index)
+      {
+         if(Resident_Cache[Entry_Index].Key == Key)
+         {
+            string Resident = Resident_Cache[Entry_Index].Contents;
+            Contents.Data = Allocate(Arena, u8, Resident.Length);
+            Contents.Length = Resident.Length;
+            memcpy(Contents.Data, Resident.Data, Resident.Length);
+            break;
+         }
+      }
+      pthread_mutex_unlock(&Resident_Cache_Mutex);
+   }
+
+   byte_cursor Cursor = {Contents.Data, Contents.Data + Contents.Length};
+   cache_header *Header = Read_Bytes(&Cursor, sizeof(cache_header));
+   if(Header && Header->Magic == CACHE_MAGIC)
+   {
+      Result.Header = Header;
+      Result.Output_Name.Data = Read_Length_Bytes(&Cursor, Header->Output_Name_Length);
+      Result.Output_Name.Length = Header->Output_Name_Length;
+
+      bool Ok = (Result.Output_Name.Data || Header->Output_Name_Length == 0);
+
+      Result.Segments = Cursor.At;
+      for(u64 Segment_Index = 0; Ok && Segment_Index < Header->Segment_Count; ++Segment_Index)
+      {
+         cached_segment *Segment = Read_Bytes(&Cursor, sizeof(cached_segment));
+         Ok = (Segment && Read_Length_Bytes(&Cursor, Segment->Length));
+      }
+
+      Result.Symbols = Cursor.At;
+      for(u64 Symbol_Index = 0; Ok && Symbol_Index < Header->Symbol_Count; ++Symbol_Index)
+      {
+         cached_symbol *Symbol = Read_Bytes(&Cursor, sizeof(cached_symbol));
+         Ok = (Symbol && Read_Length_Bytes(&Cursor, Symbol->Name_Length));
+      }
+
+      Result.Line_Stream = Cursor.At;
+      Ok = Ok && (Header->Line_Stream_Size == (u64)(Cursor.End - Cursor.At));
+
+      // NOTE: Index line records by text hash. Duplicates keep the first.
+      u32 Line_Count = 0;
+      byte_cursor Lines = {Result.Line_Stream, Cursor.End};
+      while(Ok && Lines.At < Lines.End)
+      {
+         cached_line *Line = Read_Bytes(&Lines, sizeof(cached_line));
+         u8 *Items = (Line) ? Read_Length_Bytes(&Lines, Line->Item_Size) : 0;
+         Ok = (Items && Read_Length_Bytes(&Lines, Line->Length) && Valid_Cached_Items(Line, Items));
+         Line_Count++;
+      }
+
+      if(Ok)
+      {
+         Result.Line_Table_Capacity = 16;
+         while(Result.Line_Table_Capacity < Line_Count * 2)
+         {
+            Result.Line_Table_Capacity *= 2;
+         }
+         Result.Line_Table = Allocate(Arena, cached_line *, Result.Line_Table_Capacity);
+
+         u32 Mask = Result.Line_Table_Capacity - 1;
+         Lines.At = Result.Line_Stream;
+         while(Lines.At < Lines.End)
+         {
+            cached_line *Line = Read_Bytes(&Lines, sizeof(cached_line));
+            Read_Bytes(&Lines, Line->Item_Size);
+            Read_Bytes(&Lines, Line->Length);
+
+            u32 Index = (u32)Line->Text_Hash & Mask;
+            while(Result.Line_Table[Index] && Result.Line_Table[Index]->Text_Hash != Line->Text_Hash)
+            {
+               Index = (Index + 1) & Mask;
+            }
+            if(!Result.Line_Table[Index])
+            {
+               Result.Line_Table[Index] = Line;
+            }
+         }
+      }
+
+      Result.Loaded = Ok;
+   }
+
+   return(Result);
+}
+
+static void Restore_Cached_Output(assembler_context *Context, cache_entry *Entry)
+{
+   // NOTE: The content key matched, so the cached segments are the output.
+   Context->Output_File_Name = Entry->Output_Name;
+
+   byte_cursor Cursor = {Entry->Segments, Entry->Line_Stream};
+   for(u64 Segment_Index = 0; Segment_Index < Entry->Header->Segment_Count; ++Segment_Index)
+   {
+      cached_segment *Segment = Read_Bytes(&Cursor, sizeof(cached_segment));
+      u8 *Bytes = Read_Bytes(&Cursor, Segment->Length);
+
+      u8 *Destination = Reserve_Output(Context, Segment->Address, Segment->Length);
+      memcpy(Destination, Bytes, Segment->Length);
+   }
+
+   for(u64 Symbol_Index = 0; Symbol_Index < Entry->Header->Symbol_Count; ++Symbol_Index)
+   {
+      cached_symbol *Symbol = Read_Bytes(&Cursor, sizeof(cached_symbol));
+      string Name = {Read_Bytes(&Cursor, Symbol->Name_Length), Symbol->Name_Length};
+
+      Define_Symbol(&Context->Symbols, Intern_Symbol(&Context->Symbols, Name), Symbol->Value);
+   }
+}
+
+static void Begin_Cached_Line(assembler_context *Context, source_code_line *Line)
+{
+   if(Context->Cache_Recording && Is_Replayable(Line))
+   {
+      cached_line Header = {0};
+      Header.Text_Hash = Hash_Line(Context, Line);
+      Push_Bytes(&Context->Cache_Stream, &Header, sizeof(Header));
+
+      Context->Cache_Line = (cached_line *)(Context->Cache_Stream.Base + Context->Cache_Stream.Used) - 1;
+      Context->Cache_Line_Address = Context->Current_Address;
+      Context->Cache_Line_Errors = Context->Error_Count;
+      Context->Cache_Line_Skipped = false;
+   }
+}
+
+static void Skip_Cached_Line(assembler_context *Context)
+{
+   // NOTE: For lines with effects that can't be replayed, e.g. requesting a
+   // literal pool entry. Such lines are encoded every time.
+   Context->Cache_Line_Skipped = true;
+}
+
+static void Record_Cache_Item(assembler_context *Context, cache_item *Item, string Name)
+{
+   Item->Name_Length = Name.Length;
+   Push_Bytes(&Context->Cache_Stream, Item, sizeof(*Item));
+   Push_Bytes(&Context->Cache_Stream, Name.Data, Name.Length);
+}
+
+static void Record_Cache_Dependency(assembler_context *Context, symbol_id Symbol, lookup_result Lookup)
+{
+   cache_item Item = {0};
+   Item.Type = CACHE_ITEM_DEPENDENCY;
+   Item.Found = Lookup.Found;
+   Item.Value = Lookup.Value;
+   Record_Cache_Item(Context, &Item, Context->Symbols.Symbols[Symbol].Name);
+}
+
+static void Record_Cache_Relocation(assembler_context *Context, relocation *Relocation)
+{
+   cache_item Item = {0};
+   Item.Type = CACHE_ITEM_RELOCATION;
+   Item.Width = Relocation->Width;
+   Item.Kind = Relocation->Kind;
+   Item.Endianness = Relocation->Endianness;
+   Item.Relaxable = Relocation->Relaxable;
+   Item.Value = Relocation->Address - Context->Cache_Line_Address;
+   Record_Cache_Item(Context, &Item, Context->Symbols.Symbols[Relocation->Symbol].Name);
+}
+
+static void End_Cached_Line(assembler_context *Context, source_code_line *Line)
+{
+   cached_line *Header = Context->Cache_Line;
+   if(Header)
+   {
+      arena *Stream = &Context->Cache_Stream;
+      if(Context->Error_Count == Context->Cache_Line_Errors && !Context->Cache_Line_Skipped)
+      {
+         Header->Item_Size = (u32)((Stream->Base + Stream->Used) - (u8 *)(Header + 1));
+         Header->Length = (u32)Line->Length;
+         if(Line->Length)
+         {
+            Push_Bytes(Stream, Find_Output(&Context->Output, Context->Current_Section, Line->Address, Line->Length), Line->Length);
+         }
+      }
+      else
+      {
+         Stream->Used = (u8 *)Header - Stream->Base;
+      }
+
+      Context->Cache_Line = 0;
+   }
+}
+
+static bool Replay_Cached_Line(assembler_context *Context, cache_entry *Entry, source_code_line *Line)
+{
+   bool Result = false;
+
+   cached_line *Cached = 0;
+   if(Entry->Loaded && Is_Replayable(Line))
+   {
+      Cached = Find_Cached_Line(Entry, Hash_Line(Context, Line));
+   }
+
+   if(Cached)
+   {
+      Line->Address = Context->Current_Address;
+      Context->Current_Line_Number = Line->Line_Number;
+
+      // NOTE: A line may depend on its own label, so define it first.
+      if(Line->Label_Symbol)
+      {
+         Define_Label(Context, Line->Label_Symbol, Line->Address);
+      }
+
+      byte_cursor Items = {(u8 *)(Cached + 1), (u8 *)(Cached + 1) + Cached->Item_Size};
+      Result = true;
+      while(Result && Items.At < Items.End)
+      {
+         cache_item *Item = Read_Bytes(&Items, sizeof(cache_item));
+         string Name = {Read_Bytes(&Items, Item->Name_Length), Item->Name_Length};
+
+         if(Item->Type == CACHE_ITEM_DEPENDENCY)
+         {
+            lookup_result Lookup = Lookup_Symbol(&Context->Symbols, Intern_Symbol(&Context->Symbols, Name));
+            Result = (Lookup.Found == Item->Found) && (!Lookup.Found || Lookup.Value == Item->Value);
+         }
+      }
+   }
+
+   if(Result)
+   {
+      u8 *Bytes = (u8 *)(Cached + 1) + Cached->Item_Size;
+      Line->Length = Cached->Length;
+      if(Line->Length)
+      {
+         memcpy(Reserve_Output(Context, Line->Address, Line->Length), Bytes, Line->Length);
+      }
+
+      byte_cursor Items = {(u8 *)(Cached + 1), Bytes};
+      while(Items.At < Items.End)
+      {
+         cache_item *Item = Read_Bytes(&Items, sizeof(cache_item));
+         string Name = {Read_Bytes(&Items, Item->Name_Length), Item->Name_Length};
+
+         if(Item->Type == CACHE_ITEM_RELOCATION)
+         {
+            Add_Relocation(Context, Intern_Symbol(&Context->Symbols, Name), Line->Address + Item->Value,
+                           Item->Width, Item->Kind, Item->Endianness, Item->Relaxable);
+         }
+      }
+
+      // NOTE: Carry the record over to the new entry unchanged.
+      if(Context->Cache_Recording)
+      {
+         Push_Bytes(&Context->Cache_Stream, Cached, sizeof(*Cached) + Cached->Item_Size + Align_8(Cached->Length));
+      }
+
+      Context->Current_Address += Line->Length;
+   }
+
+   return(Result);
+}
+
+static void Write_Cache_File(arena *Arena, char *Path, string Prefix, string Line_Stream)
+{
+   // NOTE: Write to a temporary file and rename it into place, so concurrent
+   // runs never see a partial entry.
+   static int Temporary_Counter;
+   char *Entry_Path = Cache_Entry_Path(Arena, Path);
+   index Temporary_Length = C_String_Length(Entry_Path) + 64;
+   char *Temporary_Path = Allocate(Arena, char, Temporary_Length);
+   snprintf(Temporary_Path, Temporary_Length, "%s.%d.%d.tmp", Entry_Path, (int)getpid(),
+            __atomic_fetch_add(&Temporary_Counter, 1, __ATOMIC_RELAXED));
+
+   FILE *File = fopen(Temporary_Path, "wb");
+   if(File)
+   {
+      bool Ok = (fwrite(Prefix.Data, 1, Prefix.Length, File) == (size_t)Prefix.Length);
+      Ok = Ok && (fwrite(Line_Stream.Data, 1, Line_Stream.Length, File) == (size_t)Line_Stream.Length);
+      Ok = (fclose(File) == 0) && Ok;
+
+      if(!Ok || rename(Temporary_Path, Entry_Path) != 0)
+      {
+         remove(Temporary_Path);
+         Report_Error(0, "Failed to write cache entry \"%s\".", Entry_Path);
+      }
+   }
+   else
+   {
+      Report_Error(0, "Failed to create cache entry \"%s\".", Temporary_Path);
+   }
+}
+
+static void Store_Resident_Entry(char *Path, string Prefix, string Line_Stream)
+{
+   u64 Key = Cache_Entry_Key(Path);
+
+   string Contents = {malloc(Prefix.Length + Line_Stream.Length), Prefix.Length + Line_Stream.Length};
+   memcpy(Contents.Data, Prefix.Data, Prefix.Length);
+   memcpy(Contents.Data + Prefix.Length, Line_Stream.Data, Line_Stream.Length);
+
+   pthread_mutex_lock(&Resident_Cache_Mutex);
+   int Entry_Index = 0;
+   while(Entry_Index < Resident_Cache_Count && Resident_Cache[Entry_Index].Key != Key)
+   {
+      Entry_Index++;
+   }
+
+   if(Entry_Index == Resident_Cache_Count)
+   {
+      Resident_Cache = realloc(Resident_Cache, (Resident_Cache_Count + 1) * sizeof(*Resident_Cache));
+      Resident_Cache[Resident_Cache_Count++] = (resident_cache_entry){Key, {0}};
+   }
+   free(Resident_Cache[Entry_Index].Contents.Data);
+   Resident_Cache[Entry_Index].Contents = Contents;
+   pthread_mutex_unlock(&Resident_Cache_Mutex);
+}
+
+static void Store_Cache_Entry(assembler_context *Context, char *Path, u64 Content_Key)
+{
+   arena *Arena = &Context->Arena;
+   temporary_memory Scratch = Begin_Temporary_Memory(Arena);
+
+   // NOTE: Segments are kept newest first, but are written oldest first so
+   // that later writes to the same address still win when restored.
+   index Segment_Count = 0;
+   for(output_segment *Segment = Context->Output.Segments; Segment; Segment = Segment->Next)
+   {
+      Segment_Count++;
+   }
+
+   output_segment **Segments = Allocate(Arena, output_segment *, Segment_Count);
+   index Segment_Index = Segment_Count;
+   for(output_segment *Segment = Context->Output.Segments; Segment; Segment = Segment->Next)
+   {
+      Segments[--Segment_Index] = Segment;
+   }
+
+   // NOTE: Build everything before the line stream contiguously in the
+   // scratch arena.
+   arena *Stream = Arena;
+   cache_header *Header = Allocate(Stream, cache_header, 1);
+   u8 *Begin = (u8 *)Header;
+
+   Header->Magic = CACHE_MAGIC;
+   Header->Content_Key = Content_Key;
+   Header->Output_Name_Length = Context->Output_File_Name.Length;
+   Header->Line_Stream_Size = Context->Cache_Stream.Used;
+   Push_Bytes(Stream, Context->Output_File_Name.Data, Context->Output_File_Name.Length);
+
+   for(Segment_Index = 0; Segment_Index < Segment_Count; ++Segment_Index)
+   {
+      cached_segment Cached = {Segments[Segment_Index]->Address, Segments[Segment_Index]->Length};
+      Push_Bytes(Stream, &Cached, sizeof(Cached));
+      Push_Bytes(Stream, Segments[Segment_Index]->Data, Cached.Length);
+   }
+   Header->Segment_Count = Segment_Count;
+
+   symbol_table *Symbols = &Context->Symbols;
+   for(symbol_id Id = 1; Id <= Symbols->Symbol_Count; ++Id)
+   {
+      symbol *Symbol = Symbols->Symbols + Id;
+      if(Symbol->Defined)
+      {
+         cached_symbol Cached = {Symbol->Value, Symbol->Name.Length};
+         Push_Bytes(Stream, &Cached, sizeof(Cached));
+         Push_Bytes(Stream, Symbol->Name.Data, Symbol->Name.Length);
+         Header->Symbol_Count++;
+      }
+   }
+
+   string Prefix = {Begin, (Stream->Base + Stream->Used) - Begin};
+   string Line_Stream = {Context->Cache_Stream.Base, Context->Cache_Stream.Used};
+   if(Options.Cache_Directory)
+   {
+      Write_Cache_File(Arena, Path, Prefix, Line_Stream);
+   }
+   else
+   {
+      Store_Resident_Entry(Path, Prefix, Line_Stream);
+   }
+
+   End_Temporary_Memory(Scratch);
+}
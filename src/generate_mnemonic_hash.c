@@ -0,0 +1,151 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Build-time tool that writes a perfect hash table for a backend's
+// MNEMONICS_LIST to stdout. Compile with MNEMONICS_HEADER naming the header
+// that defines the list, and pass the architecture name used in the generated
+// identifiers as the only argument, e.g.:
+//
+//    cc -DMNEMONICS_HEADER='"mnemonics_6502.h"' src/generate_mnemonic_hash.c
+//    ./a.out 6502 > mnemonic_hash_6502.h
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct assembler_context;
+static void Report_Error(struct assembler_context *Context, char *Message, ...)
+{
+   (void)Context;
+
+   va_list Arguments;
+   va_start(Arguments, Message);
+   fprintf(stderr, "ERROR: ");
+   vfprintf(stderr, Message, Arguments);
+   fprintf(stderr, "\n");
+   va_end(Arguments);
+}
+
+#include "memory.c"
+#include "mnemonic_hash.h"
+#include MNEMONICS_HEADER
+
+// NOTE: Every backend is compiled into one binary, so a header whose names
+// would collide with another backend's MNEMONIC_* enum names its own prefix.
+#ifndef MNEMONIC_PREFIX
+#   define MNEMONIC_PREFIX MNEMONIC_
+#endif
+#define STRINGIFY_(Token) #Token
+#define STRINGIFY(Token) STRINGIFY_(Token)
+
+static char *Mnemonics[] =
+{
+#  define X(M) #M,
+   MNEMONICS_LIST
+#  undef X
+};
+
+static u64 Random_State = 0x9E3779B97F4A7C15;
+
+static u64 Random_U64(void)
+{
+   // NOTE: xorshift64*, seeded with a constant so builds are reproducible.
+   Random_State ^= Random_State >> 12;
+   Random_State ^= Random_State << 25;
+   Random_State ^= Random_State >> 27;
+   return(Random_State * 0x2545F4914F6CDD1D);
+}
+
+int main(int Argument_Count, char **Arguments)
+{
+   if(Argument_Count != 2)
+   {
+      Report_Error(0, "Usage: %s <architecture>", Arguments[0]);
+      return(1);
+   }
+   char *Architecture = Arguments[1];
+
+   index Mnemonic_Count = Array_Count(Mnemonics);
+   u64 Keys[Array_Count(Mnemonics)];
+   for(index Mnemonic_Index = 0; Mnemonic_Index < Mnemonic_Count; ++Mnemonic_Index)
+   {
+      Keys[Mnemonic_Index] = Pack_Mnemonic(From_C_String(Mnemonics[Mnemonic_Index]));
+      if(!Keys[Mnemonic_Index])
+      {
+         Report_Error(0, "Mnemonic \"%s\" is longer than 8 characters.", Mnemonics[Mnemonic_Index]);
+         return(1);
+      }
+   }
+
+   int Bits = 1;
+   while(((index)1 << Bits) < Mnemonic_Count)
+   {
+      Bits++;
+   }
+
+   // NOTE: Try the smallest tables first, giving up on each size after a fixed
+   // number of random odd multipliers.
+   static u8 Occupied[1 << 16];
+   u64 Multiplier = 0;
+   bool Found = false;
+   for(; Bits <= 16 && !Found; ++Bits)
+   {
+      index Slot_Count = (index)1 << Bits;
+      for(int Attempt = 0; Attempt < (1 << 22) && !Found; ++Attempt)
+      {
+         Multiplier = Random_U64() | 1;
+         memset(Occupied, 0, Slot_Count);
+
+         Found = true;
+         for(index Key_Index = 0; Key_Index < Mnemonic_Count; ++Key_Index)
+         {
+            u64 Slot = Mnemonic_Hash_Slot(Keys[Key_Index], Multiplier, 64 - Bits);
+            if(Occupied[Slot])
+            {
+               Found = false;
+               break;
+            }
+            Occupied[Slot] = 1;
+         }
+      }
+   }
+   Bits--;
+
+   if(!Found)
+   {
+      Report_Error(0, "Failed to find a perfect hash for %td mnemonics.", Mnemonic_Count);
+      return(1);
+   }
+
+   index Slot_Count = (index)1 << Bits;
+   int *Slots = calloc(Slot_Count, sizeof(*Slots));
+   for(index Slot_Index = 0; Slot_Index < Slot_Count; ++Slot_Index)
+   {
+      Slots[Slot_Index] = -1;
+   }
+   for(index Key_Index = 0; Key_Index < Mnemonic_Count; ++Key_Index)
+   {
+      Slots[Mnemonic_Hash_Slot(Keys[Key_Index], Multiplier, 64 - Bits)] = (int)Key_Index;
+   }
+
+   printf("/* NOTE: Generated by generate_mnemonic_hash.c from %s, do not edit. */\n\n", MNEMONICS_HEADER);
+   printf("static mnemonic_hash_entry Mnemonic_Hash_Entries_%s[%td] =\n{\n", Architecture, Slot_Count);
+   for(index Slot_Index = 0; Slot_Index < Slot_Count; ++Slot_Index)
+   {
+      int Key_Index = Slots[Slot_Index];
+      if(Key_Index >= 0)
+      {
+         printf("   [%td] = {0x%016llxull, %s%s},\n", Slot_Index,
+                (unsigned long long)Keys[Key_Index], STRINGIFY(MNEMONIC_PREFIX), Mnemonics[Key_Index]);
+      }
+   }
+   printf("};\n\n");
+
+   printf("static mnemonic_hash Mnemonic_Hash_%s =\n{\n", Architecture);
+   printf("   0x%016llxull, %d, Mnemonic_Hash_Entries_%s,\n", (unsigned long long)Multiplier, 64 - Bits, Architecture);
+   printf("};\n");
+
+   free(Slots);
+   return(0);
+}
@@ -1,46 +1,339 @@
 /* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(__SSE2__)
+#   include <emmintrin.h>
+#endif
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+
 struct assembler_context;
 static void Report_Error(struct assembler_context *Context, char *Message, ...);
+static void Print_Message(struct assembler_context *Context, FILE *Stream, char *Format, ...);
 
 #include "memory.c"
 
 #include "architecture.h"
-#if ARCH_6502
-#   include "architecture_6502.c"
-#elif ARCH_ARMV4
-#   include "architecture_armv4.c"
-#elif ARCH_MIPS
-#   include "architecture_mips.c"
-#elif ARCH_ARMV8
-#   include "architecture_armv8.c"
-#else
-#   error Unhandled architecture.
-#endif
+#include "architecture_6502.c"
+#include "architecture_mips.c"
+#include "architecture_armv4.c"
+#include "architecture_armv8.c"
+
+static architecture *Architectures[] =
+{
+   &Architecture_6502,
+   &Architecture_MIPS,
+   &Architecture_ARMv4,
+   &Architecture_ARMv8,
+};
+
+#define ARCHITECTURE_ARENA_SIZE ((index)1024 * 1024 * 1024)
+static pthread_mutex_t Architecture_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// NOTE: The context of the file being assembled on the current thread. Errors
+// reported without a context (e.g. from memory.c) are still routed to that
+// file's log, so that parallel runs keep their diagnostics in order.
+static _Thread_local assembler_context *Thread_Context;
+
+static void Append_Message(message_buffer *Buffer, char *Format, va_list Arguments)
+{
+   va_list Measure_Arguments;
+   va_copy(Measure_Arguments, Arguments);
+   int Length = vsnprintf(0, 0, Format, Measure_Arguments);
+   va_end(Measure_Arguments);
+
+   if(Length > 0)
+   {
+      index Required = Buffer->Length + Length + 1;
+      if(Required > Buffer->Capacity)
+      {
+         index Capacity = (Buffer->Capacity) ? Buffer->Capacity : 256;
+         while(Capacity < Required)
+         {
+            Capacity *= 2;
+         }
+
+         Buffer->Data = realloc(Buffer->Data, Capacity);
+         Buffer->Capacity = Capacity;
+      }
+
+      vsnprintf(Buffer->Data + Buffer->Length, Buffer->Capacity - Buffer->Length, Format, Arguments);
+      Buffer->Length += Length;
+   }
+}
+
+static void Print_Message_List(assembler_context *Context, FILE *Stream, char *Format, va_list Arguments)
+{
+   if(!Context)
+   {
+      Context = Thread_Context;
+   }
+
+   if(Context && Context->Log)
+   {
+      message_buffer *Buffer = (Stream == stderr)
+         ? &Context->Log->Standard_Error
+         : &Context->Log->Standard_Output;
+      Append_Message(Buffer, Format, Arguments);
+   }
+   else
+   {
+      vfprintf(Stream, Format, Arguments);
+   }
+}
+
+static void Print_Message(assembler_context *Context, FILE *Stream, char *Format, ...)
+{
+   va_list Arguments;
+   va_start(Arguments, Format);
+   Print_Message_List(Context, Stream, Format, Arguments);
+   va_end(Arguments);
+}
+
+// NOTE: Command line options, set before any assembly begins.
+typedef struct {
+   architecture *Architecture; // Used by files without #architecture.
+   bool Report_Memory;
+   bool Report_Stats; // JSON statistics, see stats.c.
+
+   // NOTE: By default the image is flat from address zero with gaps set to
+   // Fill_Byte, as it always was. With --fill none only populated address
+   // ranges are written, starting at the lowest one, and gaps between them are
+   // left as holes in the file. Either way a far #location makes a file that
+   // large, only the sparse one doesn't take the disk space.
+   bool Fill;
+   u8 Fill_Byte;
+
+   char *Cache_Directory; // Null unless --cache was given.
+   char *Trace_Path; // Null unless --trace was given, see trace.c.
+   bool Watch;       // Stay resident and reassemble on change, see watch.c.
+
+   // NOTE: With -c each input is assembled to a relocatable object instead,
+   // and with --link the inputs are objects combined into one output.
+   bool Object_Output;
+   char *Link_Output;
+} assembler_options;
+
+static assembler_options Options = {.Fill = true};
 
 static void Report_Error(assembler_context *Context, char *Message, ...)
 {
+   assembler_context *Failed_Context = (Context) ? Context : Thread_Context;
+   if(Failed_Context)
+   {
+      Failed_Context->Error_Count++;
+   }
+
    if(Context)
    {
-      fprintf(stderr, "%.*s:%d: error: ", SF(Context->Input_File_Path), Context->Current_Line_Number);
+      Print_Message(Context, stderr, "%.*s:%d: error: ", SF(Context->Input_File_Path), Context->Current_Line_Number);
    }
    else
    {
-      fprintf(stderr, "ERROR: ");
+      Print_Message(Context, stderr, "ERROR: ");
    }
 
    va_list Arguments;
    va_start(Arguments, Message);
-   vfprintf(stderr, Message, Arguments);
+   Print_Message_List(Context, stderr, Message, Arguments);
    va_end(Arguments);
 
-   fprintf(stderr, "\n");
+   Print_Message(Context, stderr, "\n");
+}
+
+static architecture *Find_Architecture(string Name)
+{
+   architecture *Result = 0;
+   for(int Index = 0; !Result && Index < Array_Count(Architectures); ++Index)
+   {
+      architecture *Architecture = Architectures[Index];
+      if(Equals(Name, From_C_String(Architecture->Name)))
+      {
+         Result = Architecture;
+      }
+      for(int Alias_Index = 0; !Result && Alias_Index < Array_Count(Architecture->Aliases); ++Alias_Index)
+      {
+         char *Alias = Architecture->Aliases[Alias_Index];
+         if(Alias && Equals(Name, From_C_String(Alias)))
+         {
+            Result = Architecture;
+         }
+      }
+   }
+
+   return(Result);
+}
+
+static void Prepare_Architecture(architecture *Architecture)
+{
+   // NOTE: Backend tables are built on first use and only read afterwards, so
+   // the lock is only taken until they exist.
+   if(!__atomic_load_n(&Architecture->Initialized, __ATOMIC_ACQUIRE))
+   {
+      pthread_mutex_lock(&Architecture_Mutex);
+      if(!Architecture->Initialized)
+      {
+         assembler_context Setup_Context = {0};
+         Setup_Context.Arena = Reserve_Arena(ARCHITECTURE_ARENA_SIZE);
+         Architecture->Initialize(&Setup_Context);
+         Architecture->Name_Hash = Hash_String(From_C_String(Architecture->Name));
+         __atomic_store_n(&Architecture->Initialized, true, __ATOMIC_RELEASE);
+      }
+      pthread_mutex_unlock(&Architecture_Mutex);
+   }
+}
+
+static void Select_Architecture(assembler_context *Context, string Name)
+{
+   architecture *Architecture = Find_Architecture(Name);
+   if(Architecture)
+   {
+      Prepare_Architecture(Architecture);
+      Context->Architecture = Architecture;
+      Context->Instruction_Set = 0;
+   }
+   else
+   {
+      Report_Error(Context, "Unsupported architecture \"%.*s\".", SF(Name));
+   }
+}
+
+static endianness Data_Endianness(assembler_context *Context)
+{
+   endianness Result = (Context->Architecture) ? Context->Architecture->Endianness : ENDIAN_LITTLE;
+   return(Result);
+}
+
+static void Flush_Message_Log(message_log *Log)
+{
+   fwrite(Log->Standard_Output.Data, 1, Log->Standard_Output.Length, stdout);
+   fwrite(Log->Standard_Error.Data, 1, Log->Standard_Error.Length, stderr);
+
+   free(Log->Standard_Output.Data);
+   free(Log->Standard_Error.Data);
+   memset(Log, 0, sizeof(*Log));
+}
+
+#include "cache.c"
+#include "stats.c"
+#include "trace.c"
+
+static void Place_Literal_Pool(assembler_context *Context, bool Branch_Around)
+{
+   // NOTE: Places every pending literal at the current address, widest first
+   // so that only the first one needs padding.
+   literal_pool *Pool = &Context->Literal_Pool;
+   if(Pool->Count > Pool->Placed_Count)
+   {
+      symbol_id After_Pool = 0;
+      if(Branch_Around)
+      {
+         // NOTE: Only the ARM backends request literals, and "b" is an
+         // unconditional branch in each of their instruction sets.
+         int Length = snprintf(0, 0, "b (after pool %d)", Pool->Pool_Count);
+         char *Branch = Allocate(&Context->Symbols.Arena, char, Length + 1);
+         snprintf(Branch, Length + 1, "b (after pool %d)", Pool->Pool_Count);
+
+         string Instruction = {(u8 *)Branch, Length};
+         After_Pool = Intern_Symbol(&Context->Symbols, Cut_Whitespace(Instruction).After);
+
+         machine_code Machine_Code = Context->Architecture->Encode_Instruction(Context, Instruction);
+         if(Machine_Code.Length)
+         {
+            memcpy(Reserve_Output(Context, Context->Current_Address, Machine_Code.Length), Machine_Code.Bytes, Machine_Code.Length);
+            Context->Current_Address += Machine_Code.Length;
+         }
+      }
+
+      endianness Endianness = Data_Endianness(Context);
+      for(int Width = 8; Width > 0; Width /= 2)
+      {
+         for(u32 Literal_Index = Pool->Placed_Count; Literal_Index < Pool->Count; ++Literal_Index)
+         {
+            pool_literal *Literal = Pool->Literals + Literal_Index;
+            if(Literal->Width == Width)
+            {
+               index Padding = -Context->Current_Address & (Width - 1);
+               if(Padding)
+               {
+                  memset(Reserve_Output(Context, Context->Current_Address, Padding), 0, Padding);
+                  Context->Current_Address += Padding;
+               }
+               Define_Label(Context, Literal->Label, Context->Current_Address);
+
+               u64 Value = Literal->Value;
+               if(Literal->Is_Symbol)
+               {
+                  lookup_result Lookup = Resolve_Symbol(Context, (symbol_id)Literal->Value);
+                  Value = Lookup.Value;
+                  if(!Lookup.Found)
+                  {
+                     Request_Relocation(Context, (symbol_id)Literal->Value, Context->Current_Address,
+                                        Width, RELOCATION_ABSOLUTE, Endianness);
+                  }
+               }
+
+               u8 *Destination = Reserve_Output(Context, Context->Current_Address, Width);
+               for(int Byte_Index = 0; Byte_Index < Width; ++Byte_Index)
+               {
+                  int Shift = (Endianness == ENDIAN_BIG) ? ((Width - 1 - Byte_Index) * 8) : (Byte_Index * 8);
+                  Destination[Byte_Index] = (u8)(Value >> Shift);
+               }
+               Context->Current_Address += Width;
+            }
+         }
+      }
+
+      if(After_Pool)
+      {
+         Define_Label(Context, After_Pool, Context->Current_Address);
+      }
+
+      // NOTE: Only this pool's literals are kept for sharing, the previous
+      // pool is out of reach of anything that follows.
+      u32 Pending_Count = Pool->Count - Pool->Placed_Count;
+      memmove(Pool->Literals, Pool->Literals + Pool->Placed_Count, Pending_Count * sizeof(pool_literal));
+      Pool->Placed_Count = Pending_Count;
+      Pool->Count = Pending_Count;
+
+      memset(Pool->Slots, 0, LITERAL_SLOT_COUNT * sizeof(*Pool->Slots));
+      for(u32 Literal_Index = 0; Literal_Index < Pool->Count; ++Literal_Index)
+      {
+         Insert_Literal_Slot(Pool, Literal_Index);
+      }
+
+      Pool->Pending_Size = 0;
+      Pool->Pool_Count++;
+   }
+}
+
+// NOTE: Room left before a pool's deadline for the next line, the branch
+// around the pool and padding. A data directive larger than this between a
+// load and its pool can still push the pool out of reach, which is reported
+// by the load's relocation.
+#define LITERAL_POOL_MARGIN 32
+
+static void Place_Literal_Pool_If_Due(assembler_context *Context)
+{
+   literal_pool *Pool = &Context->Literal_Pool;
+   if(Pool->Count > Pool->Placed_Count &&
+      Context->Current_Address + Pool->Pending_Size + LITERAL_POOL_MARGIN > Pool->Deadline)
+   {
+      Place_Literal_Pool(Context, true);
+   }
 }
 
 static void Encode_Literal_Bytes(assembler_context *Context, source_code_line *Line, int Bytes_Per_Literal)
@@ -61,16 +354,12 @@ static void Encode_Literal_Bytes(assembler_context *Context, source_code_line *L
       while(Literals.After.Length)
       {
          Literals = Cut_Whitespace(Literals.After);
-         Literal_Count++;
+         Literal_Count += (Literals.Before.Length > 0);
       }
 
-      u8 *Destination = Line->Machine_Code.Bytes;
-      Line->Machine_Code.Length = Literal_Count * Bytes_Per_Literal;
-      if(Line->Machine_Code.Length > Array_Count(Line->Machine_Code.Bytes))
-      {
-         Destination = Allocate(&Context->Arena, u8, Line->Machine_Code.Length);
-         Line->Machine_Code.Bytes_Pointer = Destination;
-      }
+      Line->Length = Literal_Count * Bytes_Per_Literal;
+      u8 *Destination = Reserve_Output(Context, Line->Address, Line->Length);
+      endianness Endianness = Data_Endianness(Context);
 
       // Populate Literals.
       index Byte_Count = 0;
@@ -101,7 +390,8 @@ static void Encode_Literal_Bytes(assembler_context *Context, source_code_line *L
             }
             else
             {
-               lookup_result Constant = Lookup(Context->Constants, Literal);
+               symbol_id Symbol = Intern_Symbol(&Context->Symbols, Literal);
+               lookup_result Constant = Resolve_Symbol(Context, Symbol);
                Ok = Constant.Found;
 
                if(Ok)
@@ -110,17 +400,15 @@ static void Encode_Literal_Bytes(assembler_context *Context, source_code_line *L
                }
                else
                {
-                  Request_Patch(&Context->Arena, &Line->Machine_Code, Literal, Line->Machine_Code.Address, Line->Machine_Code.Length);
+                  Request_Relocation(Context, Symbol, Line->Address + Byte_Count,
+                                     Bytes_Per_Literal, RELOCATION_ABSOLUTE, Endianness);
                }
             }
 
-            if(Ok)
+            for(int Byte_Index = 0; Byte_Index < Bytes_Per_Literal; ++Byte_Index)
             {
-               // TODO: Handle endianess.
-               for(int Byte_Index = 0; Byte_Index < Bytes_Per_Literal; ++Byte_Index)
-               {
-                  Destination[Byte_Count++] = (u8)(Value >> (Byte_Index * 8));
-               }
+               int Shift = (Endianness == ENDIAN_BIG) ? ((Bytes_Per_Literal - 1 - Byte_Index) * 8) : (Byte_Index * 8);
+               Destination[Byte_Count++] = (u8)(Value >> Shift);
             }
          }
       }
@@ -134,8 +422,6 @@ typedef enum {
 
 static void Encode_Literal_String(assembler_context *Context, source_code_line *Line, string_kind Kind)
 {
-   machine_code *Result = &Line->Machine_Code;
-
    if(Line->Instruction.Length)
    {
       Report_Error(Context, "Don't use an embedding directive on the same line as an instruction.");
@@ -146,22 +432,16 @@ static void Encode_Literal_String(assembler_context *Context, source_code_line *
          Has_Suffix_Then_Remove(&Line->Directive, S("\"")))
       {
          bool Null_Terminate = (Kind == STRINGKIND_CSTRING);
-         Result->Length = Line->Directive.Length + Null_Terminate;
+         Line->Length = Line->Directive.Length + Null_Terminate;
 
-         u8 *Destination = Result->Bytes;
-         if(Result->Length > Array_Count(Result->Bytes))
+         if(Line->Length)
          {
-            Destination = Allocate(&Context->Arena, u8, Result->Length);
-            Result->Bytes_Pointer = Destination;
-         }
-
-         for(int Byte_Index = 0; Byte_Index < (Result->Length - Null_Terminate); ++Byte_Index)
-         {
-            Destination[Byte_Index] = Line->Directive.Data[Byte_Index];
-         }
-         if(Null_Terminate)
-         {
-            Destination[Result->Length] = 0;
+            u8 *Destination = Reserve_Output(Context, Line->Address, Line->Length);
+            memcpy(Destination, Line->Directive.Data, Line->Directive.Length);
+            if(Null_Terminate)
+            {
+               Destination[Line->Length - 1] = 0;
+            }
          }
       }
       else
@@ -171,86 +451,244 @@ static void Encode_Literal_String(assembler_context *Context, source_code_line *
    }
 }
 
-static int Count_Lines_Of_Code(string Source_Code)
-{
-   int Result = 0;
+// NOTE: The tokenizer makes a single pass over the source, looking for the four
+// bytes that matter to it ('\n', '\\', ':' and '#') a block at a time. Every
+// other byte is only ever touched again by the trims at the edges of a line.
+
+#if defined(__AVX2__)
+#   define SCAN_BLOCK_SIZE 32
+#elif defined(__SSE2__)
+#   define SCAN_BLOCK_SIZE 16
+#else
+#   define SCAN_BLOCK_SIZE 32
+#endif
 
-   cut Lines = {0};
-   Lines.After = Source_Code;
+typedef struct {
+   u32 Markers;  // Bit set for each newline, comment, colon or hash byte.
+   u32 Newlines; // Bit set for each newline byte only.
+} marker_masks;
 
-   while(Lines.After.Length)
+static marker_masks Find_Markers_Scalar(u8 *Data, index Length)
+{
+   marker_masks Result = {0};
+   for(index Index = 0; Index < Length; ++Index)
    {
-      Lines = Cut(Lines.After, '\n');
-      cut Comment = Cut(Lines.Before, '\\');
+      u8 Byte = Data[Index];
+      u32 Bit = (u32)1 << Index;
 
-      Result += (Trim(Comment.Before).Length > 0);
+      if(Byte == '\n') Result.Newlines |= Bit;
+      if(Byte == '\n' || Byte == '\\' || Byte == ':' || Byte == '#') Result.Markers |= Bit;
    }
 
    return(Result);
 }
 
-static void Tokenize_Source_Lines(source_code_line *Result, string Source_Code)
+static marker_masks Find_Markers(u8 *Data)
 {
-   int Source_Line_Number = 1;
-   int Current_Line_Index = 0; // Index of allocated source line to populate.
+   marker_masks Result = {0};
+
+#if defined(__AVX2__)
+   __m256i Bytes = _mm256_loadu_si256((__m256i *)Data);
+   __m256i Newlines = _mm256_cmpeq_epi8(Bytes, _mm256_set1_epi8('\n'));
+   __m256i Comments = _mm256_cmpeq_epi8(Bytes, _mm256_set1_epi8('\\'));
+   __m256i Colons   = _mm256_cmpeq_epi8(Bytes, _mm256_set1_epi8(':'));
+   __m256i Hashes   = _mm256_cmpeq_epi8(Bytes, _mm256_set1_epi8('#'));
+
+   __m256i Markers = _mm256_or_si256(_mm256_or_si256(Newlines, Comments), _mm256_or_si256(Colons, Hashes));
+   Result.Markers = (u32)_mm256_movemask_epi8(Markers);
+   Result.Newlines = (u32)_mm256_movemask_epi8(Newlines);
+#elif defined(__SSE2__)
+   __m128i Bytes = _mm_loadu_si128((__m128i *)Data);
+   __m128i Newlines = _mm_cmpeq_epi8(Bytes, _mm_set1_epi8('\n'));
+   __m128i Comments = _mm_cmpeq_epi8(Bytes, _mm_set1_epi8('\\'));
+   __m128i Colons   = _mm_cmpeq_epi8(Bytes, _mm_set1_epi8(':'));
+   __m128i Hashes   = _mm_cmpeq_epi8(Bytes, _mm_set1_epi8('#'));
+
+   __m128i Markers = _mm_or_si128(_mm_or_si128(Newlines, Comments), _mm_or_si128(Colons, Hashes));
+   Result.Markers = (u32)_mm_movemask_epi8(Markers);
+   Result.Newlines = (u32)_mm_movemask_epi8(Newlines);
+#else
+   Result = Find_Markers_Scalar(Data, SCAN_BLOCK_SIZE);
+#endif
+
+   return(Result);
+}
 
-   cut Remaining_Lines = {0};
-   Remaining_Lines.After = Source_Code;
+typedef struct {
+   u8 *Begin;
+   u8 *Comment;    // First backslash.
+   u8 *Colon;      // First colon before the comment.
+   u8 *First_Hash; // First hash before the comment.
+   u8 *Label_Hash; // First hash after the colon and before the comment.
+} line_markers;
 
-   Remaining_Lines.After = Source_Code;
-   while(Remaining_Lines.After.Length)
+static bool Tokenize_Line(symbol_table *Symbols, source_code_line *Line, line_markers *Markers, u8 *End)
+{
+   // NOTE: Returns false for lines that are empty once comments and
+   // whitespace are removed.
+   if(Markers->Comment)
    {
-      Remaining_Lines = Cut(Remaining_Lines.After, '\n');
-      cut Comment = Cut(Remaining_Lines.Before, '\\');
-      string Text = Trim(Comment.Before);
+      End = Markers->Comment;
+   }
 
-      source_code_line Line = {0};
-      Line.Line_Number = Source_Line_Number++;
+   string Text = Trim(Span(Markers->Begin, End));
+   bool Result = (Text.Length > 0);
+   if(Result)
+   {
+      u8 *Text_End = Text.Data + Text.Length;
+      u8 *Hash = Markers->First_Hash;
 
-      if(Text.Length > 0)
+      if(Text.Data[0] == '#')
       {
-         if(Has_Prefix_Then_Remove(&Text, S("#")))
+         // NOTE: If a line begins with '#', it's a directive that extends
+         // to the end of the line, e.g. "#section text".
+         Line->Directive = Trim_Left(Span(Text.Data + 1, Text_End));
+      }
+      else
+      {
+         // NOTE: Labels are required to end with a colon.
+         if(Markers->Colon)
          {
-            // NOTE: If a line begins with '#', it's a directive that extends
-            // to the end of the line, e.g. "#section text".
-            Line.Directive = Trim_Left(Text);
+            Line->Label = Span(Text.Data, Markers->Colon);
+            Line->Label_Symbol = Intern_Symbol(Symbols, Line->Label);
+            Text = Trim_Left(Span(Markers->Colon + 1, Text_End));
+            Hash = Markers->Label_Hash;
+         }
+
+         if(Hash)
+         {
+            Line->Instruction = Trim(Span(Text.Data, Hash));
+            Line->Directive = Trim(Span(Hash + 1, Text_End));
          }
          else
          {
-            // NOTE: Labels are required to end with a colon.
-            cut Label = Cut(Text, ':');
-            if(Label.Found)
-            {
-               Line.Label = Label.Before;
-               Text = Trim_Left(Label.After);
-            }
+            Line->Instruction = Trim(Text);
+         }
+      }
+   }
 
-            cut Directive = Cut(Text, '#');
-            Line.Instruction = Trim(Directive.Before);
-            if(Directive.Found)
-            {
-               Line.Directive = Trim(Directive.After);
-            }
+   return(Result);
+}
+
+typedef struct {
+   source_code_line *Lines;
+   int Count;
+} source_code_lines;
+
+static source_code_lines Tokenize_Source_Lines(arena *Arena, symbol_table *Symbols, string Source_Code)
+{
+   // NOTE: Non-empty lines are pushed onto the top of the arena one at a time,
+   // so nothing else may allocate from it until tokenizing is finished. Labels
+   // are interned as they are found, which only touches the symbol table's own
+   // arena.
+   source_code_lines Result = {0};
+   Result.Lines = Allocate(Arena, source_code_line, 0);
+
+   int Source_Line_Number = 1;
+   line_markers Markers = {0};
+   Markers.Begin = Source_Code.Data;
+
+   u8 *Data = Source_Code.Data;
+   index Length = Source_Code.Length;
+   for(index Offset = 0; Offset < Length; Offset += SCAN_BLOCK_SIZE)
+   {
+      marker_masks Masks = ((Length - Offset) >= SCAN_BLOCK_SIZE)
+         ? Find_Markers(Data + Offset)
+         : Find_Markers_Scalar(Data + Offset, Length - Offset);
+
+      u32 Mask = (Markers.Comment) ? Masks.Newlines : Masks.Markers;
+      while(Mask)
+      {
+         int Bit = __builtin_ctz(Mask);
+         u8 *Position = Data + Offset + Bit;
+         Mask &= Mask - 1;
+
+         switch(*Position)
+         {
+            case '\n': {
+               source_code_line Line = {0};
+               Line.Line_Number = Source_Line_Number++;
+               if(Tokenize_Line(Symbols, &Line, &Markers, Position))
+               {
+                  *Allocate(Arena, source_code_line, 1) = Line;
+                  Result.Count++;
+               }
+
+               memset(&Markers, 0, sizeof(Markers));
+               Markers.Begin = Position + 1;
+
+               // NOTE: Back to considering every remaining marker in this block.
+               Mask = Masks.Markers & ((~(u32)1) << Bit);
+            } break;
+
+            case '\\': {
+               // NOTE: Nothing but the end of the line matters in a comment.
+               Markers.Comment = Position;
+               Mask &= Masks.Newlines;
+            } break;
+
+            case ':': {
+               if(!Markers.Colon) Markers.Colon = Position;
+            } break;
+
+            case '#': {
+               if(!Markers.First_Hash) Markers.First_Hash = Position;
+               if(Markers.Colon && !Markers.Label_Hash) Markers.Label_Hash = Position;
+            } break;
          }
+      }
+   }
 
-         Result[Current_Line_Index++] = Line;
+   u8 *End = Data + Length;
+   if(Markers.Begin < End)
+   {
+      // NOTE: The final line is not terminated by a newline.
+      source_code_line Line = {0};
+      Line.Line_Number = Source_Line_Number;
+      if(Tokenize_Line(Symbols, &Line, &Markers, End))
+      {
+         *Allocate(Arena, source_code_line, 1) = Line;
+         Result.Count++;
       }
    }
+
+   assert(Result.Count == 0 || (Result.Lines + Result.Count) == (source_code_line *)(Arena->Base + Arena->Used));
+   return(Result);
 }
 
 static void Parse_Source_Line(assembler_context *Context, source_code_line *Line)
 {
-   Line->Machine_Code.Address = Context->Current_Address;
+   Line->Address = Context->Current_Address;
    Context->Current_Line_Number = Line->Line_Number;
+   Context->Relaxation = Line->Relaxation;
 
+   // NOTE: Directives are parsed by removing prefixes from the line's own
+   // text, which is put back afterwards, since the line may be laid out again.
+   string Directive = Line->Directive;
    if(Line->Directive.Length)
    {
       if(Has_Prefix_Then_Remove(&Line->Directive, S("file ")))
       {
          Context->Output_File_Name = Trim_Left(Line->Directive);
       }
+      else if(Equals(Line->Directive, S("pool")))
+      {
+         Place_Literal_Pool(Context, false);
+      }
+      else if(Has_Prefix_Then_Remove(&Line->Directive, S("architecture ")) ||
+              Has_Prefix_Then_Remove(&Line->Directive, S("arch ")))
+      {
+         Place_Literal_Pool(Context, false);
+         Select_Architecture(Context, Trim(Line->Directive));
+      }
+      else if(Has_Prefix_Then_Remove(&Line->Directive, S("section ")))
+      {
+         Place_Literal_Pool(Context, false);
+         Switch_Section(Context, Trim(Line->Directive));
+      }
       else if(Has_Prefix_Then_Remove(&Line->Directive, S("location ")))
       {
+         Place_Literal_Pool(Context, false);
          parsed_integer Parsed_Address = Parse_Integer(Trim(Line->Directive));
          if(Parsed_Address.Ok)
          {
@@ -285,6 +723,18 @@ static void Parse_Source_Line(assembler_context *Context, source_code_line *Line
       {
          Encode_Literal_String(Context, Line, STRINGKIND_CSTRING);
       }
+      else if(Has_Prefix_Then_Remove(&Line->Directive, S("export ")))
+      {
+         // NOTE: Exported symbols are visible to other objects at link time.
+         cut Names = {0};
+         Names.After = Trim(Line->Directive);
+         while(Names.After.Length)
+         {
+            Names = Cut_Whitespace(Trim_Left(Names.After));
+            symbol_id Id = Intern_Symbol(&Context->Symbols, Names.Before);
+            Context->Symbols.Symbols[Id].Exported = true;
+         }
+      }
       else if(Has_Prefix_Then_Remove(&Line->Directive, S("constant ")))
       {
          cut Constant_Parts = Cut_Whitespace(Trim_Left(Line->Directive));
@@ -295,7 +745,7 @@ static void Parse_Source_Line(assembler_context *Context, source_code_line *Line
             parsed_integer Parsed_Value = Parse_Integer(Value);
             if(Parsed_Value.Ok)
             {
-               Insert(&Context->Arena, &Context->Constants, Name, Parsed_Value.Value);
+               Define_Symbol(&Context->Symbols, Intern_Symbol(&Context->Symbols, Name), Parsed_Value.Value);
             }
             else
             {
@@ -303,120 +753,740 @@ static void Parse_Source_Line(assembler_context *Context, source_code_line *Line
             }
          }
       }
+      else if(Context->Architecture && Context->Architecture->Parse_Directive)
+      {
+         Context->Architecture->Parse_Directive(Context, Line->Directive);
+      }
    }
 
-   if(Line->Label.Length)
+   if(Line->Label_Symbol)
    {
-      Insert(&Context->Arena, &Context->Constants, Line->Label, Line->Machine_Code.Address);
+      Define_Label(Context, Line->Label_Symbol, Line->Address);
    }
 
    if(Line->Instruction.Length)
    {
-      Line->Machine_Code = Encode_Instruction(Context, Line->Instruction);
-      Line->Machine_Code.Address = Context->Current_Address;
+      // NOTE: Encoded bytes go straight into the output image. Only fields
+      // that reference undefined symbols are revisited, by relocation.
+      if(Context->Architecture)
+      {
+         machine_code Machine_Code = Context->Architecture->Encode_Instruction(Context, Line->Instruction);
+         Line->Length = Machine_Code.Length;
+
+         if(Line->Length)
+         {
+            u8 *Destination = Reserve_Output(Context, Line->Address, Line->Length);
+            memcpy(Destination, Machine_Code.Bytes, Machine_Code.Length);
+         }
+      }
+      else
+      {
+         Report_Error(Context, "No architecture selected, use #architecture or --arch.");
+      }
    }
 
-   Context->Current_Address += Line->Machine_Code.Length;
+   Line->Directive = Directive;
+   Context->Current_Address += Line->Length;
 }
 
-static void Encode_Source_Line(assembler_context *Context, u8 *Result, source_code_line *Line)
+static bool Write_Output_Image(assembler_context *Context, char *Path)
 {
-   Context->Current_Address = Line->Machine_Code.Address;
-   Context->Current_Line_Number = Line->Line_Number;
+   output_image *Image = &Context->Output;
+
+   index Base = 0;
+   index End = 0;
+   index Segment_Count = 0;
+   for(output_segment *Segment = Image->Segments; Segment; Segment = Segment->Next)
+   {
+      if(Segment_Count == 0 || Segment->Address < Base) Base = Segment->Address;
+      if(Segment->Address + Segment->Length > End) End = Segment->Address + Segment->Length;
+      Segment_Count++;
+   }
+
+   if(Options.Fill)
+   {
+      Base = 0;
+   }
+
+   bool Result = false;
+   int File = open(Path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+   if(File >= 0)
+   {
+      Result = true;
+
+      if(Options.Fill && Options.Fill_Byte)
+      {
+         u8 Fill[64 * 1024];
+         memset(Fill, Options.Fill_Byte, sizeof(Fill));
+         for(index Offset = 0; Result && Offset < End; Offset += sizeof(Fill))
+         {
+            index Size = ((End - Offset) < (index)sizeof(Fill)) ? (End - Offset) : (index)sizeof(Fill);
+            Result = (write(File, Fill, Size) == Size);
+         }
+      }
+
+      // NOTE: Segments are written oldest first, so newer bytes overwrite older
+      // ones wherever they overlap. Anything never written reads as zero.
+      temporary_memory Scratch = Begin_Temporary_Memory(&Context->Arena);
+      output_segment **Segments = Allocate(&Context->Arena, output_segment *, Segment_Count);
+
+      index Segment_Index = Segment_Count;
+      for(output_segment *Segment = Image->Segments; Segment; Segment = Segment->Next)
+      {
+         Segments[--Segment_Index] = Segment;
+      }
+
+      for(Segment_Index = 0; Result && Segment_Index < Segment_Count; ++Segment_Index)
+      {
+         output_segment *Segment = Segments[Segment_Index];
+         index Written = 0;
+         while(Result && Written < Segment->Length)
+         {
+            ssize_t Size = pwrite(File, Segment->Data + Written, Segment->Length - Written,
+                                  (Segment->Address - Base) + Written);
+            Result = (Size > 0);
+            Written += (Result) ? Size : 0;
+         }
+      }
+      End_Temporary_Memory(Scratch);
 
-   u8 *Source = (Line->Machine_Code.Length > Array_Count(Line->Machine_Code.Bytes))
-      ? Line->Machine_Code.Bytes_Pointer
-      : Line->Machine_Code.Bytes;
+      Result = Result && (ftruncate(File, End - Base) == 0);
+      Result = (close(File) == 0) && Result;
+   }
+
+   return(Result);
+}
 
-   Apply_Patches(Context, &Line->Machine_Code);
-   for(int Byte_Index = 0; Byte_Index < Line->Machine_Code.Length; ++Byte_Index)
+static string Base_File_Name(string Path)
+{
+   // NOTE: Remove the preceding path and the .asm extension.
+   cut Nodes = {0};
+   Nodes.After = Path;
+   while(Nodes.After.Length)
    {
-      Result[Context->Current_Address++] = Source[Byte_Index];
+      Nodes = Cut(Nodes.After, '/');
    }
 
+   string Result = Nodes.Before;
+   Has_Suffix_Then_Remove(&Result, S(".asm"));
+
+   return(Result);
 }
 
 static string Name_Output_File(assembler_context *Context)
 {
+   // NOTE: Without a #file directive, the output is named after the input.
    string Result = Context->Output_File_Name;
+   if(Result.Length == 0)
+   {
+      Result = Base_File_Name(Context->Input_File_Path);
+   }
 
-   if(Context->Output_File_Name.Length == 0)
+   return(Result);
+}
+
+#include "object.c"
+
+static void Reset_Layout(assembler_context *Context)
+{
+   // NOTE: Everything a pass over the lines builds up, so that the same
+   // tokenized lines can be laid out again.
+   Context->Output_File_Name = (string){0};
+   Context->Current_Address = 0;
+   Context->Current_Line_Number = 0;
+   Undefine_Symbols(&Context->Symbols);
+   Reset_Relocation_Table(&Context->Relocations);
+   Reset_Literal_Pool(&Context->Literal_Pool);
+   Reset_Output_Image(&Context->Output);
+   Reset_Arena(&Context->Cache_Stream);
+   memset(Context->Sections, 0, sizeof(Context->Sections));
+   Context->Section_Count = 1;
+   Context->Current_Section = 0;
+   Context->Architecture = Options.Architecture;
+   Context->Instruction_Set = 0;
+}
+
+static void Reset_Context(assembler_context *Context)
+{
+   Reset_Arena(&Context->Arena);
+   Context->Input_File_Path = (string){0};
+   Reset_Symbol_Table(&Context->Symbols);
+   Reset_Layout(Context);
+}
+
+static bool Relax_Lines(assembler_context *Context, source_code_line *Lines, int Line_Count)
+{
+   // NOTE: Raise the Relaxation of each line with a relaxable relocation that
+   // doesn't fit, and return whether there were any. In objects, a value
+   // only fits if linking can't change it, i.e. it is absolute or a distance
+   // within one section. Undefined symbols are left for Apply_Relocations to
+   // report, unless the linker may still define them.
+   bool Result = false;
+
+   relocation_table *Table = &Context->Relocations;
+   symbol *Symbols = Context->Symbols.Symbols;
+   int Relaxed_Line_Number = -1;
+   int Line_Index = 0;
+   for(index Relocation_Index = 0; Table->Relaxable_Count && Relocation_Index < Table->Count; ++Relocation_Index)
    {
-      // NOTE: Remove preceding path from input file name.
-      cut Nodes = {0};
-      Nodes.After = Context->Input_File_Path;
-      while(Nodes.After.Length)
+      relocation *Relocation = Table->Relocations + Relocation_Index;
+      symbol *Symbol = Symbols + Relocation->Symbol;
+      if(!Relocation->Relaxable || Relocation->Line_Number == Relaxed_Line_Number)
       {
-         Nodes = Cut(Nodes.After, '/');
+         continue;
+      }
+
+      bool Fits = !Context->Relocatable_Output;
+      if(Symbol->Defined)
+      {
+         u8 *Destination = Find_Output(&Context->Output, Relocation->Section, Relocation->Address, Relocation->Width);
+         Fits = (!Context->Relocatable_Output || !Symbol->Section ||
+                 (Relocation_Kinds[Relocation->Kind].PC_Relative && Symbol->Section == Relocation->Section + 1));
+
+         // NOTE: A longer form doesn't help a misaligned target, which is left
+         // for Apply_Relocations to report.
+         u8 Field[8];
+         memcpy(Field, Destination, Relocation->Width);
+         Fits = Fits && (Encode_Relocation(Field, Relocation, Symbol->Value) != RELOCATION_OUT_OF_RANGE);
       }
-      Result = Nodes.Before;
 
-      // NOTE: Remove file extension in case where input file name was used.
-      Has_Suffix_Then_Remove(&Result, S(".asm"));
+      if(!Fits)
+      {
+         // NOTE: Lines request their relocations in order.
+         while(Line_Index < Line_Count && Lines[Line_Index].Line_Number < Relocation->Line_Number)
+         {
+            Line_Index++;
+         }
+
+         if(Line_Index < Line_Count && Lines[Line_Index].Relaxation < UINT8_MAX)
+         {
+            Lines[Line_Index].Relaxation++;
+            Relaxed_Line_Number = Relocation->Line_Number;
+            Result = true;
+         }
+      }
    }
 
    return(Result);
 }
 
-int main(int Argument_Count, char **Arguments)
+static void Layout_Source_Lines(assembler_context *Context, source_code_line *Lines, int Line_Count, cache_entry *Cache)
 {
-   assembler_context Context = {0};
-   Context.Arena.Size = 256 * 1024 * 1024;
-   Context.Arena.Base = malloc(Context.Arena.Size);
+   // NOTE: Machine code is generated for each line, written directly into the
+   // output image, and the address of each label is stored. Lines that are
+   // unchanged since the file was cached are replayed instead of encoded.
+   //
+   // References to labels that aren't known yet assume the shortest form of
+   // an instruction where there is a choice. If any turn out not to reach,
+   // those lines are relaxed to a longer form and the file is laid out again
+   // from the start, since every later address may move. Lines only ever
+   // grow, so this reaches a fixed point, usually after one pass. Files with
+   // errors keep their first layout so nothing is reported twice.
+   for(int Pass = 0;; ++Pass)
+   {
+      for(int Line_Index = 0; Line_Index < Line_Count; ++Line_Index)
+      {
+         source_code_line *Line = Lines + Line_Index;
+         if(Pass == 0)
+         {
+            Count_Mnemonic(Context, Line);
+         }
+         Place_Literal_Pool_If_Due(Context);
 
-   arena *Arena = &Context.Arena;
+         if(!Cache || !Replay_Cached_Line(Context, Cache, Line))
+         {
+            Begin_Cached_Line(Context, Line);
+            Parse_Source_Line(Context, Line);
+            End_Cached_Line(Context, Line);
+         }
+      }
+      Place_Literal_Pool(Context, false);
 
-   Initialize_Architecture(&Context);
+      if(Context->Error_Count || !Relax_Lines(Context, Lines, Line_Count))
+      {
+         break;
+      }
+      Reset_Layout(Context);
+   }
+}
 
-   // NOTE: For now, assume that all provided arguments are input files.
-   for(int Argument_Index = 1; Argument_Index < Argument_Count; ++Argument_Index)
+static void Assemble_File(assembler_context *Context, char *Path)
+{
+   double Pass_Start = Stats_Clock();
+   double File_Start = Pass_Start;
+   arena *Arena = &Context->Arena;
+   input_file Input = Open_Input_File(Arena, Path, !Options.Watch);
+   string Source_Code = Input.Contents;
+
+   if(Source_Code.Length)
    {
-      char *Path = Arguments[Argument_Index];
-      string Source_Code = Read_Entire_File(Arena, Path);
+      Context->Input_File_Path = From_C_String(Path);
+      Context->Error_Count = 0;
+
+      Context->Relocatable_Output = Options.Object_Output;
 
-      if(Source_Code.Length)
+      cache_entry Cache = {0};
+      u64 Content_Key = 0;
+      if(Cache_Enabled())
       {
-         Context.Input_File_Path = From_C_String(Path);
+         Cache = Load_Cache_Entry(Context, Path);
+         Content_Key = Cache_Content_Key(Source_Code);
+      }
+      Record_Pass(Context, PASS_READ, &Pass_Start);
 
-         // First pass to determine the number of lines to allocate. This will
-         // include any non-empty line of source code.
-         int Line_Count = Count_Lines_Of_Code(Source_Code);
+      if(Cache.Loaded && Cache.Header->Content_Key == Content_Key)
+      {
+         // NOTE: The file is unchanged since it was cached, so its output is
+         // reproduced without tokenizing or encoding anything.
+         Restore_Cached_Output(Context, &Cache);
+         Record_Pass(Context, PASS_ENCODE, &Pass_Start);
+      }
+      else
+      {
+         Context->Cache_Recording = Cache_Enabled();
+
+         // First pass to identify directives, labels and instructions for each
+         // non-empty line of assembly code.
+         source_code_lines Tokens = Tokenize_Source_Lines(Arena, &Context->Symbols, Source_Code);
+         source_code_line *Lines = Tokens.Lines;
+         int Line_Count = Tokens.Count;
+         Record_Pass(Context, PASS_TOKENIZE, &Pass_Start);
+         if(Context->Stats)
+         {
+            Context->Stats->Line_Count = Line_Count;
+         }
 
-         // Second pass to identify directives, labels and instructions for each
-         // allocated line of assembly code.
-         source_code_line *Lines = Allocate(Arena, source_code_line, Line_Count);
-         Tokenize_Source_Lines(Lines, Source_Code);
+         // Second pass to generate machine code based on identified assembly
+         // instructions, see Layout_Source_Lines.
+         Layout_Source_Lines(Context, Lines, Line_Count, &Cache);
+         Record_Pass(Context, PASS_ENCODE, &Pass_Start);
 
-         // Third pass to generate machine code based on identified assembly
-         // instructions. The address associated with each label is stored.
-         for(int Line_Index = 0; Line_Index < Line_Count; ++Line_Index)
+         // Addresses of labels are then patched into any instructions that
+         // referenced them before they were defined, in one batch. Objects
+         // leave every relocation for the linker.
+         if(!Options.Object_Output)
          {
-            Parse_Source_Line(&Context, Lines + Line_Index);
+            Apply_Relocations(Context);
          }
+         Record_Pass(Context, PASS_RELOCATE, &Pass_Start);
 
-         // Fourth pass to populate output buffer with machine code and patch
-         // addresses into any instructions that reference labels.
-         u8 *Output = Allocate(Arena, u8, Context.Current_Address);
-         for(int Line_Index = 0; Line_Index < Line_Count; ++Line_Index)
+         if(Context->Cache_Recording && Context->Error_Count == 0)
          {
-            Encode_Source_Line(&Context, Output, Lines + Line_Index);
+            Store_Cache_Entry(Context, Path, Content_Key);
          }
+         Context->Cache_Recording = false;
+      }
+
+      // TODO: Converting back and forth to null-terminated strings is silly,
+      // but the file read and write functions work more naturally with them
+      // when using the CRT. So maybe stop using CRT functions.
+      temporary_memory Scratch = Begin_Temporary_Memory(Arena);
+      if(Options.Object_Output)
+      {
+         // NOTE: Objects are named after the input file, like a C compiler.
+         string Base_Name = Base_File_Name(Context->Input_File_Path);
+         char *Object_Name = Allocate(Arena, char, Base_Name.Length + 3);
+         memcpy(Object_Name, Base_Name.Data, Base_Name.Length);
+         memcpy(Object_Name + Base_Name.Length, ".o", 3);
 
-         // TODO: Converting back and forth to null-terminated strings is silly,
-         // but the file read and write functions work more naturally with them
-         // when using the CRT. So maybe stop using CRT functions.
-         string Output_Name = Name_Output_File(&Context);
-         if(!Write_Entire_File(Output, Context.Current_Address, To_C_String(Arena, Output_Name)))
+         if(!Write_Object_File(Context, Object_Name))
+         {
+            Report_Error(0, "Failed to write to object file \"%s\".", Object_Name);
+         }
+      }
+      else
+      {
+         string Output_Name = Name_Output_File(Context);
+         if(!Write_Output_Image(Context, To_C_String(Arena, Output_Name)))
          {
             Report_Error(0, "Failed to write to output file \"%.*s\".", SF(Output_Name));
          }
       }
+      End_Temporary_Memory(Scratch);
+      Record_Pass(Context, PASS_WRITE, &Pass_Start);
+   }
+
+   if(Options.Report_Memory)
+   {
+      Print_Message(Context, stdout, "%s: arena high-water mark %td bytes, %td bytes committed\n",
+                    Path, Arena->Peak, Arena->Committed);
+   }
+
+   Trace_Event("file", From_C_String(Path), File_Start, Stats_Clock());
+
+   // Reset assembler state for the next input file.
+   Finish_File_Stats(Context, Path, &Input);
+   Close_Input_File(&Input);
+   Reset_Context(Context);
+}
+
+// NOTE: This is only reserved address space, pages are committed on demand.
+#define ASSEMBLER_ARENA_SIZE ((index)64 * 1024 * 1024 * 1024)
+#define SYMBOL_ARENA_SIZE ((index)16 * 1024 * 1024 * 1024)
+#define RELOCATION_ARENA_SIZE ((index)16 * 1024 * 1024 * 1024)
+#define LITERAL_ARENA_SIZE ((index)1024 * 1024 * 1024)
+#define OUTPUT_ARENA_SIZE ((index)64 * 1024 * 1024 * 1024)
+#define CACHE_ARENA_SIZE ((index)16 * 1024 * 1024 * 1024)
+
+static void Create_Context(assembler_context *Context)
+{
+   memset(Context, 0, sizeof(*Context));
+   Context->Arena = Reserve_Arena(ASSEMBLER_ARENA_SIZE);
+   Context->Symbols.Arena = Reserve_Arena(SYMBOL_ARENA_SIZE);
+   Context->Relocations.Arena = Reserve_Arena(RELOCATION_ARENA_SIZE);
+   Context->Literal_Pool.Arena = Reserve_Arena(LITERAL_ARENA_SIZE);
+   Context->Output.Arena = Reserve_Arena(OUTPUT_ARENA_SIZE);
+   Context->Cache_Stream = Reserve_Arena(CACHE_ARENA_SIZE);
+   Context->Mnemonic_Histogram.Arena = Reserve_Arena(HISTOGRAM_ARENA_SIZE);
+   Context->Section_Count = 1;
+   Context->Architecture = Options.Architecture;
+}
+
+static void Destroy_Context(assembler_context *Context)
+{
+   Release_Arena(&Context->Mnemonic_Histogram.Arena);
+   Release_Arena(&Context->Cache_Stream);
+   Release_Arena(&Context->Output.Arena);
+   Release_Arena(&Context->Literal_Pool.Arena);
+   Release_Arena(&Context->Relocations.Arena);
+   Release_Arena(&Context->Symbols.Arena);
+   Release_Arena(&Context->Arena);
+}
+
+typedef struct {
+   char *Path;
+   message_log Log;
+   file_stats *Stats;
+   bool Finished;
+} assembly_job;
+
+typedef struct {
+   assembly_job *Jobs;
+   int Job_Count;
+   int Next_Job;
+
+   pthread_mutex_t Mutex;
+   pthread_cond_t Job_Finished;
+} job_queue;
+
+static void *Assembly_Worker(void *Parameter)
+{
+   job_queue *Queue = Parameter;
+
+   // NOTE: Each worker owns its context, arena and symbol table, so nothing is
+   // shared between threads except the read-only architecture tables.
+   assembler_context Context;
+   Create_Context(&Context);
+   Thread_Context = &Context;
+
+   Begin_Trace_Thread("worker");
+   double Worker_Start = Stats_Clock();
+
+   while(1)
+   {
+      int Job_Index = __atomic_fetch_add(&Queue->Next_Job, 1, __ATOMIC_RELAXED);
+      if(Job_Index >= Queue->Job_Count)
+      {
+         break;
+      }
+
+      assembly_job *Job = Queue->Jobs + Job_Index;
+      Context.Log = &Job->Log;
+      Context.Stats = Job->Stats;
+      Assemble_File(&Context, Job->Path);
+      Context.Log = 0;
+      Context.Stats = 0;
 
-      // Reset assembler state for the next input file.
-      Reset_Arena(Arena);
-      Context.Current_Address = 0;
-      Context.Constants = 0;
+      pthread_mutex_lock(&Queue->Mutex);
+      Job->Finished = true;
+      pthread_cond_broadcast(&Queue->Job_Finished);
+      pthread_mutex_unlock(&Queue->Mutex);
    }
 
+   Trace_Event("worker", (string){0}, Worker_Start, Stats_Clock());
+   End_Trace_Thread();
+
+   Thread_Context = 0;
+   Destroy_Context(&Context);
+
    return(0);
 }
+
+static void Assemble_Files_In_Parallel(char **Paths, file_stats *Stats, int Path_Count, int Thread_Count)
+{
+   job_queue Queue = {0};
+   Queue.Jobs = calloc(Path_Count, sizeof(*Queue.Jobs));
+   Queue.Job_Count = Path_Count;
+   pthread_mutex_init(&Queue.Mutex, 0);
+   pthread_cond_init(&Queue.Job_Finished, 0);
+
+   for(int Path_Index = 0; Path_Index < Path_Count; ++Path_Index)
+   {
+      Queue.Jobs[Path_Index].Path = Paths[Path_Index];
+      Queue.Jobs[Path_Index].Stats = (Stats) ? (Stats + Path_Index) : 0;
+   }
+
+   if(Thread_Count > Path_Count)
+   {
+      Thread_Count = Path_Count;
+   }
+
+   pthread_t *Threads = calloc(Thread_Count, sizeof(*Threads));
+   int Started_Count = 0;
+   while(Started_Count < Thread_Count && pthread_create(Threads + Started_Count, 0, Assembly_Worker, &Queue) == 0)
+   {
+      Started_Count++;
+   }
+
+   if(Started_Count < Thread_Count)
+   {
+      // NOTE: Jobs left by a thread that couldn't be created are taken by the
+      // calling thread, which works through the queue like any other worker
+      // and keeps its own trace buffer afterwards.
+      trace_buffer *Main_Trace_Buffer = Trace_Buffer;
+      Assembly_Worker(&Queue);
+      Trace_Buffer = Main_Trace_Buffer;
+   }
+
+   // NOTE: Diagnostics are flushed in argument order as each job finishes, so
+   // the output matches a serial run regardless of scheduling. Time spent
+   // waiting here is traced, which shows a straggler holding up the rest.
+   for(int Job_Index = 0; Job_Index < Queue.Job_Count; ++Job_Index)
+   {
+      assembly_job *Job = Queue.Jobs + Job_Index;
+
+      double Wait_Start = Stats_Clock();
+      pthread_mutex_lock(&Queue.Mutex);
+      while(!Job->Finished)
+      {
+         pthread_cond_wait(&Queue.Job_Finished, &Queue.Mutex);
+      }
+      pthread_mutex_unlock(&Queue.Mutex);
+      Trace_Event("wait", From_C_String(Job->Path), Wait_Start, Stats_Clock());
+
+      Flush_Message_Log(&Job->Log);
+   }
+
+   for(int Thread_Index = 0; Thread_Index < Started_Count; ++Thread_Index)
+   {
+      pthread_join(Threads[Thread_Index], 0);
+   }
+
+   pthread_cond_destroy(&Queue.Job_Finished);
+   pthread_mutex_destroy(&Queue.Mutex);
+   free(Threads);
+   free(Queue.Jobs);
+}
+
+#include "watch.c"
+
+int main(int Argument_Count, char **Arguments)
+{
+   int Thread_Count = 1;
+   int Path_Count = 0;
+   char **Paths = calloc(Argument_Count, sizeof(*Paths));
+
+   int Result = 0;
+   for(int Argument_Index = 1; !Result && Argument_Index < Argument_Count; ++Argument_Index)
+   {
+      string Argument = From_C_String(Arguments[Argument_Index]);
+      if(Equals(Argument, S("--memory")))
+      {
+         Options.Report_Memory = true;
+      }
+      else if(Equals(Argument, S("--stats")))
+      {
+         Options.Report_Stats = true;
+      }
+      else if(Equals(Argument, S("--fill")))
+      {
+         string Fill = (Argument_Index + 1 < Argument_Count) ? From_C_String(Arguments[++Argument_Index]) : (string){0};
+         parsed_integer Parsed_Fill = Parse_Integer(Fill);
+         if(Equals(Fill, S("none")))
+         {
+            Options.Fill = false;
+         }
+         else if(Fill.Length && Parsed_Fill.Ok && Parsed_Fill.Value >= 0 && Parsed_Fill.Value <= 0xFF)
+         {
+            Options.Fill = true;
+            Options.Fill_Byte = (u8)Parsed_Fill.Value;
+         }
+         else
+         {
+            Report_Error(0, "Invalid value for --fill, expected \"none\" or a byte: \"%.*s\".", SF(Fill));
+            Result = 1;
+         }
+      }
+      else if(Equals(Argument, S("-c")))
+      {
+         Options.Object_Output = true;
+      }
+      else if(Equals(Argument, S("--link")))
+      {
+         if(Argument_Index + 1 < Argument_Count)
+         {
+            Options.Link_Output = Arguments[++Argument_Index];
+         }
+         else
+         {
+            Report_Error(0, "Expected an output file after --link.");
+            Result = 1;
+         }
+      }
+      else if(Equals(Argument, S("--arch")))
+      {
+         if(Argument_Index + 1 < Argument_Count)
+         {
+            string Name = From_C_String(Arguments[++Argument_Index]);
+            Options.Architecture = Find_Architecture(Name);
+            if(Options.Architecture)
+            {
+               Prepare_Architecture(Options.Architecture);
+            }
+            else
+            {
+               Report_Error(0, "Unsupported architecture for --arch: \"%.*s\".", SF(Name));
+               Result = 1;
+            }
+         }
+         else
+         {
+            Report_Error(0, "Expected an architecture after --arch.");
+            Result = 1;
+         }
+      }
+      else if(Equals(Argument, S("--watch")))
+      {
+         Options.Watch = true;
+      }
+      else if(Equals(Argument, S("--trace")))
+      {
+         if(Argument_Index + 1 < Argument_Count)
+         {
+            Options.Trace_Path = Arguments[++Argument_Index];
+         }
+         else
+         {
+            Report_Error(0, "Expected an output file after --trace.");
+            Result = 1;
+         }
+      }
+      else if(Equals(Argument, S("--cache")))
+      {
+         if(Argument_Index + 1 < Argument_Count)
+         {
+            Options.Cache_Directory = Arguments[++Argument_Index];
+         }
+         else
+         {
+            Report_Error(0, "Expected a directory after --cache.");
+            Result = 1;
+         }
+      }
+      else if(Has_Prefix_Then_Remove(&Argument, S("-j")))
+      {
+         if(Argument.Length == 0 && (Argument_Index + 1) < Argument_Count)
+         {
+            Argument = From_C_String(Arguments[++Argument_Index]);
+         }
+
+         parsed_integer Parsed_Count = Parse_Integer(Argument);
+         if(Argument.Length && Parsed_Count.Ok && Parsed_Count.Value > 0)
+         {
+            Thread_Count = (int)Parsed_Count.Value;
+         }
+         else
+         {
+            Report_Error(0, "Invalid thread count for -j: \"%.*s\".", SF(Argument));
+            Result = 1;
+         }
+      }
+      else
+      {
+         // NOTE: Every other argument is an input file.
+         Paths[Path_Count++] = Arguments[Argument_Index];
+      }
+   }
+
+   if(Result)
+   {
+      free(Paths);
+      return(Result);
+   }
+
+   if(Options.Cache_Directory)
+   {
+      // NOTE: An existing directory is fine, anything else is reported when
+      // the first entry fails to be written.
+      mkdir(Options.Cache_Directory, 0777);
+   }
+
+   double Start_Time = Stats_Clock();
+   file_stats *Stats = (Options.Report_Stats) ? calloc(Path_Count + 1, sizeof(*Stats)) : 0;
+
+   Trace_Epoch = Start_Time;
+   Begin_Trace_Thread("main");
+
+   if(Options.Link_Output)
+   {
+      assembler_context Context;
+      Create_Context(&Context);
+      Thread_Context = &Context;
+
+      if(!Link_Objects(&Context, Paths, Path_Count, Options.Link_Output))
+      {
+         Result = 1;
+      }
+
+      Thread_Context = 0;
+      Destroy_Context(&Context);
+   }
+   else if(Thread_Count > 1 && Path_Count > 1)
+   {
+      Assemble_Files_In_Parallel(Paths, Stats, Path_Count, Thread_Count);
+   }
+   else
+   {
+      assembler_context Context;
+      Create_Context(&Context);
+      Thread_Context = &Context;
+
+      for(int Path_Index = 0; Path_Index < Path_Count; ++Path_Index)
+      {
+         Context.Stats = (Stats) ? (Stats + Path_Index) : 0;
+         Assemble_File(&Context, Paths[Path_Index]);
+      }
+
+      Thread_Context = 0;
+      Destroy_Context(&Context);
+   }
+
+   Trace_Event((Options.Link_Output) ? "link" : "assemble", (string){0}, Start_Time, Stats_Clock());
+   End_Trace_Thread();
+   if(Options.Trace_Path)
+   {
+      Write_Trace(Options.Trace_Path);
+   }
+
+   if(Stats && !Options.Link_Output)
+   {
+      Print_Stats(Stats, Path_Count, Stats_Clock() - Start_Time);
+   }
+   free(Stats);
+
+   if(Options.Watch)
+   {
+      if(Options.Link_Output)
+      {
+         Report_Error(0, "--watch cannot be combined with --link.");
+         Result = 1;
+      }
+      else if(!Watch_Files(Paths, Path_Count))
+      {
+         Result = 1;
+      }
+   }
+
+   free(Paths);
+   return(Result);
+}
@@ -14,42 +14,148 @@ typedef int64_t s64;
 #include <stddef.h>
 typedef ptrdiff_t index;
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #define index YOU_CANT_HAVE_INDEX
 #include <string.h>
 #undef index
 
 #define Array_Count(Array) (index)(sizeof(Array) / sizeof((Array)[0]))
 
+// NOTE: Arenas reserve a large range of address space up front and only commit
+// pages as allocations reach them, so resident memory tracks actual usage.
+
+#define ARENA_COMMIT_GRANULARITY (64 * 1024)
+
 typedef struct {
    u8 *Base;
-   index Size;
+   index Size;      // Bytes of address space reserved.
    index Used;
+   index Committed; // Bytes backed by read/write pages.
+
+   index Peak;      // Highest Used since the last reset.
+   index Dirty;     // Highest Used ever, i.e. memory that may be non-zero.
 } arena;
 
+typedef struct {
+   arena *Arena;
+   index Used;
+} temporary_memory;
+
+static arena Reserve_Arena(index Size)
+{
+   arena Result = {0};
+
+   void *Base = mmap(0, Size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+   if(Base != MAP_FAILED)
+   {
+      Result.Base = Base;
+      Result.Size = Size;
+   }
+   else
+   {
+      Report_Error(0, "Failed to reserve %td bytes of address space.", Size);
+   }
+
+   return(Result);
+}
+
+static void Release_Arena(arena *Arena)
+{
+   if(Arena->Base)
+   {
+      munmap(Arena->Base, Arena->Size);
+   }
+   memset(Arena, 0, sizeof(*Arena));
+}
+
+static bool Commit_Arena(arena *Arena, index Required)
+{
+   // NOTE: Make sure the first Required bytes of the arena are usable.
+   bool Result = (Required <= Arena->Committed);
+   if(!Result && Required <= Arena->Size)
+   {
+      index Commit_Size = (Required + ARENA_COMMIT_GRANULARITY - 1) & ~(index)(ARENA_COMMIT_GRANULARITY - 1);
+      if(Commit_Size > Arena->Size)
+      {
+         Commit_Size = Arena->Size;
+      }
+
+      u8 *Commit_Base = Arena->Base + Arena->Committed;
+      Result = (mprotect(Commit_Base, Commit_Size - Arena->Committed, PROT_READ|PROT_WRITE) == 0);
+      if(Result)
+      {
+         Arena->Committed = Commit_Size;
+      }
+   }
+
+   return(Result);
+}
+
+static void Update_Arena_Marks(arena *Arena)
+{
+   if(Arena->Used > Arena->Peak)  Arena->Peak = Arena->Used;
+   if(Arena->Used > Arena->Dirty) Arena->Dirty = Arena->Used;
+}
+
 static void Reset_Arena(arena *Arena)
 {
+   // NOTE: Committed pages are kept around for the next file.
    Arena->Used = 0;
+   Arena->Peak = 0;
 }
 
-#define Allocate(Arena, type, Count)                        \
-   (type *)Allocate_Size((Arena), sizeof(type) * (Count))
+// NOTE: Allocate aligns to the type, so consecutive single-element allocations
+// of the same type form a contiguous array.
+#define Allocate(Arena, type, Count)                                    \
+   (type *)Allocate_Size_Aligned((Arena), sizeof(type) * (Count), _Alignof(type))
+
+#define Allocate_Size(Arena, Size) Allocate_Size_Aligned((Arena), (Size), 16)
 
-static void *Allocate_Size(arena *Arena, index Size)
+static void *Allocate_Size_Aligned(arena *Arena, index Size, index Alignment)
 {
-   void *Result = 0;
-   if(Size <= (Arena->Size - Arena->Used))
+   index Aligned_Used = (Arena->Used + (Alignment - 1)) & ~(Alignment - 1);
+   if(Size > (Arena->Size - Aligned_Used) || !Commit_Arena(Arena, Aligned_Used + Size))
    {
-      Result = Arena->Base + Arena->Used;
-      Arena->Used += Size;
+      // NOTE: There is no sensible way to continue assembling, and callers
+      // don't check for failure, so treat this as fatal.
+      fprintf(stderr, "ERROR: Arena ran out of memory, failed to allocate %td bytes.\n", Size);
+      exit(1);
    }
-   else
+
+   u8 *Result = Arena->Base + Aligned_Used;
+   Arena->Used = Aligned_Used + Size;
+
+   // NOTE: Callers expect zeroed memory. Pages past the dirty mark are still
+   // zero from the OS, so only memory reused after a reset needs clearing.
+   if(Aligned_Used < Arena->Dirty)
    {
-      Report_Error(0, "Arena ran out of memory, failed to allocate %zu bytes.", Size);
+      index Dirty_Size = Arena->Dirty - Aligned_Used;
+      memset(Result, 0, (Dirty_Size < Size) ? Dirty_Size : Size);
    }
+   Update_Arena_Marks(Arena);
 
    return(Result);
 }
 
+static temporary_memory Begin_Temporary_Memory(arena *Arena)
+{
+   temporary_memory Result = {0};
+   Result.Arena = Arena;
+   Result.Used = Arena->Used;
+
+   return(Result);
+}
+
+static void End_Temporary_Memory(temporary_memory Temporary)
+{
+   assert(Temporary.Arena->Used >= Temporary.Used);
+   Temporary.Arena->Used = Temporary.Used;
+}
+
 typedef struct {
    u8 *Data;
    index Length;
@@ -275,88 +381,306 @@ static parsed_integer Parse_Integer(string Number)
    return(Result);
 }
 
-typedef struct map map;
-struct map
-{
-   map *Children[4];
-   string Key;
+// NOTE: Symbols (labels and constants) live in an open-addressing hash table.
+// Each distinct name is interned once and gets a small integer ID, so later
+// passes and patches refer to symbols by ID rather than by string. Slots store
+// the hash next to the ID, so probing rarely touches the names themselves.
+
+typedef u32 symbol_id; // Zero means no symbol.
+
+typedef struct {
+   string Name;
+   u64 Hash;
    u64 Value;
-};
+   bool Defined;
+   bool Exported;
+   int Section; // Section index plus one for labels, zero for absolute values.
+} symbol;
 
-static u64 Hash64(string String)
+typedef struct {
+   u32 Hash;
+   symbol_id Id;
+} symbol_slot;
+
+typedef struct {
+   arena Arena;
+
+   symbol *Symbols; // Indexed by ID, entry zero is unused.
+   u32 Symbol_Count;
+   u32 Symbol_Capacity;
+
+   symbol_slot *Slots;
+   u32 Slot_Capacity; // Always a power of two.
+} symbol_table;
+
+typedef struct {
+   u64 Value;
+   bool Found;
+} lookup_result;
+
+static u64 Hash_String(string String)
 {
-   u64 Result = 0x100;
-   for(index Index = 0; Index < String.Length; ++Index)
+   // NOTE: Consume eight bytes per multiply, with the tail packed into a
+   // final word.
+   u64 Result = 0x9E3779B97F4A7C15 ^ (u64)String.Length;
+
+   index Index = 0;
+   for(; Index + 8 <= String.Length; Index += 8)
+   {
+      u64 Word;
+      memcpy(&Word, String.Data + Index, sizeof(Word));
+
+      Result = (Result ^ Word) * 0xBF58476D1CE4E5B9;
+      Result ^= Result >> 31;
+   }
+
+   u64 Tail = 0;
+   for(int Shift = 0; Index < String.Length; ++Index, Shift += 8)
    {
-      Result ^= String.Data[Index] & 0xFF;
-      Result *= 1111111111111111111;
+      Tail |= (u64)String.Data[Index] << Shift;
    }
 
+   // NOTE: The final multiply only carries the tail's high bytes upwards, so
+   // fold the top half back down before mixing again. Otherwise names that
+   // differ only near their end (Label_1, Label_2...) share low bits, and the
+   // symbol table indexes slots with the low bits.
+   Result = (Result ^ Tail) * 0x94D049BB133111EB;
+   Result ^= Result >> 32;
+   Result *= 0xBF58476D1CE4E5B9;
+   Result ^= Result >> 29;
+
    return(Result);
 }
 
-typedef struct {
-   u64 Value;
-   bool Found;
-} lookup_result;
+static void Reset_Symbol_Table(symbol_table *Table)
+{
+   Reset_Arena(&Table->Arena);
+
+   Table->Symbols = 0;
+   Table->Symbol_Count = 0;
+   Table->Symbol_Capacity = 0;
+   Table->Slots = 0;
+   Table->Slot_Capacity = 0;
+}
 
-static lookup_result Lookup(map *Map, string Key)
+static void Grow_Symbol_Slots(symbol_table *Table)
 {
-   lookup_result Result = {0};
+   // NOTE: The old slot array is left behind in the table's arena, which is
+   // bounded by the geometric growth.
+   u32 Capacity = (Table->Slot_Capacity) ? (Table->Slot_Capacity * 2) : 256;
+   symbol_slot *Slots = Allocate(&Table->Arena, symbol_slot, Capacity);
+
+   for(u32 Slot_Index = 0; Slot_Index < Table->Slot_Capacity; ++Slot_Index)
+   {
+      symbol_slot Slot = Table->Slots[Slot_Index];
+      if(Slot.Id)
+      {
+         u32 Index = Slot.Hash & (Capacity - 1);
+         while(Slots[Index].Id)
+         {
+            Index = (Index + 1) & (Capacity - 1);
+         }
+         Slots[Index] = Slot;
+      }
+   }
+
+   Table->Slots = Slots;
+   Table->Slot_Capacity = Capacity;
+}
+
+static symbol_id Intern_Symbol(symbol_table *Table, string Name)
+{
+   if((Table->Symbol_Count + 1) * 4 >= Table->Slot_Capacity * 3)
+   {
+      // NOTE: Keep the load factor under 3/4.
+      Grow_Symbol_Slots(Table);
+   }
+
+   u64 Hash = Hash_String(Name);
+   u32 Mask = Table->Slot_Capacity - 1;
+   u32 Index = (u32)Hash & Mask;
 
-   for(u64 Hash = Hash64(Key); Map; Hash <<= 2)
+   symbol_id Result = 0;
+   while(Table->Slots[Index].Id)
    {
-      if(Equals(Key, Map->Key))
+      symbol_slot Slot = Table->Slots[Index];
+      if(Slot.Hash == (u32)Hash && Equals(Table->Symbols[Slot.Id].Name, Name))
       {
-         Result.Value = Map->Value;
-         Result.Found = true;
+         Result = Slot.Id;
          break;
       }
-      Map = Map->Children[Hash >> 62];
+      Index = (Index + 1) & Mask;
+   }
+
+   if(!Result)
+   {
+      if(Table->Symbol_Count + 1 >= Table->Symbol_Capacity)
+      {
+         u32 Capacity = (Table->Symbol_Capacity) ? (Table->Symbol_Capacity * 2) : 256;
+         symbol *Symbols = Allocate(&Table->Arena, symbol, Capacity);
+         if(Table->Symbol_Count)
+         {
+            memcpy(Symbols, Table->Symbols, sizeof(symbol) * (Table->Symbol_Count + 1));
+         }
+
+         Table->Symbols = Symbols;
+         Table->Symbol_Capacity = Capacity;
+      }
+
+      Result = ++Table->Symbol_Count;
+      Table->Symbols[Result].Name = Name;
+      Table->Symbols[Result].Hash = Hash;
+
+      Table->Slots[Index].Hash = (u32)Hash;
+      Table->Slots[Index].Id = Result;
    }
 
    return(Result);
 }
 
-static void Insert(arena *Arena, map **Map, string Key, u64 Value)
+static u64 Symbol_Probe_Distance(symbol_table *Table)
 {
-   bool Found = false;
-   for(u64 Hash = Hash64(Key); *Map; Hash <<= 2)
+   // NOTE: Total distance of symbols from their home slots, i.e. the extra
+   // probes it takes to find every symbol once.
+   u64 Result = 0;
+   u32 Mask = Table->Slot_Capacity - 1;
+   for(u32 Slot_Index = 0; Slot_Index < Table->Slot_Capacity; ++Slot_Index)
    {
-      if(Equals(Key, (*Map)->Key))
+      symbol_slot Slot = Table->Slots[Slot_Index];
+      if(Slot.Id)
       {
-         (*Map)->Value = Value;
-         Found = true;
-         break;
+         Result += (Slot_Index - (Slot.Hash & Mask)) & Mask;
       }
-      Map = &(*Map)->Children[Hash >> 62];
    }
 
-   if(!Found)
+   return(Result);
+}
+
+static void Define_Symbol(symbol_table *Table, symbol_id Id, u64 Value)
+{
+   Table->Symbols[Id].Value = Value;
+   Table->Symbols[Id].Defined = true;
+}
+
+static void Undefine_Symbols(symbol_table *Table)
+{
+   // NOTE: Forget every definition but keep the IDs, which tokenized lines
+   // refer to.
+   for(symbol_id Id = 1; Id <= Table->Symbol_Count; ++Id)
    {
-      *Map = Allocate(Arena, map, 1);
-      (*Map)->Key = Key;
-      (*Map)->Value = Value;
+      Table->Symbols[Id].Value = 0;
+      Table->Symbols[Id].Defined = false;
+      Table->Symbols[Id].Exported = false;
+      Table->Symbols[Id].Section = 0;
    }
 }
 
-static string Read_Entire_File(arena *Arena, char *Path)
+static lookup_result Lookup_Symbol(symbol_table *Table, symbol_id Id)
 {
-   string Result = {0};
+   lookup_result Result = {0};
+   if(Id)
+   {
+      Result.Value = Table->Symbols[Id].Value;
+      Result.Found = Table->Symbols[Id].Defined;
+   }
 
-   FILE *File = fopen(Path, "rb");
-   if(File)
+   return(Result);
+}
+
+// NOTE: Serialized formats (the cache and object files) are sequences of
+// records padded to eight bytes, so that every record can be read in place.
+
+typedef struct {
+   u8 *At;
+   u8 *End;
+} byte_cursor;
+
+static index Align_8(index Size)
+{
+   index Result = (Size + 7) & ~(index)7;
+   return(Result);
+}
+
+static void *Read_Bytes(byte_cursor *Cursor, index Size)
+{
+   // NOTE: Returns null if the data is truncated, which callers treat as a
+   // corrupt file.
+   void *Result = 0;
+   index Remaining = Cursor->End - Cursor->At;
+   if(Size >= 0 && Size <= Remaining && Align_8(Size) <= Remaining)
    {
-      Result.Data = Arena->Base + Arena->Used;
+      Result = Cursor->At;
+      Cursor->At += Align_8(Size);
+   }
 
-      index Available_Space = Arena->Size - Arena->Used;
-      Result.Length = fread(Result.Data, 1, Available_Space, File);
-      Allocate_Size(Arena, Result.Length);
+   return(Result);
+}
 
-      if(Result.Length == Available_Space)
+static void *Read_Length_Bytes(byte_cursor *Cursor, u64 Length)
+{
+   // NOTE: For lengths stored in a file, which are checked against what's left
+   // before they're narrowed to an index.
+   void *Result = 0;
+   if(Length <= (u64)(Cursor->End - Cursor->At))
+   {
+      Result = Read_Bytes(Cursor, (index)Length);
+   }
+
+   return(Result);
+}
+
+static void Push_Bytes(arena *Arena, void *Data, index Size)
+{
+   u8 *Destination = Allocate_Size_Aligned(Arena, Align_8(Size), 8);
+   memcpy(Destination, Data, Size);
+}
+
+static string Read_Entire_Stream(arena *Arena, FILE *File, char *Path)
+{
+   // NOTE: Read in chunks, committing arena pages as the data grows.
+   string Result = {0};
+   Result.Data = Arena->Base + Arena->Used;
+
+   index Chunk_Size = 1024 * 1024;
+   while(1)
+   {
+      index Available_Space = Arena->Size - Arena->Used;
+      if(Available_Space == 0)
       {
          Report_Error(0, "File exhausted arena memory, likely truncating \"%s\".", Path);
+         break;
+      }
+
+      index Read_Size = (Chunk_Size < Available_Space) ? Chunk_Size : Available_Space;
+      if(!Commit_Arena(Arena, Arena->Used + Read_Size))
+      {
+         Report_Error(0, "Failed to commit memory while reading \"%s\".", Path);
+         break;
       }
+
+      index Bytes_Read = fread(Arena->Base + Arena->Used, 1, Read_Size, File);
+      Arena->Used += Bytes_Read;
+      Result.Length += Bytes_Read;
+
+      if(Bytes_Read < Read_Size)
+      {
+         break;
+      }
+   }
+   Update_Arena_Marks(Arena);
+
+   return(Result);
+}
+
+static string Read_Entire_File(arena *Arena, char *Path)
+{
+   string Result = {0};
+
+   FILE *File = fopen(Path, "rb");
+   if(File)
+   {
+      Result = Read_Entire_Stream(Arena, File, Path);
+      fclose(File);
    }
    else
    {
@@ -366,16 +690,83 @@ static string Read_Entire_File(arena *Arena, char *Path)
    return(Result);
 }
 
-static bool Write_Entire_File(u8 *Memory, index Size, char *Path)
-{
-   bool Result = false;
+typedef struct {
+   string Contents;
+   bool Mapped;
+} input_file;
 
-   FILE *File = fopen(Path, "wb");
-   if(File)
+static input_file Open_Input_File(arena *Arena, char *Path, bool Allow_Mapping)
+{
+   // NOTE: Regular files are mapped read-only and used in place, since every
+   // later pass only takes string views into the source. Pipes, character
+   // devices and stdin ("-") can't be mapped, so they fall back to copying
+   // into the arena. So do callers that pass Allow_Mapping = false, e.g.
+   // --watch, where an editor may truncate the file while it is mapped and
+   // reading past the new end raises SIGBUS.
+   input_file Result = {0};
+
+   if(Path[0] == '-' && Path[1] == 0)
    {
-      size_t Bytes_Written = fwrite(Memory, 1, Size, File);
-      Result = (Bytes_Written == (size_t)Size);
+      Result.Contents = Read_Entire_Stream(Arena, stdin, Path);
+   }
+   else
+   {
+      int File = open(Path, O_RDONLY);
+      if(File >= 0)
+      {
+         struct stat Status;
+         if(fstat(File, &Status) == 0 && S_ISREG(Status.st_mode))
+         {
+            if(Allow_Mapping && Status.st_size > 0)
+            {
+               void *Mapping = mmap(0, Status.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+               if(Mapping != MAP_FAILED)
+               {
+                  madvise(Mapping, Status.st_size, MADV_SEQUENTIAL);
+
+                  Result.Contents.Data = Mapping;
+                  Result.Contents.Length = Status.st_size;
+                  Result.Mapped = true;
+               }
+            }
+            close(File);
+
+            if(!Result.Mapped && Status.st_size > 0)
+            {
+               Result.Contents = Read_Entire_File(Arena, Path);
+            }
+         }
+         else
+         {
+            FILE *Stream = fdopen(File, "rb");
+            if(Stream)
+            {
+               Result.Contents = Read_Entire_Stream(Arena, Stream, Path);
+               fclose(Stream);
+            }
+            else
+            {
+               close(File);
+               Report_Error(0, "Failed to open file \"%s\".", Path);
+            }
+         }
+      }
+      else
+      {
+         Report_Error(0, "Failed to open file \"%s\".", Path);
+      }
    }
 
    return(Result);
 }
+
+static void Close_Input_File(input_file *File)
+{
+   if(File->Mapped)
+   {
+      munmap(File->Contents.Data, File->Contents.Length);
+   }
+
+   File->Contents = (string){0};
+   File->Mapped = false;
+}
@@ -0,0 +1,62 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Each backend's MNEMONICS_LIST is turned into a perfect hash table at
+// build time by generate_mnemonic_hash.c. A mnemonic of up to 8 characters is
+// packed into a u64 key, and a multiply-shift sends every mnemonic in the list
+// to its own slot. Looking one up costs a multiply and a single key compare,
+// with no allocation or startup work.
+//
+// A backend opts in by keeping its list in mnemonics_<arch>.h and adding its
+// architecture to the generator rule in the Makefile. The generated header
+// defines Mnemonic_Hash_<arch> in terms of the backend's MNEMONIC_* enum.
+
+typedef struct {
+   u64 Key;
+   u32 Mnemonic;
+} mnemonic_hash_entry;
+
+typedef struct {
+   u64 Multiplier;
+   int Shift;
+   mnemonic_hash_entry *Entries;
+} mnemonic_hash;
+
+typedef struct {
+   u32 Mnemonic;
+   bool Found;
+} mnemonic_lookup;
+
+static u64 Pack_Mnemonic(string Mnemonic)
+{
+   // NOTE: Anything that can't be packed produces the empty key, which never
+   // matches a table entry.
+   u64 Result = 0;
+   if(Mnemonic.Length <= 8)
+   {
+      for(index Index = 0; Index < Mnemonic.Length; ++Index)
+      {
+         Result |= (u64)Mnemonic.Data[Index] << (Index * 8);
+      }
+   }
+
+   return(Result);
+}
+
+static u64 Mnemonic_Hash_Slot(u64 Key, u64 Multiplier, int Shift)
+{
+   u64 Result = (Key * Multiplier) >> Shift;
+   return(Result);
+}
+
+static mnemonic_lookup Lookup_Mnemonic(mnemonic_hash *Hash, string Mnemonic)
+{
+   mnemonic_lookup Result = {0};
+
+   u64 Key = Pack_Mnemonic(Mnemonic);
+   mnemonic_hash_entry *Entry = Hash->Entries + Mnemonic_Hash_Slot(Key, Hash->Multiplier, Hash->Shift);
+
+   Result.Found = (Key && Entry->Key == Key);
+   Result.Mnemonic = Entry->Mnemonic;
+
+   return(Result);
+}
@@ -0,0 +1,27 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Kept apart from architecture_6502.c so generate_mnemonic_hash.c can
+// build the mnemonic lookup table from the same list.
+
+#define MNEMONICS_LIST                          \
+   X(ora) X(and) X(eor) X(adc)                  \
+   X(sta) X(lda) X(cmp) X(sbc)                  \
+                                                \
+   X(asl) X(rol) X(lsr) X(ror)                  \
+   X(stx) X(ldx) X(dec) X(inc)                  \
+                                                \
+   X(bit) X(jmp) X(sty) X(ldy)                  \
+   X(cpy) X(cpx)                                \
+                                                \
+   X(bpl) X(bmi) X(bvc) X(bvs)                  \
+   X(bcc) X(bcs) X(bne) X(beq)                  \
+                                                \
+   X(jsr)                                       \
+                                                \
+   X(brk) X(rti) X(rts) X(php)                  \
+   X(plp) X(pha) X(pla) X(dey)                  \
+   X(tay) X(iny) X(inx) X(clc)                  \
+   X(sec) X(cli) X(sei) X(tya)                  \
+   X(clv) X(cld) X(sed) X(txa)                  \
+   X(txs) X(tax) X(tsx) X(dex)                  \
+   X(nop)
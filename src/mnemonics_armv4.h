@@ -0,0 +1,24 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Kept apart from architecture_armv4.c so generate_mnemonic_hash.c can
+// build the mnemonic lookup table from the same list. Only base mnemonics are
+// listed, condition and flag suffixes are split off before lookup. The
+// data-processing mnemonics come first, in opcode order, so that their enum
+// values are their opcodes. The shift mnemonics follow in arm_shift order.
+
+#define MNEMONIC_PREFIX ARMV4_MNEMONIC_
+
+#define MNEMONICS_LIST                          \
+   X(and) X(eor) X(sub) X(rsb)                  \
+   X(add) X(adc) X(sbc) X(rsc)                  \
+   X(tst) X(teq) X(cmp) X(cmn)                  \
+   X(orr) X(mov) X(bic) X(mvn)                  \
+                                                \
+   X(b) X(bl)                                   \
+                                                \
+   X(ldr) X(str) X(ldrb) X(strb)                \
+   X(ldrh) X(strh) X(ldrsb) X(ldrsh)            \
+   X(ldmia) X(stmia) X(push) X(pop)             \
+                                                \
+   X(bx) X(swi) X(mul) X(neg)                   \
+   X(lsl) X(lsr) X(asr) X(ror)
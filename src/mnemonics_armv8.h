@@ -0,0 +1,74 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Kept apart from architecture_armv8.c so generate_mnemonic_hash.c can
+// build the mnemonic lookup table from the same list. Condition codes of b.cond
+// are split off before lookup. Mnemonics that share an encoding are listed
+// together in the order of the field that tells them apart, so the encoders
+// can compute that field from the enum value, e.g. add, adds, sub, subs for
+// the op and S bits, or and, orr, eor, ands for opc. The Advanced SIMD
+// mnemonics follow the scalar ones, and the scalar floating-point ones among
+// them are in opcode order as well.
+
+#define MNEMONIC_PREFIX ARMV8_MNEMONIC_
+
+#define MNEMONICS_LIST                                              \
+   X(add) X(adds) X(sub) X(subs)                                    \
+   X(cmn) X(cmp) X(neg) X(negs)                                     \
+   X(and) X(orr) X(eor) X(ands)                                     \
+   X(bic) X(orn) X(eon) X(bics)                                     \
+   X(tst) X(mvn) X(mov)                                             \
+   X(movn) X(movz) X(movk)                                          \
+                                                                    \
+   X(madd) X(msub) X(mul) X(mneg)                                   \
+   X(smaddl) X(smsubl) X(umaddl) X(umsubl)                          \
+   X(smull) X(smnegl) X(umull) X(umnegl)                            \
+   X(smulh) X(umulh)                                                \
+   X(udiv) X(sdiv) X(lslv) X(lsrv) X(asrv) X(rorv)                  \
+   X(lsl) X(lsr) X(asr) X(ror)                                      \
+   X(rbit) X(rev16) X(rev32) X(rev) X(clz) X(cls)                   \
+                                                                    \
+   X(sbfm) X(bfm) X(ubfm)                                           \
+   X(sbfx) X(bfxil) X(ubfx)                                         \
+   X(sbfiz) X(bfi) X(ubfiz)                                         \
+   X(sxtb) X(sxth) X(sxtw) X(uxtb) X(uxth)                          \
+   X(extr)                                                          \
+                                                                    \
+   X(csel) X(csinc) X(csinv) X(csneg)                               \
+   X(cset) X(csetm) X(cinc) X(cinv) X(cneg)                         \
+   X(ccmn) X(ccmp)                                                  \
+   X(adc) X(adcs) X(sbc) X(sbcs) X(ngc) X(ngcs)                     \
+   X(adr) X(adrp)                                                   \
+                                                                    \
+   X(strb) X(ldrb) X(ldrsb) X(strh) X(ldrh) X(ldrsh)                \
+   X(str) X(ldr) X(ldrsw)                                           \
+   X(sturb) X(ldurb) X(ldursb) X(sturh) X(ldurh) X(ldursh)          \
+   X(stur) X(ldur) X(ldursw)                                        \
+   X(stp) X(ldp) X(ldpsw)                                           \
+                                                                    \
+   X(b) X(bl) X(br) X(blr) X(ret)                                   \
+   X(cbz) X(cbnz) X(tbz) X(tbnz)                                    \
+   X(nop) X(svc) X(brk) X(hlt)                                      \
+                                                                    \
+   X(mla) X(mls) X(cmeq) X(cmtst) X(cmgt) X(cmge) X(cmhi) X(cmhs)   \
+   X(cmle) X(cmlt) X(cmls) X(cmlo)                                  \
+   X(smax) X(smin) X(umax) X(umin) X(addp) X(sabd) X(uabd)          \
+   X(sqadd) X(uqadd) X(sqsub) X(uqsub) X(sshl) X(ushl)              \
+   X(bsl) X(bit) X(bif)                                             \
+   X(abs) X(cnt) X(not) X(rev64)                                    \
+   X(addv) X(smaxv) X(sminv) X(umaxv) X(uminv)                      \
+   X(saddlv) X(uaddlv) X(saddlp) X(uaddlp) X(sadalp) X(uadalp)      \
+   X(shl) X(sshr) X(ushr) X(ssra) X(usra)                           \
+   X(uzp1) X(trn1) X(zip1) X(uzp2) X(trn2) X(zip2)                  \
+   X(ext) X(tbl) X(tbx)                                             \
+   X(dup) X(ins) X(umov) X(smov) X(movi)                            \
+                                                                    \
+   X(fmul) X(fdiv) X(fadd) X(fsub)                                  \
+   X(fmax) X(fmin) X(fmaxnm) X(fminnm)                              \
+   X(fmov) X(fabs) X(fneg) X(fsqrt)                                 \
+   X(scvtf) X(ucvtf) X(fcvtzs) X(fcvtzu)                            \
+   X(fcmp) X(fcmpe) X(fcvt)                                         \
+   X(fmla) X(fmls) X(fabd) X(faddp) X(fcmeq) X(fcmge) X(fcmgt)      \
+   X(fcmle) X(fcmlt) X(fmaxv) X(fminv) X(fmaxnmv) X(fminnmv)        \
+   X(frintn) X(frintm) X(frintp) X(frintz) X(frecpe) X(frsqrte)     \
+                                                                    \
+   X(ld1) X(ld2) X(ld3) X(ld4) X(st1) X(st2) X(st3) X(st4)
@@ -0,0 +1,460 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: Relocatable object files, produced with -c, and the linker that
+// combines them, run with --link <output> <objects...>.
+//
+// An object file records each section's extent as assembled, the bytes of each
+// output segment, every symbol in the file and every relocation that was left
+// for the linker. Labels are never folded into instructions when producing an
+// object, so every reference to one is a relocation.
+//
+// The linker merges sections by name in the order they are first seen. The
+// first object's contribution to a section stays where it was assembled, so a
+// #location in that file still picks the section's origin, and every later
+// contribution is placed directly after the previous one. Labels move with
+// their section, while constants are absolute. Symbols resolve within their
+// own object first, then against the symbols other objects #export.
+
+#define OBJECT_MAGIC 0x31304A424F4D5341ull // "ASMOBJ01"
+
+typedef struct {
+   u64 Magic;
+   u64 Architecture_Length;
+   u64 Source_Path_Length;
+   u64 Section_Count;
+   u64 Segment_Count;
+   u64 Symbol_Count;
+   u64 Relocation_Count;
+} object_header; // Followed by the architecture name and source path.
+
+typedef struct {
+   u64 Start;
+   u64 End;
+   u64 Name_Length;
+} object_section; // Followed by the section name.
+
+typedef struct {
+   u64 Section;
+   u64 Address;
+   u64 Length;
+} object_segment; // Followed by the segment's bytes.
+
+typedef struct {
+   u64 Value;
+   u32 Section; // Section index plus one for labels, zero for absolute values.
+   u8 Defined;
+   u8 Exported;
+   u8 Padding[2];
+   u64 Name_Length;
+} object_symbol; // Followed by the symbol name.
+
+typedef struct {
+   u32 Symbol; // Index into the object's symbols.
+   u32 Section;
+   u64 Address;
+   s32 Line_Number;
+   u8 Width;
+   u8 Kind;
+   u8 Endianness;
+   u8 Padding;
+} object_relocation;
+
+static bool Write_Object_File(assembler_context *Context, char *Path)
+{
+   arena *Arena = &Context->Arena;
+   temporary_memory Scratch = Begin_Temporary_Memory(Arena);
+
+   Context->Sections[Context->Current_Section].Location = Context->Current_Address;
+
+   // NOTE: Segments are kept newest first, and are written oldest first so
+   // that later writes to the same address still win when linked.
+   index Segment_Count = 0;
+   for(output_segment *Segment = Context->Output.Segments; Segment; Segment = Segment->Next)
+   {
+      Segment_Count++;
+   }
+
+   output_segment **Segments = Allocate(Arena, output_segment *, Segment_Count);
+   index Segment_Index = Segment_Count;
+   for(output_segment *Segment = Context->Output.Segments; Segment; Segment = Segment->Next)
+   {
+      Segments[--Segment_Index] = Segment;
+   }
+
+   object_header *Header = Allocate(Arena, object_header, 1);
+   u8 *Begin = (u8 *)Header;
+
+   string Architecture = (Context->Architecture) ? From_C_String(Context->Architecture->Name) : (string){0};
+   Header->Magic = OBJECT_MAGIC;
+   Header->Architecture_Length = Architecture.Length;
+   Header->Source_Path_Length = Context->Input_File_Path.Length;
+   Push_Bytes(Arena, Architecture.Data, Architecture.Length);
+   Push_Bytes(Arena, Context->Input_File_Path.Data, Context->Input_File_Path.Length);
+
+   Header->Section_Count = Context->Section_Count;
+   for(int Section_Index = 0; Section_Index < Context->Section_Count; ++Section_Index)
+   {
+      output_section *Section = Context->Sections + Section_Index;
+      object_section Record = {Section->Start, Section->Location, Section->Name.Length};
+      Push_Bytes(Arena, &Record, sizeof(Record));
+      Push_Bytes(Arena, Section->Name.Data, Section->Name.Length);
+   }
+
+   Header->Segment_Count = Segment_Count;
+   for(Segment_Index = 0; Segment_Index < Segment_Count; ++Segment_Index)
+   {
+      output_segment *Segment = Segments[Segment_Index];
+      object_segment Record = {Segment->Section, Segment->Address, Segment->Length};
+      Push_Bytes(Arena, &Record, sizeof(Record));
+      Push_Bytes(Arena, Segment->Data, Segment->Length);
+   }
+
+   symbol_table *Symbols = &Context->Symbols;
+   Header->Symbol_Count = Symbols->Symbol_Count;
+   for(symbol_id Id = 1; Id <= Symbols->Symbol_Count; ++Id)
+   {
+      symbol *Symbol = Symbols->Symbols + Id;
+      if(Symbol->Exported && !Symbol->Defined)
+      {
+         Report_Error(Context, "Exported symbol \"%.*s\" is never defined.", SF(Symbol->Name));
+      }
+
+      object_symbol Record = {0};
+      Record.Value = Symbol->Value;
+      Record.Section = Symbol->Section;
+      Record.Defined = Symbol->Defined;
+      Record.Exported = Symbol->Exported;
+      Record.Name_Length = Symbol->Name.Length;
+      Push_Bytes(Arena, &Record, sizeof(Record));
+      Push_Bytes(Arena, Symbol->Name.Data, Symbol->Name.Length);
+   }
+
+   relocation_table *Relocations = &Context->Relocations;
+   Header->Relocation_Count = 0;
+   for(index Relocation_Index = 0; Relocation_Index < Relocations->Count; ++Relocation_Index)
+   {
+      relocation *Relocation = Relocations->Relocations + Relocation_Index;
+
+      // NOTE: The linker patches the field inside its section's segments, so
+      // a field that isn't in one can't be linked.
+      if(!Find_Output(&Context->Output, Relocation->Section, Relocation->Address, Relocation->Width))
+      {
+         Context->Current_Line_Number = Relocation->Line_Number;
+         Report_Error(Context, "Relocation for \"%.*s\" is outside the output of its section.",
+                      SF(Symbols->Symbols[Relocation->Symbol].Name));
+         continue;
+      }
+
+      object_relocation Record = {0};
+      Record.Symbol = Relocation->Symbol - 1;
+      Record.Section = Relocation->Section;
+      Record.Address = Relocation->Address;
+      Record.Line_Number = Relocation->Line_Number;
+      Record.Width = Relocation->Width;
+      Record.Kind = Relocation->Kind;
+      Record.Endianness = Relocation->Endianness;
+      Push_Bytes(Arena, &Record, sizeof(Record));
+      Header->Relocation_Count++;
+   }
+
+   bool Result = false;
+   FILE *File = fopen(Path, "wb");
+   if(File)
+   {
+      index Size = (Arena->Base + Arena->Used) - Begin;
+      Result = (fwrite(Begin, 1, Size, File) == (size_t)Size);
+      Result = (fclose(File) == 0) && Result;
+   }
+
+   End_Temporary_Memory(Scratch);
+
+   return(Result);
+}
+
+typedef struct {
+   string Source_Path;
+   object_section **Sections;
+   index *Section_Delta; // How far each section moves when laid out.
+   int *Section_Map;     // Index of each section in the linked output.
+   object_segment **Segments;
+   object_symbol **Symbols;
+   string *Symbol_Names;
+   object_relocation *Relocations;
+   object_header *Header;
+} linked_object;
+
+static bool Load_Object_File(arena *Arena, char *Path, linked_object *Object, architecture **Linked_Architecture)
+{
+   bool Result = false;
+   bool Reported = false;
+
+   Allocate_Size_Aligned(Arena, 0, 8);
+   string Contents = Read_Entire_File(Arena, Path);
+
+   byte_cursor Cursor = {Contents.Data, Contents.Data + Contents.Length};
+   object_header *Header = Read_Bytes(&Cursor, sizeof(object_header));
+   if(Header && Header->Magic == OBJECT_MAGIC)
+   {
+      string Architecture = {Read_Bytes(&Cursor, Header->Architecture_Length), Header->Architecture_Length};
+      Object->Source_Path.Data = Read_Bytes(&Cursor, Header->Source_Path_Length);
+      Object->Source_Path.Length = Header->Source_Path_Length;
+      Object->Header = Header;
+
+      // NOTE: Objects without an architecture only hold data. Every other
+      // object must match the first one that names an architecture.
+      bool Ok = ((Architecture.Data || Header->Architecture_Length == 0) && Object->Source_Path.Data);
+      architecture *Object_Architecture = 0;
+      if(Ok && Architecture.Length)
+      {
+         Object_Architecture = Find_Architecture(Architecture);
+         if(!Object_Architecture)
+         {
+            Report_Error(0, "Object file \"%s\" was assembled for unsupported architecture %.*s.", Path, SF(Architecture));
+            Reported = true;
+            Ok = false;
+         }
+         else if(!*Linked_Architecture)
+         {
+            *Linked_Architecture = Object_Architecture;
+         }
+         else if(*Linked_Architecture != Object_Architecture)
+         {
+            Report_Error(0, "Object file \"%s\" was assembled for %s, not %s.", Path,
+                         Object_Architecture->Name, (*Linked_Architecture)->Name);
+            Reported = true;
+            Ok = false;
+         }
+      }
+      u32 Relocation_Kinds = (Object_Architecture) ? Object_Architecture->Relocation_Kinds : RELOCATION_KIND_BIT(RELOCATION_ABSOLUTE);
+
+      Ok = Ok && (Header->Section_Count > 0 && Header->Section_Count <= MAX_SECTION_COUNT);
+      if(Ok)
+      {
+         Object->Sections = Allocate(Arena, object_section *, Header->Section_Count);
+         Object->Section_Delta = Allocate(Arena, index, Header->Section_Count);
+         Object->Section_Map = Allocate(Arena, int, Header->Section_Count);
+         Object->Segments = Allocate(Arena, object_segment *, Header->Segment_Count);
+         Object->Symbols = Allocate(Arena, object_symbol *, Header->Symbol_Count);
+         Object->Symbol_Names = Allocate(Arena, string, Header->Symbol_Count);
+      }
+
+      for(u64 Section_Index = 0; Ok && Section_Index < Header->Section_Count; ++Section_Index)
+      {
+         object_section *Section = Read_Bytes(&Cursor, sizeof(object_section));
+         Ok = (Section && Read_Bytes(&Cursor, Section->Name_Length));
+         Object->Sections[Section_Index] = Section;
+      }
+
+      for(u64 Segment_Index = 0; Ok && Segment_Index < Header->Segment_Count; ++Segment_Index)
+      {
+         object_segment *Segment = Read_Bytes(&Cursor, sizeof(object_segment));
+         Ok = (Segment && Segment->Section < Header->Section_Count && Read_Bytes(&Cursor, Segment->Length));
+         Object->Segments[Segment_Index] = Segment;
+      }
+
+      for(u64 Symbol_Index = 0; Ok && Symbol_Index < Header->Symbol_Count; ++Symbol_Index)
+      {
+         object_symbol *Symbol = Read_Bytes(&Cursor, sizeof(object_symbol));
+         Ok = (Symbol && Symbol->Section <= Header->Section_Count);
+         if(Ok)
+         {
+            Object->Symbols[Symbol_Index] = Symbol;
+            Object->Symbol_Names[Symbol_Index].Data = Read_Bytes(&Cursor, Symbol->Name_Length);
+            Object->Symbol_Names[Symbol_Index].Length = Symbol->Name_Length;
+            Ok = (Object->Symbol_Names[Symbol_Index].Data != 0);
+         }
+      }
+
+      Object->Relocations = Read_Bytes(&Cursor, sizeof(object_relocation) * Header->Relocation_Count);
+      Ok = Ok && (Object->Relocations || Header->Relocation_Count == 0);
+      for(u64 Relocation_Index = 0; Ok && Relocation_Index < Header->Relocation_Count; ++Relocation_Index)
+      {
+         object_relocation *Relocation = Object->Relocations + Relocation_Index;
+         Ok = (Relocation->Symbol < Header->Symbol_Count && Relocation->Section < Header->Section_Count &&
+               Relocation->Kind < RELOCATION_KIND_COUNT && (Relocation_Kinds & RELOCATION_KIND_BIT(Relocation->Kind)) &&
+               Relocation->Width <= 8);
+      }
+
+      Result = Ok;
+   }
+
+   if(!Result && !Reported && Contents.Data)
+   {
+      Report_Error(0, "\"%s\" is not a valid object file.", Path);
+   }
+
+   return(Result);
+}
+
+static u64 Linked_Symbol_Value(linked_object *Object, object_symbol *Symbol)
+{
+   u64 Result = Symbol->Value;
+   if(Symbol->Section)
+   {
+      Result += Object->Section_Delta[Symbol->Section - 1];
+   }
+
+   return(Result);
+}
+
+static bool Link_Objects(assembler_context *Context, char **Paths, int Path_Count, char *Output_Path)
+{
+   arena *Arena = &Context->Arena;
+   int Error_Count = Context->Error_Count;
+
+   linked_object *Objects = Allocate(Arena, linked_object, Path_Count);
+   architecture *Architecture = 0;
+   bool Loaded = true;
+   for(int Object_Index = 0; Object_Index < Path_Count; ++Object_Index)
+   {
+      Loaded = Load_Object_File(Arena, Paths[Object_Index], Objects + Object_Index, &Architecture) && Loaded;
+   }
+
+   if(Loaded)
+   {
+      // NOTE: Lay out sections. The location of each merged section is used as
+      // the cursor where the next contribution goes.
+      Context->Section_Count = 0;
+      for(int Object_Index = 0; Object_Index < Path_Count; ++Object_Index)
+      {
+         linked_object *Object = Objects + Object_Index;
+         for(u64 Section_Index = 0; Section_Index < Object->Header->Section_Count; ++Section_Index)
+         {
+            object_section *Section = Object->Sections[Section_Index];
+            string Name = {(u8 *)(Section + 1), Section->Name_Length};
+
+            int Linked_Index = 0;
+            while(Linked_Index < Context->Section_Count && !Equals(Context->Sections[Linked_Index].Name, Name))
+            {
+               Linked_Index++;
+            }
+
+            output_section *Linked = Context->Sections + Linked_Index;
+            if(Linked_Index == Context->Section_Count)
+            {
+               if(Context->Section_Count == MAX_SECTION_COUNT)
+               {
+                  Report_Error(0, "Too many sections, the limit is %d.", MAX_SECTION_COUNT);
+                  return(false);
+               }
+
+               Linked->Name = Name;
+               Linked->Start = Section->Start;
+               Linked->Location = Section->Start;
+               Context->Section_Count++;
+            }
+
+            Object->Section_Map[Section_Index] = Linked_Index;
+            Object->Section_Delta[Section_Index] = Linked->Location - Section->Start;
+            Linked->Location += Section->End - Section->Start;
+         }
+      }
+
+      // NOTE: Gather exported symbols.
+      // For exports, the symbol's section holds the exporting object instead.
+      symbol_table *Exports = &Context->Symbols;
+      for(int Object_Index = 0; Object_Index < Path_Count; ++Object_Index)
+      {
+         linked_object *Object = Objects + Object_Index;
+         for(u64 Symbol_Index = 0; Symbol_Index < Object->Header->Symbol_Count; ++Symbol_Index)
+         {
+            object_symbol *Symbol = Object->Symbols[Symbol_Index];
+            if(Symbol->Exported && Symbol->Defined)
+            {
+               string Name = Object->Symbol_Names[Symbol_Index];
+               symbol_id Id = Intern_Symbol(Exports, Name);
+               if(Exports->Symbols[Id].Defined)
+               {
+                  Report_Error(0, "\"%.*s\" is exported by both \"%s\" and \"%s\".",
+                               SF(Name), Paths[Exports->Symbols[Id].Section], Paths[Object_Index]);
+               }
+               else
+               {
+                  Define_Symbol(Exports, Id, Linked_Symbol_Value(Object, Symbol));
+                  Exports->Symbols[Id].Section = Object_Index;
+               }
+            }
+         }
+      }
+
+      // NOTE: Copy each object's bytes to their linked addresses.
+      for(int Object_Index = 0; Object_Index < Path_Count; ++Object_Index)
+      {
+         linked_object *Object = Objects + Object_Index;
+         for(u64 Segment_Index = 0; Segment_Index < Object->Header->Segment_Count; ++Segment_Index)
+         {
+            object_segment *Segment = Object->Segments[Segment_Index];
+            Context->Current_Section = Object->Section_Map[Segment->Section];
+
+            index Address = Segment->Address + Object->Section_Delta[Segment->Section];
+            u8 *Destination = Reserve_Output(Context, Address, Segment->Length);
+            if(Segment->Length)
+            {
+               memcpy(Destination, Segment + 1, Segment->Length);
+            }
+         }
+      }
+
+      // NOTE: Apply relocations, with the source file and line recorded in
+      // the object for diagnostics.
+      for(int Object_Index = 0; Object_Index < Path_Count; ++Object_Index)
+      {
+         linked_object *Object = Objects + Object_Index;
+         Context->Input_File_Path = Object->Source_Path;
+
+         for(u64 Relocation_Index = 0; Relocation_Index < Object->Header->Relocation_Count; ++Relocation_Index)
+         {
+            object_relocation *Record = Object->Relocations + Relocation_Index;
+            object_symbol *Symbol = Object->Symbols[Record->Symbol];
+            string Name = Object->Symbol_Names[Record->Symbol];
+            Context->Current_Line_Number = Record->Line_Number;
+
+            lookup_result Target = {0};
+            if(Symbol->Defined)
+            {
+               Target.Value = Linked_Symbol_Value(Object, Symbol);
+               Target.Found = true;
+            }
+            else
+            {
+               Target = Lookup_Symbol(Exports, Intern_Symbol(Exports, Name));
+            }
+
+            relocation Relocation = {0};
+            Relocation.Line_Number = Record->Line_Number;
+            Relocation.Address = Record->Address + Object->Section_Delta[Record->Section];
+            Relocation.Width = Record->Width;
+            Relocation.Kind = Record->Kind;
+            Relocation.Endianness = Record->Endianness;
+            Relocation.Section = (u8)Object->Section_Map[Record->Section];
+
+            u8 *Destination = Find_Output(&Context->Output, Relocation.Section, Relocation.Address, Relocation.Width);
+            if(!Destination)
+            {
+               Report_Error(Context, "Relocation for \"%.*s\" is outside of the object's output.", SF(Name));
+            }
+            else if(!Target.Found)
+            {
+               Report_Error(Context, "Failed to resolve \"%.*s\".", SF(Name));
+            }
+            else
+            {
+               relocation_status Status = Encode_Relocation(Destination, &Relocation, Target.Value);
+               if(Status != RELOCATION_FITS)
+               {
+                  Report_Error(Context, Relocation_Status_Messages[Status], SF(Name));
+               }
+            }
+         }
+      }
+   }
+
+   bool Result = Loaded && (Context->Error_Count == Error_Count);
+   if(Result && !Write_Output_Image(Context, Output_Path))
+   {
+      Report_Error(0, "Failed to write to output file \"%s\".", Output_Path);
+      Result = false;
+   }
+
+   return(Result);
+}
@@ -0,0 +1,216 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: With --stats, one JSON document is printed to stdout once every file
+// is assembled:
+//
+//    {
+//       "files": [{"path": ..., <statistics>}, ...],
+//       "total": {"wall_seconds": ..., <statistics>}
+//    }
+//
+// where the statistics are the seconds spent in each pass, the size of the
+// source, the arena high-water mark, the symbol count and mean probe distance,
+// relocation outcomes and a histogram of instruction mnemonics. Files appear
+// in argument order, and totals sum over files except for the arena peak,
+// which is the largest of any file.
+
+typedef enum {
+   PASS_READ,
+   PASS_TOKENIZE,
+   PASS_ENCODE,
+   PASS_RELOCATE,
+   PASS_WRITE,
+
+   PASS_COUNT,
+} assembler_pass;
+
+static char *Pass_Names[PASS_COUNT] =
+{
+   [PASS_READ]     = "read",
+   [PASS_TOKENIZE] = "tokenize",
+   [PASS_ENCODE]   = "encode",
+   [PASS_RELOCATE] = "relocate",
+   [PASS_WRITE]    = "write",
+};
+
+typedef struct file_stats file_stats;
+struct file_stats
+{
+   double Seconds[PASS_COUNT];
+   index Source_Bytes;
+   index Line_Count;
+   index Instruction_Count;
+   index Arena_Peak;
+   index Symbol_Count;
+   u64 Probe_Distance;
+   index Relocation_Count;
+   index Unresolved_Count;
+   index Out_Of_Range_Count;
+
+   message_buffer Json; // The file's entry, written before its context resets.
+};
+
+static pthread_mutex_t Stats_Mutex = PTHREAD_MUTEX_INITIALIZER;
+static file_stats Total_Stats;
+static symbol_table Total_Histogram;
+
+#define HISTOGRAM_ARENA_SIZE ((index)1024 * 1024 * 1024)
+
+static double Stats_Clock(void)
+{
+   struct timespec Time;
+   clock_gettime(CLOCK_MONOTONIC, &Time);
+   return(Time.tv_sec + Time.tv_nsec * 1e-9);
+}
+
+static void Count_Mnemonic(assembler_context *Context, source_code_line *Line)
+{
+   if(Context->Stats && Line->Instruction.Length)
+   {
+      string Mnemonic = Cut_Whitespace(Line->Instruction).Before;
+      symbol_table *Histogram = &Context->Mnemonic_Histogram;
+      symbol_id Id = Intern_Symbol(Histogram, Mnemonic);
+      Histogram->Symbols[Id].Value++;
+      Context->Stats->Instruction_Count++;
+   }
+}
+
+static void Append_Format(message_buffer *Buffer, char *Format, ...)
+{
+   va_list Arguments;
+   va_start(Arguments, Format);
+   Append_Message(Buffer, Format, Arguments);
+   va_end(Arguments);
+}
+
+static void Append_Json_String(message_buffer *Buffer, string String)
+{
+   Append_Format(Buffer, "\"");
+   for(index Index = 0; Index < String.Length; ++Index)
+   {
+      u8 Character = String.Data[Index];
+      if(Character == '"' || Character == '\\')
+      {
+         Append_Format(Buffer, "\\%c", Character);
+      }
+      else if(Character < ' ')
+      {
+         Append_Format(Buffer, "\\u%04x", Character);
+      }
+      else
+      {
+         Append_Format(Buffer, "%c", Character);
+      }
+   }
+   Append_Format(Buffer, "\"");
+}
+
+static void Append_Stats_Json(message_buffer *Buffer, file_stats *Stats, symbol_table *Histogram)
+{
+   Append_Format(Buffer, "\"seconds\": {");
+   for(int Pass = 0; Pass < PASS_COUNT; ++Pass)
+   {
+      Append_Format(Buffer, "%s\"%s\": %.6f", (Pass) ? ", " : "", Pass_Names[Pass], Stats->Seconds[Pass]);
+   }
+   Append_Format(Buffer, "}, ");
+
+   double Mean_Probe_Distance = (Stats->Symbol_Count) ? ((double)Stats->Probe_Distance / Stats->Symbol_Count) : 0;
+   Append_Format(Buffer, "\"source_bytes\": %td, \"lines\": %td, \"arena_peak\": %td, ",
+                 Stats->Source_Bytes, Stats->Line_Count, Stats->Arena_Peak);
+   Append_Format(Buffer, "\"symbols\": %td, \"mean_probe_distance\": %.4f, ",
+                 Stats->Symbol_Count, Mean_Probe_Distance);
+   Append_Format(Buffer, "\"relocations\": {\"total\": %td, \"resolved\": %td, \"unresolved\": %td, \"out_of_range\": %td}, ",
+                 Stats->Relocation_Count, Stats->Relocation_Count - Stats->Unresolved_Count - Stats->Out_Of_Range_Count,
+                 Stats->Unresolved_Count, Stats->Out_Of_Range_Count);
+
+   Append_Format(Buffer, "\"instructions\": %td, \"mnemonics\": {", Stats->Instruction_Count);
+   for(symbol_id Id = 1; Id <= Histogram->Symbol_Count; ++Id)
+   {
+      Append_Format(Buffer, "%s", (Id > 1) ? ", " : "");
+      Append_Json_String(Buffer, Histogram->Symbols[Id].Name);
+      Append_Format(Buffer, ": %llu", (unsigned long long)Histogram->Symbols[Id].Value);
+   }
+   Append_Format(Buffer, "}");
+}
+
+static void Finish_File_Stats(assembler_context *Context, char *Path, input_file *Input)
+{
+   // NOTE: Called before the context is reset, while its tables are intact.
+   file_stats *Stats = Context->Stats;
+   if(Stats)
+   {
+      symbol_table *Histogram = &Context->Mnemonic_Histogram;
+
+      Stats->Source_Bytes = Input->Contents.Length;
+      Stats->Arena_Peak = Context->Arena.Peak;
+      Stats->Symbol_Count = Context->Symbols.Symbol_Count;
+      Stats->Probe_Distance = Symbol_Probe_Distance(&Context->Symbols);
+      Stats->Relocation_Count = Context->Relocations.Count;
+      Stats->Unresolved_Count = Context->Relocations.Unresolved_Count;
+      Stats->Out_Of_Range_Count = Context->Relocations.Out_Of_Range_Count;
+
+      Append_Format(&Stats->Json, "{\"path\": ");
+      Append_Json_String(&Stats->Json, From_C_String(Path));
+      Append_Format(&Stats->Json, ", ");
+      Append_Stats_Json(&Stats->Json, Stats, Histogram);
+      Append_Format(&Stats->Json, "}");
+
+      pthread_mutex_lock(&Stats_Mutex);
+      for(int Pass = 0; Pass < PASS_COUNT; ++Pass)
+      {
+         Total_Stats.Seconds[Pass] += Stats->Seconds[Pass];
+      }
+      Total_Stats.Source_Bytes += Stats->Source_Bytes;
+      Total_Stats.Line_Count += Stats->Line_Count;
+      Total_Stats.Instruction_Count += Stats->Instruction_Count;
+      Total_Stats.Arena_Peak = (Stats->Arena_Peak > Total_Stats.Arena_Peak) ? Stats->Arena_Peak : Total_Stats.Arena_Peak;
+      Total_Stats.Symbol_Count += Stats->Symbol_Count;
+      Total_Stats.Probe_Distance += Stats->Probe_Distance;
+      Total_Stats.Relocation_Count += Stats->Relocation_Count;
+      Total_Stats.Unresolved_Count += Stats->Unresolved_Count;
+      Total_Stats.Out_Of_Range_Count += Stats->Out_Of_Range_Count;
+
+      if(!Total_Histogram.Arena.Base)
+      {
+         Total_Histogram.Arena = Reserve_Arena(HISTOGRAM_ARENA_SIZE);
+      }
+      for(symbol_id Id = 1; Id <= Histogram->Symbol_Count; ++Id)
+      {
+         symbol *Mnemonic = Histogram->Symbols + Id;
+
+         // NOTE: Names point into this file's source, which is about to be
+         // unmapped, so the total keeps its own copy of new names.
+         u32 Symbol_Count = Total_Histogram.Symbol_Count;
+         symbol_id Total_Id = Intern_Symbol(&Total_Histogram, Mnemonic->Name);
+         if(Total_Histogram.Symbol_Count != Symbol_Count)
+         {
+            string Copy = {Allocate(&Total_Histogram.Arena, u8, Mnemonic->Name.Length), Mnemonic->Name.Length};
+            memcpy(Copy.Data, Mnemonic->Name.Data, Copy.Length);
+            Total_Histogram.Symbols[Total_Id].Name = Copy;
+         }
+         Total_Histogram.Symbols[Total_Id].Value += Mnemonic->Value;
+      }
+      pthread_mutex_unlock(&Stats_Mutex);
+   }
+
+   Reset_Symbol_Table(&Context->Mnemonic_Histogram);
+}
+
+static void Print_Stats(file_stats *Files, int File_Count, double Wall_Seconds)
+{
+   printf("{\n   \"files\": [");
+   for(int File_Index = 0; File_Index < File_Count; ++File_Index)
+   {
+      message_buffer *Json = &Files[File_Index].Json;
+      printf("%s\n      %.*s", (File_Index) ? "," : "", (int)Json->Length, Json->Data ? Json->Data : "{}");
+      free(Json->Data);
+   }
+
+   message_buffer Total = {0};
+   Append_Format(&Total, "{\"wall_seconds\": %.6f, ", Wall_Seconds);
+   Append_Stats_Json(&Total, &Total_Stats, &Total_Histogram);
+   Append_Format(&Total, "}");
+
+   printf("\n   ],\n   \"total\": %.*s\n}\n", (int)Total.Length, Total.Data);
+   free(Total.Data);
+}
@@ -0,0 +1,140 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: With --trace <path>, every thread records complete ("X") events for
+// each file, each pass of Assemble_File and its own lifetime, and they are
+// written once assembly ends in the Chrome trace-event format, which both
+// chrome://tracing and Perfetto load directly. Events are appended to a
+// per-thread buffer without locking, and only registering a thread's buffer
+// takes the mutex. Without --trace no buffer exists and recording an event is
+// a single branch.
+
+typedef struct {
+   char *Name;  // Always a string literal.
+   string Path; // Input paths come from the command line and outlive the run.
+   double Begin;
+   double End;
+} trace_event;
+
+typedef struct trace_buffer trace_buffer;
+struct trace_buffer
+{
+   trace_buffer *Next;
+   char *Thread_Name;
+   int Thread_Id;
+
+   int Event_Count;
+   int Event_Capacity;
+   trace_event *Events;
+};
+
+static pthread_mutex_t Trace_Mutex = PTHREAD_MUTEX_INITIALIZER;
+static trace_buffer *Trace_Buffers;
+static int Trace_Thread_Count;
+static double Trace_Epoch;
+
+static _Thread_local trace_buffer *Trace_Buffer;
+
+static void Begin_Trace_Thread(char *Thread_Name)
+{
+   if(Options.Trace_Path)
+   {
+      trace_buffer *Buffer = calloc(1, sizeof(*Buffer));
+      Buffer->Thread_Name = Thread_Name;
+
+      pthread_mutex_lock(&Trace_Mutex);
+      Buffer->Thread_Id = Trace_Thread_Count++;
+      Buffer->Next = Trace_Buffers;
+      Trace_Buffers = Buffer;
+      pthread_mutex_unlock(&Trace_Mutex);
+
+      Trace_Buffer = Buffer;
+   }
+}
+
+static void End_Trace_Thread(void)
+{
+   // NOTE: The buffer stays on the global list until the trace is written.
+   Trace_Buffer = 0;
+}
+
+static void Trace_Event(char *Name, string Path, double Begin, double End)
+{
+   trace_buffer *Buffer = Trace_Buffer;
+   if(Buffer)
+   {
+      if(Buffer->Event_Count == Buffer->Event_Capacity)
+      {
+         Buffer->Event_Capacity = (Buffer->Event_Capacity) ? (Buffer->Event_Capacity * 2) : 1024;
+         Buffer->Events = realloc(Buffer->Events, Buffer->Event_Capacity * sizeof(*Buffer->Events));
+      }
+
+      trace_event *Event = Buffer->Events + Buffer->Event_Count++;
+      Event->Name = Name;
+      Event->Path = Path;
+      Event->Begin = Begin;
+      Event->End = End;
+   }
+}
+
+static void Record_Pass(assembler_context *Context, assembler_pass Pass, double *Pass_Start)
+{
+   // NOTE: Charges the time since *Pass_Start to a pass and starts the next.
+   double Now = Stats_Clock();
+   if(Context->Stats)
+   {
+      Context->Stats->Seconds[Pass] += Now - *Pass_Start;
+   }
+   Trace_Event(Pass_Names[Pass], Context->Input_File_Path, *Pass_Start, Now);
+   *Pass_Start = Now;
+}
+
+static void Write_Trace(char *Path)
+{
+   // NOTE: Called once every thread has finished, so no locking is needed.
+   message_buffer Json = {0};
+   Append_Format(&Json, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+   bool First = true;
+   for(trace_buffer *Buffer = Trace_Buffers; Buffer; Buffer = Buffer->Next)
+   {
+      Append_Format(&Json, "%s{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %d, "
+                    "\"args\": {\"name\": \"%s %d\"}}", (First) ? "" : ",\n",
+                    Buffer->Thread_Id, Buffer->Thread_Name, Buffer->Thread_Id);
+      First = false;
+
+      for(int Event_Index = 0; Event_Index < Buffer->Event_Count; ++Event_Index)
+      {
+         trace_event *Event = Buffer->Events + Event_Index;
+         Append_Format(&Json, ",\n{\"ph\": \"X\", \"cat\": \"asm\", \"name\": \"%s\", \"pid\": 1, \"tid\": %d, "
+                       "\"ts\": %.3f, \"dur\": %.3f", Event->Name, Buffer->Thread_Id,
+                       (Event->Begin - Trace_Epoch) * 1e6, (Event->End - Event->Begin) * 1e6);
+         if(Event->Path.Length)
+         {
+            Append_Format(&Json, ", \"args\": {\"path\": ");
+            Append_Json_String(&Json, Event->Path);
+            Append_Format(&Json, "}");
+         }
+         Append_Format(&Json, "}");
+      }
+   }
+   Append_Format(&Json, "\n]}\n");
+
+   FILE *File = fopen(Path, "wb");
+   if(!File || fwrite(Json.Data, 1, Json.Length, File) != (size_t)Json.Length)
+   {
+      Report_Error(0, "Failed to write to trace file \"%s\".", Path);
+   }
+   if(File)
+   {
+      fclose(File);
+   }
+   free(Json.Data);
+
+   while(Trace_Buffers)
+   {
+      trace_buffer *Buffer = Trace_Buffers;
+      Trace_Buffers = Buffer->Next;
+      free(Buffer->Events);
+      free(Buffer);
+   }
+}
@@ -0,0 +1,155 @@
+/* (c) copyright 2025 Lawrence D. Kern /////////////////////////////////////// */
+
+// NOTE: With --watch, the assembler stays resident after the first build and
+// reassembles each input file whenever it changes. The architecture tables
+// and the context's arenas are kept, only the changed file is read and
+// tokenized again, and the line cache (see cache.c) replays every line whose
+// text and resolved symbols are unchanged. Only edited lines, and lines that
+// depend on symbols whose values moved, are encoded again. Without --cache,
+// cache entries stay resident in memory.
+//
+// Parent directories are watched rather than the files themselves, since many
+// editors save by writing a new file and renaming it over the old one.
+//
+// SIGINT and SIGTERM end the session normally, which returns true. Status
+// lines go through Print_Message like every other diagnostic.
+
+#define WATCH_SETTLE_MILLISECONDS 20
+
+static volatile sig_atomic_t Watch_Stop_Requested;
+
+static void Request_Watch_Stop(int Signal)
+{
+   (void)Signal;
+   Watch_Stop_Requested = 1;
+}
+
+typedef struct {
+   char *Path;
+   string Name;    // The file name within its directory.
+   int Descriptor; // The watch on its directory.
+   bool Changed;
+} watched_file;
+
+static bool Watch_Files(char **Paths, int Path_Count)
+{
+   int Notify = inotify_init1(IN_CLOEXEC);
+   if(Notify < 0)
+   {
+      Report_Error(0, "Failed to initialize inotify for --watch.");
+      return(false);
+   }
+
+   // NOTE: Without SA_RESTART, a signal interrupts poll below.
+   struct sigaction Stop_Action = {0};
+   Stop_Action.sa_handler = Request_Watch_Stop;
+   sigemptyset(&Stop_Action.sa_mask);
+   sigaction(SIGINT, &Stop_Action, 0);
+   sigaction(SIGTERM, &Stop_Action, 0);
+
+   assembler_context Context;
+   Create_Context(&Context);
+   Thread_Context = &Context;
+
+   watched_file *Files = calloc(Path_Count, sizeof(*Files));
+   for(int Path_Index = 0; Path_Index < Path_Count; ++Path_Index)
+   {
+      watched_file *File = Files + Path_Index;
+      File->Path = Paths[Path_Index];
+
+      // NOTE: Split at the last slash, if any.
+      string Path = From_C_String(File->Path);
+      string Directory = S(".");
+      File->Name = Path;
+      for(index Index = Path.Length; Index > 0; --Index)
+      {
+         if(Path.Data[Index - 1] == '/')
+         {
+            Directory = (string){Path.Data, (Index > 1) ? (Index - 1) : 1};
+            File->Name = (string){Path.Data + Index, Path.Length - Index};
+            break;
+         }
+      }
+
+      // NOTE: Watching a directory twice returns the same descriptor.
+      char *Directory_Path = To_C_String(&Context.Arena, Directory);
+      File->Descriptor = inotify_add_watch(Notify, Directory_Path, IN_CLOSE_WRITE|IN_MOVED_TO);
+      if(File->Descriptor < 0)
+      {
+         Report_Error(0, "Failed to watch directory \"%s\".", Directory_Path);
+      }
+   }
+   Reset_Arena(&Context.Arena);
+
+   Print_Message(&Context, stdout, "Watching %d file%s for changes.\n", Path_Count, (Path_Count == 1) ? "" : "s");
+   fflush(stdout);
+
+   _Alignas(struct inotify_event) char Buffer[4096];
+   bool Result = true;
+   bool Watching = true;
+   while(Watching && !Watch_Stop_Requested)
+   {
+      // NOTE: Block until something changes, then keep reading until events
+      // settle, since a single save can produce several of them.
+      bool Any_Changed = false;
+      int Timeout = -1;
+      struct pollfd Poll = {Notify, POLLIN, 0};
+      while(1)
+      {
+         int Ready = poll(&Poll, 1, Timeout);
+         if(Ready < 0 && errno != EINTR)
+         {
+            Report_Error(0, "Failed to wait for changes to watched files.");
+            Watching = false;
+            Result = false;
+         }
+         if(Ready <= 0)
+         {
+            break;
+         }
+
+         ssize_t Size = read(Notify, Buffer, sizeof(Buffer));
+         for(char *At = Buffer; Size > 0 && At < Buffer + Size;)
+         {
+            struct inotify_event *Event = (struct inotify_event *)At;
+            if(Event->len)
+            {
+               string Name = From_C_String(Event->name);
+               for(int File_Index = 0; File_Index < Path_Count; ++File_Index)
+               {
+                  watched_file *File = Files + File_Index;
+                  if(File->Descriptor == Event->wd && Equals(File->Name, Name))
+                  {
+                     File->Changed = true;
+                     Any_Changed = true;
+                  }
+               }
+            }
+            At += sizeof(struct inotify_event) + Event->len;
+         }
+         Timeout = WATCH_SETTLE_MILLISECONDS;
+      }
+
+      for(int File_Index = 0; Any_Changed && !Watch_Stop_Requested && File_Index < Path_Count; ++File_Index)
+      {
+         watched_file *File = Files + File_Index;
+         if(File->Changed)
+         {
+            File->Changed = false;
+
+            double Start = Stats_Clock();
+            Assemble_File(&Context, File->Path);
+            Print_Message(&Context, stdout, "%s: reassembled in %.2f ms\n", File->Path, (Stats_Clock() - Start) * 1000.0);
+            fflush(stdout);
+         }
+      }
+   }
+
+   free(Files);
+   close(Notify);
+
+   Thread_Context = 0;
+   Destroy_Context(&Context);
+
+   return(Result);
+}